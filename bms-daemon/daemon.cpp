@@ -0,0 +1,200 @@
+#include "daemon.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+
+volatile std::sig_atomic_t Daemon::quitRequested = 0;
+
+Daemon::Daemon(const options_t &options, QObject *parent) : QObject(parent), options(options)
+{
+    can = new Can(this);
+    decoder = new BmsDecoder(this);
+    history = new BmsHistory(decoder, 128 * 1024 * 1024, 600, 86400);
+    eventLog = new EventLog(1 << 20, this);
+    eventLog->set_formatter(&BmsDecoder::describe_event);
+    publisher = new PackPublisher(decoder, this);
+    streamServer = new StreamServer(this);
+    //64k frames cover the pre-trigger window at full bus load for about 10 s
+    recorder = new FlightRecorder(1 << 16, this);
+    QObject::connect(recorder, &FlightRecorder::triggered, this, [=](QString reason) {
+        qInfo().noquote() << "Flight recorder triggered by" << reason;
+    });
+    QObject::connect(recorder, &FlightRecorder::written, this, [=](QString fileName, int count) {
+        qInfo().noquote() << "Flight recorder wrote" << count << "frames to" << fileName;
+    });
+    QObject::connect(recorder, &FlightRecorder::failed, this, [=](QString fileName) {
+        qWarning().noquote() << "Cannot write" << fileName;
+    });
+    sessionLogger = new SessionLogger(decoder, this);
+    QObject::connect(sessionLogger, &SessionLogger::failed, this, [=](QString message) {
+        qWarning().noquote() << message;
+    });
+
+    QObject::connect(can, &Can::new_frame, this, &Daemon::new_frame);
+    QObject::connect(can, &Can::error, this, [=](QString message) {
+        qWarning().noquote() << message;
+    });
+    QObject::connect(can, &Can::progress, this, [=](QString message) {
+        qInfo().noquote() << message;
+    });
+    QObject::connect(can, &Can::device_up, this, [=] {
+        qInfo().noquote() << this->options.device << "up";
+    });
+    QObject::connect(can, &Can::device_down, this, [=] {
+        qInfo().noquote() << this->options.device << "down";
+    });
+    QObject::connect(decoder, &BmsDecoder::decoded, this, [=](quint32 frameId, quint8 stack) {
+        history->record(frameId, stack);
+        sessionLogger->update(frameId, stack);
+    });
+    QObject::connect(streamServer, &StreamServer::clients_changed, this, [=](int count) {
+        qInfo().noquote() << count << "telemetry clients";
+    });
+    QObject::connect(decoder, &BmsDecoder::transition, this, [=](EventLog::source_t source, quint16 code) {
+        log(source, code);
+        recorder->event(source, code);
+    });
+    setup_link_monitor();
+
+    //Same period as the viewer, a complete set of messages is expected within it
+    serviceTimer = new QTimer(this);
+    serviceTimer->setInterval(150);
+    QObject::connect(serviceTimer, &QTimer::timeout, this, &Daemon::service);
+
+    statusTimer = new QTimer(this);
+    statusTimer->setInterval(options.statusInterval * 1000);
+    QObject::connect(statusTimer, &QTimer::timeout, this, &Daemon::report_status);
+}
+
+Daemon::~Daemon()
+{
+    delete history;
+}
+
+void Daemon::start()
+{
+    can->set_device_name(options.device);
+    can->set_link_config(options.bitrate, options.samplePoint, options.dataBitrate);
+    can->connect_device();
+    if (!options.shmName.isEmpty()) {
+        publisher->open(options.shmName);
+    }
+    if (!options.recorderDirectory.isEmpty()) {
+        recorder->set_directory(options.recorderDirectory);
+        recorder->set_device_name(options.device);
+        recorder->set_windows(options.preTrigger, options.postTrigger);
+    }
+    if (!options.sessionFile.isEmpty()) {
+        sessionLogger->start(options.sessionFile, SessionLogger::format_for(options.sessionFile), options.sessionInterval);
+    }
+    if (options.streamPort != 0) {
+        if (streamServer->listen(options.streamPort)) {
+            qInfo().noquote() << "Serving telemetry on port" << options.streamPort;
+        } else {
+            qWarning().noquote() << "Cannot serve telemetry:" << streamServer->errorString();
+        }
+    }
+
+    statusPeriod.start();
+    serviceTimer->start();
+    if (options.statusInterval > 0) {
+        statusTimer->start();
+    }
+}
+
+void Daemon::request_quit(int signal)
+{
+    Q_UNUSED(signal);
+    quitRequested = 1;
+}
+
+void Daemon::setup_link_monitor()
+{
+    LinkMonitor *monitor = can->link_monitor();
+    QObject::connect(monitor, &LinkMonitor::health_changed, this, [=](int health, qint64 duration) {
+        log(EventLog::SOURCE_CAN_BUS, health, duration);
+    });
+    QObject::connect(monitor, &LinkMonitor::restart_link, this, [=](int attempt) {
+        log(EventLog::SOURCE_CAN_RECOVERY, LinkMonitor::RECOVERY_ATTEMPT, attempt);
+    });
+    QObject::connect(monitor, &LinkMonitor::recovered, this, [=](qint64 outage) {
+        log(EventLog::SOURCE_CAN_RECOVERY, LinkMonitor::RECOVERY_DONE, outage);
+    });
+}
+
+void Daemon::new_frame(QCanBusFrame frame)
+{
+    frames++;
+    recorder->record(frame);
+    decoder->decode(frame);
+    streamServer->add_frame(frame);
+}
+
+void Daemon::log(EventLog::source_t source, quint16 code, qint32 value)
+{
+    eventLog->log(source, code, value);
+
+    EventLog::event_t event;
+    event.timestamp = QDateTime::currentMSecsSinceEpoch();
+    event.source = source;
+    event.code = code;
+    event.value = value;
+    qInfo().noquote() << BmsDecoder::describe_event(event);
+}
+
+void Daemon::service()
+{
+    if (quitRequested) {
+        shutdown();
+        return;
+    }
+
+    bool linkAvailable = decoder->take_link_available();
+    if (linkAvailable != lastLinkAvailable) {
+        log(EventLog::SOURCE_LINK, linkAvailable);
+    }
+    lastLinkAvailable = linkAvailable;
+
+    //Same snapshot semantic as the viewer, stacks which stopped sending read as 0
+    publisher->publish();
+    decoder->clear_measurements();
+}
+
+void Daemon::report_status()
+{
+    const BmsDecoder::bms_info_t &info = decoder->info();
+    double rate = (frames - framesReported) * 1000.0 / qMax<qint64>(1, statusPeriod.restart());
+    framesReported = frames;
+
+    qInfo().noquote() << QString("%1 frames/s | %2 | Cells %3..%4 V | %5 A | %6 V | %7..%8 °C | History %9 MiB")
+                         .arg(rate, 0, 'f', 0)
+                         .arg(BmsDecoder::ts_state_to_string(info.tsState))
+                         .arg(info.minCellVolt, 0, 'f', 3).arg(info.maxCellVolt, 0, 'f', 3)
+                         .arg(info.current, 0, 'f', 2).arg(info.batteryVoltage, 0, 'f', 1)
+                         .arg(info.minTemp, 0, 'f', 1).arg(info.maxTemp, 0, 'f', 1)
+                         .arg(history->store().memory_usage() / (1024.0 * 1024.0), 0, 'f', 1);
+    save_events();
+}
+
+void Daemon::save_events()
+{
+    if (options.eventFile.isEmpty()) {
+        return;
+    }
+    eventLog->flush();
+    if (!eventLog->export_csv(options.eventFile)) {
+        qWarning().noquote() << "Cannot write" << options.eventFile;
+    }
+}
+
+void Daemon::shutdown()
+{
+    serviceTimer->stop();
+    statusTimer->stop();
+    can->disconnect_device();
+    streamServer->close();
+    recorder->stop();
+    sessionLogger->stop();
+    save_events();
+    QCoreApplication::quit();
+}
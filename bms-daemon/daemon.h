@@ -0,0 +1,76 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <csignal>
+#include "can.h"
+#include "bmsdecoder.h"
+#include "bmshistory.h"
+#include "packpublisher.h"
+#include "streamserver.h"
+#include "flightrecorder.h"
+#include "sessionlogger.h"
+#include "eventlog.h"
+
+//Headless telemetry node. Brings the CAN link up, decodes every frame at full rate into the
+//pack history and records the events, without a display. The event log is written to a CSV
+//file with every status report and on exit.
+class Daemon : public QObject
+{
+    Q_OBJECT
+public:
+    struct options_t {
+        QString device;
+        quint32 bitrate;
+        quint16 samplePoint; //Permille
+        quint32 dataBitrate; //0 for classic CAN
+        QString eventFile;
+        int statusInterval;  //s
+        QString shmName;     //Empty to disable
+        quint16 streamPort;  //0 to disable
+        QString recorderDirectory; //Empty to disable
+        int preTrigger;      //ms
+        int postTrigger;     //ms
+        QString sessionFile; //Empty to disable
+        int sessionInterval; //ms
+    };
+
+    explicit Daemon(const options_t &options, QObject *parent = nullptr);
+    ~Daemon();
+
+    void start();
+
+    //Async signal safe, the daemon shuts down from the event loop
+    static void request_quit(int signal);
+
+private:
+    options_t options;
+    Can *can = nullptr;
+    BmsDecoder *decoder = nullptr;
+    BmsHistory *history = nullptr;
+    EventLog *eventLog = nullptr;
+    PackPublisher *publisher = nullptr;
+    StreamServer *streamServer = nullptr;
+    FlightRecorder *recorder = nullptr;
+    SessionLogger *sessionLogger = nullptr;
+    QTimer *serviceTimer = nullptr;
+    QTimer *statusTimer = nullptr;
+    QElapsedTimer statusPeriod;
+    quint64 frames = 0;
+    quint64 framesReported = 0;
+    bool lastLinkAvailable = false;
+
+    static volatile std::sig_atomic_t quitRequested;
+
+    void setup_link_monitor();
+    void new_frame(QCanBusFrame frame);
+    void log(EventLog::source_t source, quint16 code, qint32 value = 0);
+    void service();
+    void report_status();
+    void save_events();
+    void shutdown();
+};
+
+#endif // DAEMON_H
@@ -0,0 +1,61 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <csignal>
+#include "daemon.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setOrganizationName("Scuderia Mensa");
+    a.setApplicationName("spr21e-bms-daemon");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless BMS telemetry node");
+    parser.addHelpOption();
+    QCommandLineOption deviceOption({"d", "device"}, "CAN interface.", "name", "can0");
+    QCommandLineOption bitrateOption({"b", "bitrate"}, "Nominal bitrate in bit/s.", "bitrate", "1000000");
+    QCommandLineOption samplePointOption({"s", "sample-point"}, "Sample point in percent.", "percent", "87.5");
+    QCommandLineOption dataBitrateOption({"f", "data-bitrate"}, "CAN FD data bitrate in bit/s, 0 for classic CAN.", "bitrate", "0");
+    QCommandLineOption eventOption({"e", "events"}, "Write the event log to this CSV file.", "file");
+    QCommandLineOption statusOption({"i", "status-interval"}, "Seconds between status reports, 0 to disable.", "seconds", "10");
+    QCommandLineOption shmOption({"m", "shm"}, "Name of the shared memory segment with the pack state.", "name", PACKSHM_NAME);
+    QCommandLineOption noShmOption("no-shm", "Do not publish the pack state to shared memory.");
+    QCommandLineOption recorderOption({"r", "recorder"}, "Write the frames around every BMS fault to this directory.", "directory");
+    QCommandLineOption preTriggerOption("pre-trigger", "Seconds recorded before a fault.", "seconds", "10");
+    QCommandLineOption postTriggerOption("post-trigger", "Seconds recorded after a fault.", "seconds", "5");
+    QCommandLineOption sessionOption({"l", "log"}, "Record the session in the logging format of the BMU, binary if the name ends in .bin.", "file");
+    QCommandLineOption sessionIntervalOption("log-interval", "Milliseconds between two log records.", "ms", "100");
+    QCommandLineOption streamOption({"t", "stream"}, "Serve the frames to remote viewers on this TCP port, 0 to disable.", "port", "0");
+    parser.addOptions({deviceOption, bitrateOption, samplePointOption, dataBitrateOption, eventOption, statusOption,
+                       shmOption, noShmOption, streamOption, recorderOption, preTriggerOption, postTriggerOption,
+                       sessionOption, sessionIntervalOption});
+    parser.process(a);
+
+    Daemon::options_t options;
+    options.device = parser.value(deviceOption);
+    options.bitrate = parser.value(bitrateOption).toUInt();
+    options.samplePoint = qRound(parser.value(samplePointOption).toDouble() * 10.0);
+    options.dataBitrate = parser.value(dataBitrateOption).toUInt();
+    options.eventFile = parser.value(eventOption);
+    options.statusInterval = parser.value(statusOption).toInt();
+    options.shmName = parser.isSet(noShmOption) ? QString() : parser.value(shmOption);
+    options.streamPort = parser.value(streamOption).toUShort();
+    options.recorderDirectory = parser.value(recorderOption);
+    options.sessionFile = parser.value(sessionOption);
+    options.sessionInterval = parser.value(sessionIntervalOption).toInt();
+    options.preTrigger = qRound(parser.value(preTriggerOption).toDouble() * 1000.0);
+    options.postTrigger = qRound(parser.value(postTriggerOption).toDouble() * 1000.0);
+    if ((options.bitrate == 0) || (options.samplePoint == 0) || (options.samplePoint >= 1000)) {
+        qCritical() << "Invalid bit timing";
+        return 1;
+    }
+
+    std::signal(SIGINT, Daemon::request_quit);
+    std::signal(SIGTERM, Daemon::request_quit);
+
+    Daemon daemon(options);
+    daemon.start();
+
+    return a.exec();
+}
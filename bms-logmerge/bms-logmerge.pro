@@ -0,0 +1,21 @@
+QT -= gui
+QT += network serialbus
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+include(../bmscore/bmscore.pri)
+
+SOURCES += \
+        logsource.cpp \
+        main.cpp \
+        offsetestimator.cpp
+
+HEADERS += \
+        logsource.h \
+        offsetestimator.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
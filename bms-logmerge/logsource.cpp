@@ -0,0 +1,152 @@
+#include "logsource.h"
+#include <QDateTime>
+#include <cstring>
+
+LogSource::type_t LogSource::detect(QString fileName)
+{
+    if (fileName.endsWith(".bin", Qt::CaseInsensitive)) {
+        return TYPE_BMU_BINARY;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return TYPE_UNKNOWN;
+    }
+    //Both formats are usually named .log, candump lines start with the timestamp
+    char first;
+    if (!file.getChar(&first)) {
+        return TYPE_UNKNOWN;
+    }
+    return (first == '(') ? TYPE_CANDUMP : TYPE_BMU_BASE64;
+}
+
+CandumpSource::CandumpSource(QString fileName)
+{
+    file.setFileName(fileName);
+}
+
+bool CandumpSource::open()
+{
+    return file.open(QIODevice::ReadOnly);
+}
+
+bool CandumpSource::next(entry_t &entry)
+{
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        int close = line.indexOf(')');
+        int dot = line.indexOf('.');
+        if (!line.startsWith('(') || (close < 0) || (dot < 0) || (dot > close) || (close + 2 > line.size())) {
+            skippedLines++;
+            continue;
+        }
+
+        bool secondsOk;
+        bool fractionOk;
+        qint64 seconds = line.mid(1, dot - 1).toLongLong(&secondsOk);
+        QByteArray fraction = line.mid(dot + 1, close - dot - 1).leftJustified(6, '0', true);
+        qint64 microseconds = fraction.toLongLong(&fractionOk);
+        if (!secondsOk || !fractionOk) {
+            skippedLines++;
+            continue;
+        }
+        entry.time = seconds * 1000000LL + microseconds;
+        entry.text = line.mid(close + 2);
+        entry.hasCurrent = false;
+
+        //interface id#data, only the pack current is decoded
+        int space = entry.text.indexOf(' ');
+        int hash = entry.text.indexOf('#');
+        if ((space > 0) && (hash > space)) {
+            bool idOk;
+            quint32 id = entry.text.mid(space + 1, hash - space - 1).toUInt(&idOk, 16);
+            if (idOk && (id == BmsDecoder::ID_BMS_INFO_2) && (entry.text.indexOf("##") < 0)) {
+                QCanBusFrame frame(id, QByteArray::fromHex(entry.text.mid(hash + 1)));
+                if (frame.payload().size() >= 7) {
+                    decoder.decode(frame);
+                    entry.hasCurrent = decoder.info().currentValid;
+                    entry.current = decoder.info().current;
+                }
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+BmuLogSource::BmuLogSource(QString fileName, bool binary, QByteArray label, qint64 offset)
+    : binary(binary), label(label), offset(offset)
+{
+    file.setFileName(fileName);
+    group.reserve(maxRecordsPerSecond);
+}
+
+bool BmuLogSource::open()
+{
+    if (!file.open(binary ? QIODevice::ReadOnly : (QIODevice::ReadOnly | QIODevice::Text))) {
+        return false;
+    }
+    haveLookahead = read_record(lookahead, lookaheadSecond);
+    return true;
+}
+
+bool BmuLogSource::next(entry_t &entry)
+{
+    if ((groupPosition >= group.size()) && !fill_group()) {
+        return false;
+    }
+    const logging_data_t &record = group.at(groupPosition);
+    entry.time = groupSecond * 1000000LL + (1000000LL * groupPosition) / group.size() + offset;
+    entry.text = label + ' '
+            + QByteArray::fromRawData((const char *)&record, sizeof(logging_data_t)).toBase64();
+    entry.hasCurrent = true;
+    entry.current = record.current;
+    groupPosition++;
+    return true;
+}
+
+bool BmuLogSource::read_record(logging_data_t &record, qint64 &second)
+{
+    while (!file.atEnd()) {
+        if (binary) {
+            if (file.read((char *)&record, sizeof(logging_data_t)) != sizeof(logging_data_t)) {
+                return false;
+            }
+        } else {
+            QByteArray raw = QByteArray::fromBase64(file.readLine().trimmed());
+            if (raw.size() != sizeof(logging_data_t)) {
+                skippedLines++;
+                continue;
+            }
+            ::memcpy(&record, raw.constData(), sizeof(logging_data_t));
+        }
+
+        //The BMU uses local time for its RTC
+        QDateTime time(QDate(record.timestamp.year, record.timestamp.month, record.timestamp.day),
+                       QTime(record.timestamp.hour, record.timestamp.minute, record.timestamp.second));
+        if (!time.isValid()) {
+            skippedLines++;
+            continue;
+        }
+        second = time.toSecsSinceEpoch();
+        return true;
+    }
+    return false;
+}
+
+bool BmuLogSource::fill_group()
+{
+    group.clear();
+    groupPosition = 0;
+    if (!haveLookahead) {
+        return false;
+    }
+    groupSecond = lookaheadSecond;
+    group.append(lookahead);
+    while ((haveLookahead = read_record(lookahead, lookaheadSecond))) {
+        if ((lookaheadSecond != groupSecond) || (group.size() >= maxRecordsPerSecond)) {
+            break;
+        }
+        group.append(lookahead);
+    }
+    return true;
+}
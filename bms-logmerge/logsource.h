@@ -0,0 +1,87 @@
+#ifndef LOGSOURCE_H
+#define LOGSOURCE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "bmsdecoder.h"
+#include "loggingdata.h"
+
+//One time ordered input of the merge, read one entry at a time.
+class LogSource
+{
+public:
+    struct entry_t {
+        qint64 time;     //us since epoch, on the host clock
+        QByteArray text; //Output line without the timestamp
+        bool hasCurrent; //Pack current, used to estimate the clock offset
+        float current;
+    };
+
+    enum type_t {
+        TYPE_BMU_BASE64,
+        TYPE_BMU_BINARY,
+        TYPE_CANDUMP,
+        TYPE_UNKNOWN
+    };
+
+    virtual ~LogSource() {}
+
+    virtual bool open() = 0;
+    //False at the end of the input
+    virtual bool next(entry_t &entry) = 0;
+
+    QString file_name() const { return file.fileName(); }
+    quint64 skipped() const { return skippedLines; }
+
+    static type_t detect(QString fileName);
+
+protected:
+    QFile file;
+    quint64 skippedLines = 0;
+};
+
+//Host capture in candump log format: (seconds.microseconds) interface id#data
+class CandumpSource : public LogSource
+{
+public:
+    explicit CandumpSource(QString fileName);
+
+    bool open() override;
+    bool next(entry_t &entry) override;
+
+private:
+    BmsDecoder decoder;
+};
+
+//SD card log of the BMU or a host session recording, base64 lines or binary records.
+//The RTC only has whole seconds, the records of one second are spread evenly over it.
+//Reads ahead by one second of records.
+class BmuLogSource : public LogSource
+{
+public:
+    BmuLogSource(QString fileName, bool binary, QByteArray label, qint64 offset = 0);
+
+    bool open() override;
+    bool next(entry_t &entry) override;
+
+private:
+    static const int maxRecordsPerSecond = 1000;
+
+    bool binary;
+    QByteArray label;
+    qint64 offset; //us added to the RTC time
+
+    QVector<logging_data_t> group;
+    qint64 groupSecond = 0;
+    int groupPosition = 0;
+    logging_data_t lookahead;
+    qint64 lookaheadSecond = 0;
+    bool haveLookahead = false;
+
+    bool read_record(logging_data_t &record, qint64 &second);
+    bool fill_group();
+};
+
+#endif // LOGSOURCE_H
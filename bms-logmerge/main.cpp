@@ -0,0 +1,195 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QFile>
+#include <memory>
+#include <queue>
+#include <vector>
+#include "logsource.h"
+#include "offsetestimator.h"
+
+//Merges BMU logs and host CAN captures into one time ordered candump style log.
+//Every input is streamed, memory does not depend on the size of the inputs.
+//BMU records are written as: (seconds.microseconds) bmuN base64 record
+
+namespace {
+
+struct input_t {
+    QString fileName;
+    LogSource::type_t type;
+    qint64 offset; //us
+    QByteArray label;
+};
+
+std::unique_ptr<LogSource> make_source(const input_t &input)
+{
+    if (input.type == LogSource::TYPE_CANDUMP) {
+        return std::unique_ptr<LogSource>(new CandumpSource(input.fileName));
+    }
+    return std::unique_ptr<LogSource>(new BmuLogSource(input.fileName, input.type == LogSource::TYPE_BMU_BINARY,
+                                                       input.label, input.offset));
+}
+
+//Pass over the host captures and every BMU log, the offset of each log is estimated on its own
+bool estimate_offsets(QVector<input_t> &inputs, qint64 maxOffset)
+{
+    OffsetEstimator estimator;
+    LogSource::entry_t entry;
+    bool haveReference = false;
+    for (const input_t &input : qAsConst(inputs)) {
+        if (input.type != LogSource::TYPE_CANDUMP) {
+            continue;
+        }
+        std::unique_ptr<LogSource> source = make_source(input);
+        if (!source->open()) {
+            qCritical().noquote() << "Cannot open" << input.fileName;
+            return false;
+        }
+        while (source->next(entry)) {
+            if (entry.hasCurrent) {
+                estimator.add_reference(entry.time, entry.current);
+                haveReference = true;
+            }
+        }
+    }
+    if (!haveReference) {
+        qWarning() << "No pack current in the host captures, the clocks are not aligned";
+        return true;
+    }
+
+    for (input_t &input : inputs) {
+        if (input.type == LogSource::TYPE_CANDUMP) {
+            continue;
+        }
+        std::unique_ptr<LogSource> source = make_source(input);
+        if (!source->open()) {
+            qCritical().noquote() << "Cannot open" << input.fileName;
+            return false;
+        }
+        estimator.clear_samples();
+        while (source->next(entry)) {
+            estimator.add_sample(entry.time, entry.current);
+        }
+
+        OffsetEstimator::result_t result;
+        if (!estimator.estimate(maxOffset, result)) {
+            qWarning().noquote() << input.fileName << "does not overlap the host captures, not aligned";
+            continue;
+        }
+        input.offset = result.offset;
+        qInfo().noquote() << QString("%1: offset %2 s, correlation %3 over %4 s")
+                             .arg(input.fileName).arg(result.offset / 1e6, 0, 'f', 1)
+                             .arg(result.correlation, 0, 'f', 3).arg(result.overlap / 10.0, 0, 'f', 1);
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setOrganizationName("Scuderia Mensa");
+    a.setApplicationName("bms-logmerge");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Merges BMU logs and host CAN captures (candump log format) into one time ordered log.\n"
+                                     "The clock offset of every BMU log is estimated from the pack current.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("inputs", "BMU logs (.log, .bin) and candump logs.", "inputs...");
+    QCommandLineOption outputOption({"o", "output"}, "Output file, standard output if not set.", "file");
+    QCommandLineOption offsetOption("offset", "Fixed offset of the BMU logs to the host clock instead of the estimate.", "seconds");
+    QCommandLineOption maxOffsetOption("max-offset", "Largest offset searched by the estimate.", "seconds", "7200");
+    parser.addOptions({outputOption, offsetOption, maxOffsetOption});
+    parser.process(a);
+
+    const QStringList fileNames = parser.positionalArguments();
+    if (fileNames.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    QVector<input_t> inputs;
+    int bmuCount = 0;
+    for (const QString &fileName : fileNames) {
+        input_t input;
+        input.fileName = fileName;
+        input.type = LogSource::detect(fileName);
+        input.offset = 0;
+        if (input.type == LogSource::TYPE_UNKNOWN) {
+            qCritical().noquote() << "Cannot read" << fileName;
+            return 1;
+        }
+        if (input.type != LogSource::TYPE_CANDUMP) {
+            input.label = "bmu" + QByteArray::number(bmuCount++);
+        }
+        inputs.append(input);
+    }
+
+    if (parser.isSet(offsetOption)) {
+        qint64 offset = qRound64(parser.value(offsetOption).toDouble() * 1e6);
+        for (input_t &input : inputs) {
+            input.offset = offset;
+        }
+    } else if ((bmuCount > 0) && !estimate_offsets(inputs, qRound64(parser.value(maxOffsetOption).toDouble() * 1e6))) {
+        return 1;
+    }
+
+    QFile output;
+    bool opened;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        opened = output.open(QIODevice::WriteOnly);
+    } else {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        qCritical().noquote() << "Cannot write" << parser.value(outputOption);
+        return 1;
+    }
+
+    //k-way merge, one pending entry per input
+    std::vector<std::unique_ptr<LogSource>> sources;
+    std::vector<LogSource::entry_t> heads(inputs.size());
+    std::vector<qint64> last(inputs.size(), 0);
+    typedef std::pair<qint64, int> merge_key_t;
+    std::priority_queue<merge_key_t, std::vector<merge_key_t>, std::greater<merge_key_t>> queue;
+    for (int i = 0; i < inputs.size(); i++) {
+        sources.push_back(make_source(inputs.at(i)));
+        if (!sources.back()->open()) {
+            qCritical().noquote() << "Cannot open" << inputs.at(i).fileName;
+            return 1;
+        }
+        if (sources.back()->next(heads[i])) {
+            last[i] = heads[i].time;
+            queue.push({heads[i].time, i});
+        }
+    }
+
+    quint64 lines = 0;
+    QByteArray line;
+    while (!queue.empty()) {
+        int i = queue.top().second;
+        queue.pop();
+        const LogSource::entry_t &entry = heads[i];
+        line = '(' + QByteArray::number(entry.time / 1000000) + '.'
+                + QByteArray::number(entry.time % 1000000).rightJustified(6, '0') + ") " + entry.text + '\n';
+        output.write(line);
+        lines++;
+
+        if (sources[i]->next(heads[i])) {
+            //An input which goes back in time is clamped, the output stays ordered
+            last[i] = qMax(last[i], heads[i].time);
+            heads[i].time = last[i];
+            queue.push({heads[i].time, i});
+        }
+    }
+    output.close();
+
+    for (const std::unique_ptr<LogSource> &source : sources) {
+        if (source->skipped()) {
+            qWarning().noquote() << source->file_name() << ":" << source->skipped() << "unreadable lines skipped";
+        }
+    }
+    qInfo().noquote() << lines << "lines merged";
+    return 0;
+}
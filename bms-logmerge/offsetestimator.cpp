@@ -0,0 +1,101 @@
+#include "offsetestimator.h"
+#include <QtMath>
+
+void OffsetEstimator::add_reference(qint64 time, float value)
+{
+    bin_t &fine = referenceFine[bin_index(time, fineBin)];
+    fine.sum += value;
+    fine.count++;
+    bin_t &coarse = referenceCoarse[bin_index(time, coarseBin)];
+    coarse.sum += value;
+    coarse.count++;
+}
+
+void OffsetEstimator::add_sample(qint64 time, float value)
+{
+    bin_t &fine = samplesFine[bin_index(time, fineBin)];
+    fine.sum += value;
+    fine.count++;
+    bin_t &coarse = samplesCoarse[bin_index(time, coarseBin)];
+    coarse.sum += value;
+    coarse.count++;
+}
+
+void OffsetEstimator::clear_samples()
+{
+    samplesFine.clear();
+    samplesCoarse.clear();
+}
+
+bool OffsetEstimator::estimate(qint64 maxOffset, result_t &result) const
+{
+    qint64 coarseRange = maxOffset / coarseBin;
+    double best = -2.0;
+    qint64 bestShift = 0;
+    for (qint64 shift = -coarseRange; shift <= coarseRange; shift++) {
+        double correlation;
+        int overlap;
+        if (correlate(samplesCoarse, referenceCoarse, shift, correlation, overlap) && (correlation > best)) {
+            best = correlation;
+            bestShift = shift;
+        }
+    }
+    if (best < -1.0) {
+        return false;
+    }
+
+    //Refine within one coarse bin around the best match
+    qint64 center = bestShift * (coarseBin / fineBin);
+    qint64 fineRange = coarseBin / fineBin;
+    best = -2.0;
+    for (qint64 shift = center - fineRange; shift <= center + fineRange; shift++) {
+        double correlation;
+        int overlap;
+        if (correlate(samplesFine, referenceFine, shift, correlation, overlap) && (correlation > best)) {
+            best = correlation;
+            result.offset = shift * fineBin;
+            result.correlation = correlation;
+            result.overlap = overlap;
+        }
+    }
+    return best >= -1.0;
+}
+
+qint64 OffsetEstimator::bin_index(qint64 time, qint64 width)
+{
+    //Rounds down for negative times as well
+    return (time >= 0) ? (time / width) : ((time - width + 1) / width);
+}
+
+//Pearson correlation of the samples shifted by shift bins against the reference
+bool OffsetEstimator::correlate(const QHash<qint64, bin_t> &samples, const QHash<qint64, bin_t> &reference,
+                                qint64 shift, double &correlation, int &overlap)
+{
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumYY = 0.0, sumXY = 0.0;
+    overlap = 0;
+    for (auto it = samples.constBegin(); it != samples.constEnd(); ++it) {
+        auto match = reference.constFind(it.key() + shift);
+        if (match == reference.constEnd()) {
+            continue;
+        }
+        double x = it->sum / it->count;
+        double y = match->sum / match->count;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumYY += y * y;
+        sumXY += x * y;
+        overlap++;
+    }
+    if (overlap < minOverlap) {
+        return false;
+    }
+    double covariance = sumXY - sumX * sumY / overlap;
+    double varianceX = sumXX - sumX * sumX / overlap;
+    double varianceY = sumYY - sumY * sumY / overlap;
+    if ((varianceX <= 0.0) || (varianceY <= 0.0)) {
+        return false;
+    }
+    correlation = covariance / qSqrt(varianceX * varianceY);
+    return true;
+}
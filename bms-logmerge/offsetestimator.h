@@ -0,0 +1,46 @@
+#ifndef OFFSETESTIMATOR_H
+#define OFFSETESTIMATOR_H
+
+#include <QHash>
+#include <QVector>
+
+//Estimates the offset between the clock of a log and the host clock from one signal in both,
+//the pack current. The signals are averaged into bins, the offset with the highest correlation
+//is searched in 1 s steps over the whole range, then refined in 100 ms steps.
+//Memory grows with the duration of the logs, not with their size.
+class OffsetEstimator
+{
+public:
+    struct result_t {
+        qint64 offset;      //us to add to the log time
+        double correlation;
+        int overlap;        //Fine bins compared
+    };
+
+    void add_reference(qint64 time, float value);
+    void add_sample(qint64 time, float value);
+    void clear_samples();
+
+    bool estimate(qint64 maxOffset, result_t &result) const;
+
+private:
+    static const qint64 fineBin = 100000;   //us
+    static const qint64 coarseBin = 1000000;
+    static const int minOverlap = 30;       //Bins
+
+    struct bin_t {
+        double sum = 0.0;
+        int count = 0;
+    };
+
+    QHash<qint64, bin_t> referenceFine;
+    QHash<qint64, bin_t> referenceCoarse;
+    QHash<qint64, bin_t> samplesFine;
+    QHash<qint64, bin_t> samplesCoarse;
+
+    static qint64 bin_index(qint64 time, qint64 width);
+    static bool correlate(const QHash<qint64, bin_t> &samples, const QHash<qint64, bin_t> &reference,
+                          qint64 shift, double &correlation, int &overlap);
+};
+
+#endif // OFFSETESTIMATOR_H
@@ -8,7 +8,11 @@ CONFIG -= app_bundle
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+INCLUDEPATH += ../common
+
 SOURCES += \
+        ../common/canlink.cpp \
+        ../common/ipcprotocol.cpp \
         helper.cpp \
         main.cpp
 
@@ -18,4 +22,6 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
+    ../common/canlink.h \
+    ../common/ipcprotocol.h \
     helper.h
@@ -1,6 +1,6 @@
 #include "helper.h"
-
-const QString Helper::bitrate = "1000000";
+#include <cstring>
+#include <linux/can/netlink.h>
 
 Helper::Helper(QObject *parent) : QObject(parent)
 {
@@ -17,117 +17,214 @@ Helper::~Helper()
 
 void Helper::setup_server()
 {
-    // Connect to the IPC server opened by the main software
-    socket = new QLocalSocket();
+    // Connect to the IPC servers opened by the main software.
+    // Commands and heartbeats use separate connections.
+    socket = new QLocalSocket(this);
     QObject::connect(socket, &QLocalSocket::readyRead, this, &Helper::ready_read);
     QObject::connect(socket, &QLocalSocket::errorOccurred, this, &Helper::handle_error);
-    socket->connectToServer("spr_bms_viewer_helper", QLocalSocket::ReadWrite);
-    socket->write("server running");
+    socket->connectToServer(ipcServerName, QLocalSocket::ReadWrite);
+
+    heartbeatSocket = new QLocalSocket(this);
+    QObject::connect(heartbeatSocket, &QLocalSocket::readyRead, this, &Helper::heartbeat_received);
+    QObject::connect(heartbeatSocket, &QLocalSocket::errorOccurred, this, &Helper::handle_error);
+    heartbeatSocket->connectToServer(ipcHeartbeatServerName, QLocalSocket::ReadWrite);
+
+    socket->write(ipc_encode(0, IPC_HELLO, IPC_SUCCESS));
     qDebug() << "Server is running!";
     timeout->start();
 }
 
 void Helper::ready_read()
 {
-    if (socket == nullptr) {
-        return;
+    decoder.append(socket->readAll());
+    ipc_message_t request;
+    while (decoder.next(request)) {
+        if (request.status == IPC_REQUEST) {
+            requests.enqueue(request);
+        }
+    }
+    if (decoder.error()) {
+        qDebug() << "Invalid message, shutting down";
+        shutdown();
     }
+    execute_next();
+}
 
-    QByteArray raw = socket->readAll();
-    QString data(raw);
-
-    timeout->start(); //Restart the timer
-
-    if (data == "pcan init driver") {
-        qDebug() << "Loading PCAN driver...";
-        load_driver();
-    } else if (data.mid(0, 7) == "pcan up") {
-        QString pcan = data.mid(8, 4); //canx
-        qDebug() << "Bringing " << pcan << "up...";
-        canDevice = pcan;
-        bring_pcan_up();
-    } else if (data.mid(0, 9) == "pcan down") {
-        QString pcan = data.mid(10, 4); //canx
-        qDebug() << "Bringing device down...";
-        canDevice = pcan; //TODO: Could be removed, can device should not change in one session
-        bring_pcan_down();
-    } else if (data.mid(0, 4) == "kill") {
-        QString pcan = data.mid(5, 4); //canx
-        canDevice = pcan; //TODO: Could be removed, can device should not change in one session
-        bring_pcan_down();
-        exit(EXIT_SUCCESS);
-    } else if (data == "heartbeat") {
-        qDebug() << "heartbeat";
-        timeout->start();
+void Helper::heartbeat_received()
+{
+    heartbeatDecoder.append(heartbeatSocket->readAll());
+    ipc_message_t heartbeat;
+    while (heartbeatDecoder.next(heartbeat)) {
+        if (heartbeat.type == IPC_HEARTBEAT) {
+            timeout->start(); //Restart the timer
+            heartbeatSocket->write(ipc_encode(heartbeat.id, IPC_HEARTBEAT, IPC_SUCCESS));
+        }
+    }
+    if (heartbeatDecoder.error()) {
+        shutdown();
     }
 }
 
-void Helper::load_driver()
+void Helper::execute_next()
 {
-    QProcess *initPcan = new QProcess(this);
-
-    QObject::connect(initPcan, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
-        Q_UNUSED(exitStatus)
-        if (exitCode == 0) {
-            send_response("pcan init driver success");
-        } else {
-            send_response("pcan init driver failed");
+    //netlink requests complete immediately, only process requests keep the queue busy
+    while (!busy && !requests.isEmpty()) {
+        ipc_message_t request = requests.dequeue();
+        QString device = QString::fromLocal8Bit(request.payload);
+
+        switch (request.type) {
+        case IPC_LOAD_DRIVER:
+            qDebug() << "Loading PCAN driver...";
+            run(request, "modprobe", QStringList({"pcan"}));
+            break;
+        case IPC_LINK_UP:
+            link_up(request);
+            break;
+        case IPC_LINK_DOWN:
+            qDebug() << "Bringing " << device << "down...";
+            link_down(request, device);
+            break;
+        case IPC_LINK_STATE:
+            link_state(request, device);
+            break;
+        case IPC_LINK_RESTART:
+            link_restart(request);
+            break;
+        case IPC_SHUTDOWN:
+            if (!device.isEmpty()) {
+                canDevice = device;
+            }
+            shutdown();
+            break;
+        default:
+            send_response(request, IPC_FAILED, "Unknown request");
+            break;
         }
-        initPcan->deleteLater();
-    });
-    initPcan->start("modprobe", QStringList({"pcan"})); //Requires root
+    }
 }
 
-void Helper::bring_pcan_up()
+void Helper::run(const ipc_message_t &request, QString program, QStringList arguments)
 {
-    QProcess *process = new QProcess();
+    busy = true;
+    QProcess *process = new QProcess(this);
 
     QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
-        Q_UNUSED(exitStatus)
-        if (exitCode == 0) {
-            send_response("pcan up success");
-        } else {
-            send_response("pcan up failed");
-        }
+        bool success = (exitStatus == QProcess::NormalExit) && (exitCode == 0);
+        send_response(request, success ? IPC_SUCCESS : IPC_FAILED, success ? QByteArray() : process->readAllStandardError());
         process->deleteLater();
+        busy = false;
+        execute_next();
+    });
+    QObject::connect(process, &QProcess::errorOccurred, this, [=](QProcess::ProcessError processError) {
+        if (processError == QProcess::FailedToStart) {
+            send_response(request, IPC_FAILED, QString("%1 not found").arg(program).toLocal8Bit());
+            process->deleteLater();
+            busy = false;
+            execute_next();
+        }
     });
 
-    process->start("ip", QStringList({"link", "set", canDevice, "up", "type", "can", "bitrate", bitrate, "restart-ms", "100"})); //Requires root
+    process->start(program, arguments); //Requires root
 }
 
-void Helper::bring_pcan_down()
+void Helper::link_up(const ipc_message_t &request)
 {
-    QProcess *process = new QProcess();
+    QString device;
+    can_link_config_t config;
+    if (!ipc_decode_link_config(request.payload, device, config)) {
+        send_response(request, IPC_FAILED, "Invalid link configuration");
+        return;
+    }
+    qDebug() << "Bringing " << device << "up at" << config.bitrate << "bit/s...";
+    int error = canlink_bring_up(device.toLocal8Bit().constData(), &config); //Requires root
+    if (error) {
+        send_response(request, IPC_FAILED, ::strerror(-error));
+        return;
+    }
+    canDevice = device;
+    link_state(request, device);
+}
 
-    QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
-        Q_UNUSED(exitStatus)
-        if (exitCode == 0) {
-            send_response("pcan down success");
-        } else {
-            send_response("pcan down failed");
-        }
-        process->deleteLater();
-    });
+void Helper::link_restart(const ipc_message_t &request)
+{
+    QString device;
+    can_link_config_t config;
+    if (!ipc_decode_link_config(request.payload, device, config)) {
+        send_response(request, IPC_FAILED, "Invalid link configuration");
+        return;
+    }
+    QByteArray name = device.toLocal8Bit();
+    can_link_info_t info;
+    if (!canlink_query(name.constData(), &info) || !info.exists) {
+        send_response(request, IPC_FAILED, "No such interface");
+        return;
+    }
+
+    //A bus off controller is restarted, an interface which was down or replugged is configured again
+    int error;
+    if (info.up && (info.state == CAN_STATE_BUS_OFF) && (info.restartMs > 0)) {
+        //The kernel restarts the controller itself and rejects a manual restart
+        send_response(request, IPC_FAILED, "Automatic restart pending");
+        return;
+    } else if (info.up && (info.state == CAN_STATE_BUS_OFF)) {
+        qDebug() << "Restarting " << device << "after bus off...";
+        error = canlink_restart(name.constData());
+    } else {
+        qDebug() << "Bringing " << device << "up again...";
+        error = canlink_bring_up(name.constData(), &config);
+    }
+    if (error) {
+        send_response(request, IPC_FAILED, ::strerror(-error));
+        return;
+    }
+    canDevice = device;
+    link_state(request, device);
+}
+
+void Helper::link_down(const ipc_message_t &request, QString device)
+{
+    int error = canlink_set_up(device.toLocal8Bit().constData(), false); //Requires root
+    if (error) {
+        send_response(request, IPC_FAILED, ::strerror(-error));
+        return;
+    }
+    canDevice.clear();
+    send_response(request, IPC_SUCCESS);
+}
 
-    process->start("ip", QStringList({"link", "set", canDevice, "down"})); //Requires root
+void Helper::link_state(const ipc_message_t &request, QString device)
+{
+    can_link_info_t info;
+    if (!canlink_query(device.toLocal8Bit().constData(), &info) || !info.exists) {
+        send_response(request, IPC_FAILED, "No such interface");
+        return;
+    }
+    send_response(request, IPC_SUCCESS, ipc_encode_link_info(info));
 }
 
-void Helper::send_response(QString resp)
+void Helper::send_response(const ipc_message_t &request, quint8 status, QByteArray payload)
 {
     if (socket) {
-        socket->write(resp.toLocal8Bit());
+        socket->write(ipc_encode(request.id, request.type, status, payload));
     }
 }
 
 void Helper::handle_error(QLocalSocket::LocalSocketError err)
 {
-    Q_UNUSED(err)
-    qDebug() << socket->errorString();
+    qDebug() << "Connection to the viewer lost:" << err;
+    shutdown();
+}
+
+void Helper::shutdown()
+{
+    //The interface has to be down before the helper exits
+    if (!canDevice.isEmpty()) {
+        canlink_set_up(canDevice.toLocal8Bit().constData(), false); //Requires root
+    }
     exit(EXIT_SUCCESS);
 }
 
 void Helper::timeout_reached()
 {
-    bring_pcan_down();
-    exit(EXIT_SUCCESS);
+    shutdown();
 }
@@ -6,6 +6,8 @@
 #include <QLocalSocket>
 #include <QProcess>
 #include <QTimer>
+#include <QQueue>
+#include "ipcprotocol.h"
 
 
 
@@ -20,17 +22,26 @@ public:
 
 private:
 
-    static const QString bitrate;
     QLocalSocket *socket = nullptr;
+    QLocalSocket *heartbeatSocket = nullptr;
+    IpcDecoder decoder;
+    IpcDecoder heartbeatDecoder;
+    QQueue<ipc_message_t> requests; //Executed one after another in order of arrival
+    bool busy = false;
     void ready_read();
-    void load_driver();
-    void bring_pcan_up();
-    void bring_pcan_down();
-    void send_response(QString resp);
+    void heartbeat_received();
+    void execute_next();
+    void run(const ipc_message_t &request, QString program, QStringList arguments);
+    void link_up(const ipc_message_t &request);
+    void link_restart(const ipc_message_t &request);
+    void link_down(const ipc_message_t &request, QString device);
+    void link_state(const ipc_message_t &request, QString device);
+    void send_response(const ipc_message_t &request, quint8 status, QByteArray payload = QByteArray());
     void handle_error(QLocalSocket::LocalSocketError err);
+    void shutdown();
     QTimer *timeout = nullptr;
     void timeout_reached();
-    QString canDevice;
+    QString canDevice; //Interface brought up by the helper
 signals:
 
 };
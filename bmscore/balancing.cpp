@@ -0,0 +1,151 @@
+#include "balancing.h"
+
+Balancing::Balancing(QObject *parent) : QObject(parent)
+{
+    clear();
+    reset_backoff();
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(1000);
+    QObject::connect(pollTimer, &QTimer::timeout, this, &Balancing::poll);
+}
+
+void Balancing::merge_activity(const QByteArray &payload)
+{
+    if (payload.size() < 3) {
+        return;
+    }
+    quint8 stack = (quint8)payload.at(0);
+    if (stack >= numberOfStacks) {
+        return;
+    }
+
+    //Byte 1 holds cells 4 to 11 (LSB first), the upper nibble of byte 2 cells 0 to 3
+    quint16 cells = ((quint16)(quint8)payload.at(1) << 4) | ((quint8)payload.at(2) >> 4);
+    set_stack(stack, cells);
+}
+
+void Balancing::merge_diag_response(const QByteArray &payload)
+{
+    if ((payload.size() < 5) || ((quint8)payload.at(0) != diagGetBalancing)) {
+        return;
+    }
+    quint8 stack = (quint8)payload.at(1);
+    if (stack >= numberOfStacks) {
+        return;
+    }
+
+    //Byte 3 holds cells 0 to 7, the upper nibble of byte 4 cells 8 to 11, MSB first
+    quint16 cells = 0;
+    for (int i = 0; i < 8; i++) {
+        cells |= (((quint8)payload.at(3) >> (7 - i)) & 0x01) << i;
+    }
+    for (int i = 0; i < 4; i++) {
+        cells |= (((quint8)payload.at(4) >> (7 - i)) & 0x01) << (i + 8);
+    }
+    set_stack(stack, cells);
+
+    failures[stack] = 0;
+    holdoff[stack] = 0;
+    if (!answering[stack]) {
+        answering[stack] = true;
+        emit stack_answering(stack, true);
+    }
+}
+
+void Balancing::publish()
+{
+    QVector<quint16> cells;
+    for (int word = 0; word < words; word++) {
+        quint64 diff = bitmap[word] ^ published[word];
+        while (diff) {
+            int bit = qCountTrailingZeroBits(diff);
+            cells.append(word * 64 + bit);
+            diff &= diff - 1;
+        }
+        published[word] = bitmap[word];
+    }
+    if (!cells.isEmpty()) {
+        emit changed(cells);
+    }
+}
+
+void Balancing::clear()
+{
+    ::memset(bitmap, 0, sizeof(bitmap));
+    ::memset(published, 0, sizeof(published));
+}
+
+bool Balancing::is_balancing(int stack, int cell) const
+{
+    int index = stack * cellsPerStack + cell;
+    return (bitmap[index >> 6] >> (index & 63)) & 0x01;
+}
+
+void Balancing::set_poll_interval(int milliseconds)
+{
+    pollTimer->setInterval(milliseconds);
+}
+
+void Balancing::start_polling()
+{
+    //A new connection polls every stack right away, they are assumed to answer
+    reset_backoff();
+    poll();
+    pollTimer->start();
+}
+
+void Balancing::stop_polling()
+{
+    pollTimer->stop();
+}
+
+bool Balancing::request_failed(quint8 command, quint8 stack)
+{
+    if (command != diagGetBalancing) {
+        return false;
+    }
+    if (stack >= numberOfStacks) {
+        return true;
+    }
+    failures[stack]++;
+    holdoff[stack] = (1 << qMin(failures[stack], maxBackoffExponent)) - 1;
+    if (answering[stack]) {
+        answering[stack] = false;
+        emit stack_answering(stack, false);
+    }
+    return true;
+}
+
+void Balancing::set_stack(int stack, quint16 cells)
+{
+    for (int cell = 0; cell < cellsPerStack; cell++) {
+        int index = stack * cellsPerStack + cell;
+        quint64 mask = 1ULL << (index & 63);
+        if ((cells >> cell) & 0x01) {
+            bitmap[index >> 6] |= mask;
+        } else {
+            bitmap[index >> 6] &= ~mask;
+        }
+    }
+}
+
+void Balancing::reset_backoff()
+{
+    for (int stack = 0; stack < numberOfStacks; stack++) {
+        failures[stack] = 0;
+        holdoff[stack] = 0;
+        answering[stack] = true;
+    }
+}
+
+void Balancing::poll()
+{
+    //All stacks are requested at once, the engine keeps them in flight together
+    for (quint8 stack = 0; stack < numberOfStacks; stack++) {
+        if (holdoff[stack] > 0) {
+            holdoff[stack]--;
+            continue;
+        }
+        emit diag_request(diagGetBalancing, stack, QByteArray(1, 0));
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef BALANCING_H
+#define BALANCING_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <QCanBusFrame>
+#include <QtAlgorithms>
+#include "packtopology.h"
+
+//Balancing status of the whole pack as a packed bitmap with one bit per cell.
+//Incoming frames are merged into the bitmap, publish() reports the cells which changed
+//since the last call. All stacks are polled periodically through the diagnostic engine.
+//A stack which does not answer is polled with an exponential backoff, and only the change
+//between answering and not answering is reported, not every failed request.
+class Balancing : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Balancing(QObject *parent = nullptr);
+
+    static const int numberOfStacks = bms_topology_t::stacks;
+    static const int cellsPerStack = bms_topology_t::cellsPerStack;
+
+    void merge_activity(const QByteArray &payload);
+    void merge_diag_response(const QByteArray &payload);
+    void publish();
+    void clear();
+
+    bool is_balancing(int stack, int cell) const;
+
+    void set_poll_interval(int milliseconds);
+    void start_polling();
+    void stop_polling();
+    //Returns false if the failed request was not a balancing poll
+    bool request_failed(quint8 command, quint8 stack);
+
+signals:
+    void diag_request(quint8 command, quint8 stack, QByteArray arguments);
+    void stack_answering(quint8 stack, bool answering);
+    //Cell indices (stack * cellsPerStack + cell) whose balancing status changed
+    void changed(QVector<quint16> cells);
+
+private:
+    static const quint8 diagGetBalancing = 0x3;
+
+    static const int words = (bms_topology_t::cells + 63) / 64;
+    //Poll intervals skipped after the nth failure in a row: 1, 3, 7, ... up to 63
+    static const int maxBackoffExponent = 6;
+
+    quint64 bitmap[words];
+    quint64 published[words];
+    QTimer *pollTimer = nullptr;
+    int failures[numberOfStacks];
+    int holdoff[numberOfStacks];
+    bool answering[numberOfStacks];
+
+    void set_stack(int stack, quint16 cells);
+    void reset_backoff();
+    void poll();
+};
+
+#endif // BALANCING_H
@@ -0,0 +1,9 @@
+# Include from a project next to bmscore to link the static core library
+INCLUDEPATH += $$PWD $$PWD/../common
+DEPENDPATH += $$PWD
+include($$PWD/topology.pri)
+
+BMSCORE_BUILD = $$shadowed($$PWD)
+# shm_open of the pack state segment is in librt on older glibc
+LIBS += -L$$BMSCORE_BUILD -lbmscore -lrt
+PRE_TARGETDEPS += $$BMSCORE_BUILD/libbmscore.a
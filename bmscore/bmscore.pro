@@ -0,0 +1,61 @@
+# CAN ingest, decoding, pack state and logging without any widget dependency.
+# Linked statically by the viewer and the headless daemon.
+QT -= gui
+QT += network serialbus
+
+TEMPLATE = lib
+CONFIG += staticlib c++17
+
+# Vectorize the statistics loops without a dependency on the OpenMP runtime
+QMAKE_CXXFLAGS += -fopenmp-simd
+
+INCLUDEPATH += ../common
+include(topology.pri)
+
+SOURCES += \
+    ../common/canlink.cpp \
+    ../common/ipcprotocol.cpp \
+    ../common/packshm.c \
+    balancing.cpp \
+    bmsdecoder.cpp \
+    bmshistory.cpp \
+    can.cpp \
+    cellstatistics.cpp \
+    cyclicsender.cpp \
+    diagengine.cpp \
+    eventlog.cpp \
+    flightrecorder.cpp \
+    heartbeat.cpp \
+    linkmonitor.cpp \
+    logsummary.cpp \
+    packpublisher.cpp \
+    sessionlogger.cpp \
+    streamclient.cpp \
+    streamprotocol.cpp \
+    streamserver.cpp \
+    timeseriesstore.cpp
+
+HEADERS += \
+    ../common/canlink.h \
+    ../common/ipcprotocol.h \
+    ../common/packshm.h \
+    balancing.h \
+    bmsdecoder.h \
+    bmshistory.h \
+    can.h \
+    cellstatistics.h \
+    cyclicsender.h \
+    diagengine.h \
+    eventlog.h \
+    flightrecorder.h \
+    heartbeat.h \
+    linkmonitor.h \
+    loggingdata.h \
+    logsummary.h \
+    packpublisher.h \
+    packtopology.h \
+    sessionlogger.h \
+    streamclient.h \
+    streamprotocol.h \
+    streamserver.h \
+    timeseriesstore.h
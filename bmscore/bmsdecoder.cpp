@@ -0,0 +1,386 @@
+#include "bmsdecoder.h"
+#include "linkmonitor.h"
+
+BmsDecoder::BmsDecoder(QObject *parent) : QObject(parent)
+{
+    ::memset(&bmsInfo, 0, sizeof(bms_info_t));
+    ::memset(&state, 0, sizeof(pack_t));
+    lastInfoValid = false;
+    fullUpdate = 0;
+    linkAvailable = false;
+}
+
+void BmsDecoder::decode(const QCanBusFrame &frame)
+{
+    const QByteArray payload = frame.payload();
+    //Frames which do not match the layout are dropped, they neither update the state nor the link status
+    bool valid = true;
+    quint16 received = 0;
+    switch (frame.frameId()) {
+    case ID_BMS_INFO_1:
+        valid = decompose_bms_1(payload);
+        received = (1 << 0);
+        break;
+    case ID_BMS_INFO_2:
+        valid = decompose_bms_2(payload);
+        received = (1 << 1);
+        break;
+    case ID_BMS_INFO_3:
+        valid = decompose_bms_3(payload);
+        if (valid) {
+            log_state_transitions();
+        }
+        received = (1 << 2);
+        break;
+    case ID_CELL_VOLT_1:
+        valid = decomposeCellVoltage(0, payload);
+        received = (1 << 3);
+        break;
+    case ID_CELL_VOLT_2:
+        valid = decomposeCellVoltage(3, payload);
+        received = (1 << 4);
+        break;
+    case ID_CELL_VOLT_3:
+        valid = decomposeCellVoltage(6, payload);
+        received = (1 << 5);
+        break;
+    case ID_CELL_VOLT_4:
+        valid = decomposeCellVoltage(9, payload);
+        received = (1 << 6);
+        break;
+    case ID_CELL_TEMP_1:
+        valid = decomposeCellTemperatures(0, payload);
+        received = (1 << 7);
+        break;
+    case ID_CELL_TEMP_2:
+        valid = decomposeCellTemperatures(5, payload);
+        received = (1 << 8);
+        break;
+    case ID_CELL_TEMP_3:
+        valid = decomposeCellTemperatures(10, payload);
+        received = (1 << 9);
+        break;
+    case ID_UID:
+        valid = decomposeUid(payload);
+        received = (1 << 10);
+        break;
+    case ID_FD_CELL_VOLT:
+        valid = decompose_fd_cell_voltages(payload);
+        received = cellFramesMask;
+        break;
+    case ID_FD_CELL_TEMP:
+        valid = decompose_fd_cell_temperatures(payload);
+        received = temperatureFramesMask;
+        break;
+    }
+    if (!valid) {
+        return;
+    }
+    fullUpdate |= received;
+
+    if (fullUpdate == fullUpdateMask) {
+        linkAvailable = true;
+        fullUpdate = 0;
+    }
+
+    if (payload.size() > 0) {
+        emit decoded(frame.frameId(), (quint8)payload.at(0) >> 4);
+    }
+}
+
+void BmsDecoder::clear_measurements()
+{
+    ::memset(state.cellVoltages, 0, sizeof(state.cellVoltages));
+    ::memset(state.temperatures, 0, sizeof(state.temperatures));
+}
+
+bool BmsDecoder::take_link_available()
+{
+    bool available = linkAvailable;
+    linkAvailable = false;
+    return available;
+}
+
+//The stack is in the upper nibble of byte 0, which can address 16 stacks, only those of the topology exist
+static bool stack_in_range(const QByteArray &payload, int minimumSize)
+{
+    return (payload.size() >= minimumSize) && (((quint8)payload.at(0) >> 4) < bms_topology_t::stacks);
+}
+
+//Per cell one 16 bit word: 13 bit voltage, 1 unused bit and 2 bit validity
+bool BmsDecoder::decomposeCellVoltage(quint8 cellOffset, const QByteArray &payload)
+{
+    //Frames beyond the cells of the topology are not sent, the payload must hold the cells which exist
+    int count = frame_cells(cellOffset);
+    if ((count <= 0) || !stack_in_range(payload, 1 + 2 * count)) {
+        return false;
+    }
+    quint8 stack = (quint8)payload.at(0) >> 4;
+
+    if (cellOffset == 0) {
+        state.cellVoltageValidity[stack][0] = ((quint8)payload.at(0) & 0x3);
+    }
+    for (int i = 0; i < count; i++) {
+        quint8 high = (quint8)payload.at(1 + 2 * i);
+        quint8 low = (quint8)payload.at(2 + 2 * i);
+        state.cellVoltages[stack][cellOffset + i] = (high << 5) | (low >> 3);
+        state.cellVoltageValidity[stack][cellOffset + i + 1] = (low & 0x3);
+    }
+    return true;
+}
+
+//Per sensor 12 bits from bit 4 on: 10 bit temperature and 2 bit validity.
+//Even sensors start in the lower nibble of a byte, odd sensors at a byte boundary.
+bool BmsDecoder::decomposeCellTemperatures(quint8 offset, const QByteArray &payload)
+{
+    int count = frame_sensors(offset);
+    if ((count <= 0) || !stack_in_range(payload, (11 + 12 * count) / 8)) {
+        return false;
+    }
+    quint8 stack = (quint8)payload.at(0) >> 4;
+
+    for (int i = 0; i < count; i++) {
+        int byte = (4 + 12 * i) / 8;
+        quint8 first = (quint8)payload.at(byte);
+        quint8 second = (quint8)payload.at(byte + 1);
+        if ((i % 2) == 0) {
+            state.temperatures[stack][offset + i] = (((first & 0xF) << 6) | (second >> 2)) * 0.1f;
+            state.temperatureValidity[stack][offset + i] = (second & 0x3);
+        } else {
+            state.temperatures[stack][offset + i] = ((first << 2) | (second >> 6)) * 0.1f;
+            state.temperatureValidity[stack][offset + i] = ((second >> 4) & 0x3);
+        }
+    }
+    return true;
+}
+
+//CAN FD layout: byte 0 holds the stack in the upper nibble, followed by one 16 bit word per channel.
+//Voltages use the classic encoding (13 bit mV, 2 bit validity), the stack validity is in the lower bits of byte 0.
+bool BmsDecoder::decompose_fd_cell_voltages(const QByteArray &payload)
+{
+    if (!stack_in_range(payload, 1 + bms_topology_t::cellsPerStack * 2)) {
+        return false;
+    }
+    quint8 stack = (quint8)payload.at(0) >> 4;
+
+    state.cellVoltageValidity[stack][0] = ((quint8)payload.at(0) & 0x3);
+    for (int cell = 0; cell < bms_topology_t::cellsPerStack; cell++) {
+        quint8 high = (quint8)payload.at(1 + 2 * cell);
+        quint8 low = (quint8)payload.at(2 + 2 * cell);
+        state.cellVoltages[stack][cell] = (high << 5) | (low >> 3);
+        state.cellVoltageValidity[stack][cell + 1] = (low & 0x3);
+    }
+    return true;
+}
+
+//Temperatures are 10 bit in 0.1 degC in the upper bits of the word, the validity in the lowest 2 bits
+bool BmsDecoder::decompose_fd_cell_temperatures(const QByteArray &payload)
+{
+    if (!stack_in_range(payload, 1 + bms_topology_t::sensorsPerStack * 2)) {
+        return false;
+    }
+    quint8 stack = (quint8)payload.at(0) >> 4;
+
+    for (int sensor = 0; sensor < bms_topology_t::sensorsPerStack; sensor++) {
+        quint16 word = ((quint8)payload.at(1 + 2 * sensor) << 8) | (quint8)payload.at(2 + 2 * sensor);
+        state.temperatures[stack][sensor] = (word >> 6) * 0.1f;
+        state.temperatureValidity[stack][sensor] = (word & 0x3);
+    }
+    return true;
+}
+
+bool BmsDecoder::decomposeUid(const QByteArray &payload)
+{
+    if (!stack_in_range(payload, 5)) {
+        return false;
+    }
+    quint8 stack = (quint8)payload.at(0) >> 4;
+    state.uid[stack] = (quint8)payload.at(1) << 24 | (quint8)payload.at(2) << 16 | (quint8)payload.at(3) << 8 | (quint8)payload.at(4);
+    return true;
+}
+
+bool BmsDecoder::decompose_bms_1(const QByteArray &payload)
+{
+    if (payload.size() < 8) {
+        return false;
+    }
+    bmsInfo.minCellVolt = (float)(((quint16)(payload[0] & 0xFF) << 5) | (quint16)(payload[1] & 0xFF) >> 3) * 0.001f;
+    bmsInfo.minCellVoltValid = (payload[1] >> 2) & 0x01;
+    bmsInfo.maxCellVolt =(float)((quint16)((payload[1] & 0x03) << 11) | ((quint16)(payload[2] & 0xFF) << 3) | (quint8)payload[3] >> 5) * 0.001f;
+    bmsInfo.maxCellVoltValid = (payload[3] >> 4) & 0x01;
+    bmsInfo.avgCellVolt = (float)((quint16)((payload[3] & 0x0F) << 9) | (quint16)((payload[4] & 0xFF) << 1) | (quint16)((payload[5] >> 7) & 0x01)) * 0.001f;
+    bmsInfo.avgCellVoltValid = (payload[5] >> 6) & 0x01;
+    bmsInfo.minSoc = (float)(((quint16)(payload[5] & 0x3F) << 4) | (quint16)((payload[6] >> 4) & 0x0F)) * 0.1f;
+    bmsInfo.minSocValid = (payload[6] >> 3) & 0x01;
+    bmsInfo.maxSoc = (float)(((quint16)(payload[6] & 0x07) << 7) | (quint16)((payload[7] >> 1) & 0x7F)) * 0.1f;
+    bmsInfo.maxSocValid = (payload[7] & 0x01);
+    return true;
+}
+
+bool BmsDecoder::decompose_bms_2(const QByteArray &payload)
+{
+    if (payload.size() < 7) {
+        return false;
+    }
+    bmsInfo.batteryVoltage = (float)(((quint16)(payload[0] & 0xFF) << 5) | (quint16)((payload[1] >> 3) & 0x1F)) * 0.1f;
+    bmsInfo.batteryVoltageValid = (payload[1] >> 2) & 0x01;
+    bmsInfo.dcLinkVoltage = (float)(((quint16)(payload[2] & 0xFF) << 5) | (quint16)((payload[3] >> 3) & 0x1F)) * 0.1f;
+    bmsInfo.dcLinkVoltageValid = (payload[3] >> 2) & 0x01;
+    bmsInfo.current = (float)(((qint16)(payload[4]) << 8) | (quint8)(payload[5])) * 0.00625f;
+    bmsInfo.currentValid = (payload[6] >> 7) & 0x01;
+    return true;
+}
+
+bool BmsDecoder::decompose_bms_3(const QByteArray &payload)
+{
+    if (payload.size() < 8) {
+        return false;
+    }
+    bmsInfo.isoRes = (float)(((quint16)(payload[0] & 0xFF) << 7) | (quint16)((payload[1] >> 1) & 0x7F)) * 0.1f;
+    bmsInfo.isoResValid = payload[1] & 0x01;
+    bmsInfo.shutdownStatus = (payload[2] >> 7) & 0x01;
+    bmsInfo.tsState = static_cast<ts_state_t>((payload[2] >> 5) & 0x03);
+    bmsInfo.amsScStatus = (payload[2] >> 4) & 0x01;
+    bmsInfo.amsStatus = (payload[2] >> 3) & 0x01;
+    bmsInfo.imdScStatus = (payload[2] >> 2) & 0x01;
+    bmsInfo.imdStatus = (payload[2] >> 1) & 0x01;
+    bmsInfo.error = static_cast<error_code_t>(payload[3] >> 1);
+    bmsInfo.minTemp = (float)(((quint16)(payload[3] & 0x01) << 9) | (quint16)((payload[4] & 0xFF) << 1) | (quint16)((payload[5] >> 7) & 0x01)) * 0.1f;
+    bmsInfo.minTempValid = (payload[5] >> 6) & 0x01;
+    bmsInfo.maxTemp = (float)(((quint16)(payload[5] & 0x3F) << 4) | (quint16)((payload[6] >> 4) & 0x0F)) * 0.1f;
+    bmsInfo.maxTempValid = (payload[6] >> 3) & 0x01;
+    bmsInfo.avgTemp = (float)(((quint16)(payload[6] & 0x07) << 7) | (quint16)((payload[7] >> 1) & 0x7F)) * 0.1f;
+    bmsInfo.avgTempValid = payload[7] & 0x01;
+    return true;
+}
+
+void BmsDecoder::log_state_transitions()
+{
+    if (!lastInfoValid) {
+        //Only the initial error is of interest, states are assumed to be OK
+        if (bmsInfo.error != ERROR_NO_ERROR) {
+            emit transition(EventLog::SOURCE_BMS_ERROR, bmsInfo.error);
+        }
+        lastInfo = bmsInfo;
+        lastInfoValid = true;
+        return;
+    }
+
+    if (bmsInfo.error != lastInfo.error) {
+        emit transition(EventLog::SOURCE_BMS_ERROR, bmsInfo.error);
+    }
+    if (bmsInfo.tsState != lastInfo.tsState) {
+        emit transition(EventLog::SOURCE_TS_STATE, bmsInfo.tsState);
+    }
+    if (bmsInfo.shutdownStatus != lastInfo.shutdownStatus) {
+        emit transition(EventLog::SOURCE_SHUTDOWN, bmsInfo.shutdownStatus);
+    }
+    if (bmsInfo.imdStatus != lastInfo.imdStatus) {
+        emit transition(EventLog::SOURCE_IMD, bmsInfo.imdStatus);
+    }
+    if (bmsInfo.imdScStatus != lastInfo.imdScStatus) {
+        emit transition(EventLog::SOURCE_IMD_SC, bmsInfo.imdScStatus);
+    }
+    if (bmsInfo.amsStatus != lastInfo.amsStatus) {
+        emit transition(EventLog::SOURCE_AMS, bmsInfo.amsStatus);
+    }
+    if (bmsInfo.amsScStatus != lastInfo.amsScStatus) {
+        emit transition(EventLog::SOURCE_AMS_SC, bmsInfo.amsScStatus);
+    }
+    lastInfo = bmsInfo;
+}
+
+QString BmsDecoder::describe_event(const EventLog::event_t &event)
+{
+    switch (event.source) {
+    case EventLog::SOURCE_BMS_ERROR:
+        if (event.code == ERROR_NO_ERROR) {
+            return "[INFO]: " + error_to_string(static_cast<error_code_t>(event.code));
+        }
+        return "[ERROR]: " + error_to_string(static_cast<error_code_t>(event.code));
+    case EventLog::SOURCE_TS_STATE:
+        return "[INFO]: TS state changed to " + ts_state_to_string(static_cast<ts_state_t>(event.code));
+    case EventLog::SOURCE_SHUTDOWN:
+    case EventLog::SOURCE_IMD:
+    case EventLog::SOURCE_IMD_SC:
+    case EventLog::SOURCE_AMS:
+    case EventLog::SOURCE_AMS_SC:
+        if (event.code) {
+            return "[INFO]: " + EventLog::source_to_string(event.source) + " OK";
+        }
+        return "[ERROR]: " + EventLog::source_to_string(event.source) + " error!";
+    case EventLog::SOURCE_LINK:
+        if (event.code) {
+            return "[INFO]: Link established";
+        }
+        return "[ERROR]: Link lost!";
+    case EventLog::SOURCE_CAN_BUS:
+        if (event.code == LinkMonitor::HEALTH_OK) {
+            return QString("[INFO]: CAN bus OK after %1 ms").arg(event.value);
+        }
+        return QString("[ERROR]: CAN bus %1 (%2 ms in previous state)")
+                .arg(LinkMonitor::health_to_string(event.code).toLower()).arg(event.value);
+    case EventLog::SOURCE_CAN_RECOVERY:
+        if (event.code == LinkMonitor::RECOVERY_DONE) {
+            return QString("[INFO]: CAN link recovered, outage %1 ms").arg(event.value);
+        }
+        return QString("[INFO]: CAN link restart, attempt %1").arg(event.value);
+    case EventLog::SOURCE_DIAG:
+        return QString("[ERROR]: Diagnostic request 0x%1 to stack %2 not answered")
+                .arg(event.code, 2, 16, QChar('0')).arg(event.value);
+    case EventLog::SOURCE_DIAG_STACK:
+        if (event.code) {
+            return QString("[INFO]: Stack %1 answers diagnostic requests again").arg(event.value);
+        }
+        return QString("[ERROR]: Stack %1 does not answer diagnostic requests").arg(event.value);
+    }
+    return "Unknown event";
+}
+
+QString BmsDecoder::ts_state_to_string(ts_state_t state)
+{
+    switch (state) {
+    case TS_STATE_STANDBY:
+        return "Standby";
+    case TS_STATE_PRE_CHARGING:
+        return "Pre-charging";
+    case TS_STATE_OPERATE:
+        return "Operate";
+    case TS_STATE_ERROR:
+        return "Error";
+    }
+    return "Undefined state";
+}
+
+QString BmsDecoder::error_to_string(error_code_t error)
+{
+    switch (error) {
+    case ERROR_NO_ERROR:
+        return "Error cleared.";
+    case ERROR_SYSTEM_NOT_HEALTHY:
+        return "System not healthy!";
+    case ERROR_CONTACTOR_IMPLAUSIBLE:
+        return "Contactor state implausible!";
+    case ERROR_PRE_CHARGE_TOO_SHORT:
+        return "Pre-charge too short!";
+    case ERROR_PRE_CHARGE_TIMEOUT:
+        return "Pre-charge timed out!";
+    }
+    return "Undefined error.";
+}
+
+QString BmsDecoder::returnValidity(quint8 val)
+{
+    switch (val) {
+    case NOERROR:
+        return "OK";
+    case PECERROR:
+        return "PEC error";
+    case VALUEOUTOFRANGE:
+        return "Value out of range";
+    case OPENCELLWIRE:
+        return "Open wire";
+    default:
+        return "Unknown error";
+    }
+}
@@ -0,0 +1,159 @@
+#ifndef BMSDECODER_H
+#define BMSDECODER_H
+
+#include <QObject>
+#include <QCanBusFrame>
+#include "eventlog.h"
+#include "packtopology.h"
+
+//Decoded state of the pack, fed with the raw frames of the BMU.
+//Every decoded frame is announced by decoded(), changes of the BMS states by transition().
+class BmsDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    enum LTCError_t{
+        NOERROR         = 0x0, //!< NOERROR
+        PECERROR        = 0x1, //!< PECERROR
+        VALUEOUTOFRANGE = 0x2, //!< VALUEOUTOFRANGE
+        OPENCELLWIRE    = 0x3, //!< OPENCELLWIRE
+    };
+
+    enum canIds {
+        ID_BMS_INFO_1  = 0x1,
+        ID_BMS_INFO_2  = 0x2,
+        ID_BMS_INFO_3  = 0x3,
+        ID_CELL_TEMP_1 = 0x4,
+        ID_CELL_TEMP_2 = 0x5,
+        ID_CELL_TEMP_3 = 0x6,
+        ID_CELL_VOLT_1 = 0x7,
+        ID_CELL_VOLT_2 = 0x8,
+        ID_CELL_VOLT_3 = 0x9,
+        ID_CELL_VOLT_4 = 0xA,
+        ID_UID         = 0xB,
+        ID_DIAG_REQUEST = 0xC,
+        ID_DIAG_RESPONSE = 0xD,
+        ID_BALANCING   = 0xE,
+        //CAN FD, one frame per stack
+        ID_FD_CELL_VOLT = 0x10,
+        ID_FD_CELL_TEMP = 0x11
+    };
+
+    enum ts_state_t {
+        TS_STATE_STANDBY,
+        TS_STATE_PRE_CHARGING,
+        TS_STATE_OPERATE,
+        TS_STATE_ERROR
+    };
+
+    enum error_code_t {
+        ERROR_NO_ERROR,
+        ERROR_SYSTEM_NOT_HEALTHY,
+        ERROR_CONTACTOR_IMPLAUSIBLE,
+        ERROR_PRE_CHARGE_TOO_SHORT,
+        ERROR_PRE_CHARGE_TIMEOUT
+    };
+
+    struct bms_info_t {
+        float minCellVolt;
+        bool minCellVoltValid;
+        float maxCellVolt;
+        bool maxCellVoltValid;
+        float avgCellVolt;
+        bool avgCellVoltValid;
+        float minSoc;
+        bool minSocValid;
+        float maxSoc;
+        bool maxSocValid;
+        float batteryVoltage;
+        bool batteryVoltageValid;
+        float dcLinkVoltage;
+        bool dcLinkVoltageValid;
+        float current;
+        bool currentValid;
+        float isoRes;
+        bool isoResValid;
+        bool imdStatus;
+        bool imdScStatus;
+        bool amsStatus;
+        bool amsScStatus;
+        ts_state_t tsState;
+        bool shutdownStatus;
+        error_code_t error;
+        float minTemp;
+        bool minTempValid;
+        float maxTemp;
+        bool maxTempValid;
+        float avgTemp;
+        bool avgTempValid;
+    };
+
+    //Sized by the topology of the pack on the bus, the validity of a stack precedes its cells
+    struct pack_t {
+        quint16 cellVoltages[bms_topology_t::stacks][bms_topology_t::cellsPerStack];
+        quint8 cellVoltageValidity[bms_topology_t::stacks][bms_topology_t::cellsPerStack + 1];
+        float temperatures[bms_topology_t::stacks][bms_topology_t::sensorsPerStack];
+        quint8 temperatureValidity[bms_topology_t::stacks][bms_topology_t::sensorsPerStack];
+        quint32 uid[bms_topology_t::stacks];
+    };
+
+    //Classic frames carry 3 cells and 5, 5 and 4 sensors. The last frame of a stack with fewer channels
+    //carries only those which exist, in the leading slots, and the frames beyond it are not sent.
+    static constexpr int frame_cells(int offset)
+    {
+        return (bms_topology_t::cellsPerStack - offset < 3) ? bms_topology_t::cellsPerStack - offset : 3;
+    }
+    static constexpr int frame_sensors(int offset)
+    {
+        int slots = (offset == 10) ? 4 : 5;
+        return (bms_topology_t::sensorsPerStack - offset < slots) ? bms_topology_t::sensorsPerStack - offset : slots;
+    }
+
+    explicit BmsDecoder(QObject *parent = nullptr);
+
+    void decode(const QCanBusFrame &frame);
+    //Clears the cell values, stacks which stop sending read as 0 after the next period
+    void clear_measurements();
+    //True, if every message has been received since the last call
+    bool take_link_available();
+
+    const bms_info_t &info() const { return bmsInfo; }
+    const pack_t &pack() const { return state; }
+
+    static QString ts_state_to_string(ts_state_t state);
+    static QString error_to_string(error_code_t error);
+    static QString returnValidity(quint8 val);
+    static QString describe_event(const EventLog::event_t &event);
+
+signals:
+    void decoded(quint32 frameId, quint8 stack);
+    void transition(EventLog::source_t source, quint16 code);
+
+private:
+    bms_info_t bmsInfo;
+    pack_t state;
+    bms_info_t lastInfo;
+    bool lastInfoValid;
+    quint16 fullUpdate;
+    bool linkAvailable;
+
+    //Bits 0-2: BMS info, 3-6: cell voltages, 7-9: temperatures, 10: UID. Only the frames the topology sends are expected.
+    static constexpr int cellFrames = (bms_topology_t::cellsPerStack + 2) / 3;
+    static constexpr int temperatureFrames = (bms_topology_t::sensorsPerStack + 4) / 5;
+    static constexpr quint16 cellFramesMask = ((1 << cellFrames) - 1) << 3;
+    static constexpr quint16 temperatureFramesMask = ((1 << temperatureFrames) - 1) << 7;
+    static constexpr quint16 fullUpdateMask = 0x7 | cellFramesMask | temperatureFramesMask | (1 << 10);
+
+    //Return false if the payload is too short or addresses a stack which does not exist
+    bool decomposeCellVoltage(quint8 cellOffset, const QByteArray &payload);
+    bool decomposeCellTemperatures(quint8 offset, const QByteArray &payload);
+    bool decomposeUid(const QByteArray &payload);
+    bool decompose_fd_cell_voltages(const QByteArray &payload);
+    bool decompose_fd_cell_temperatures(const QByteArray &payload);
+    bool decompose_bms_1(const QByteArray &payload);
+    bool decompose_bms_2(const QByteArray &payload);
+    bool decompose_bms_3(const QByteArray &payload);
+    void log_state_transitions();
+};
+
+#endif // BMSDECODER_H
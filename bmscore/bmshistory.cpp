@@ -0,0 +1,114 @@
+#include "bmshistory.h"
+#include <QDateTime>
+
+BmsHistory::BmsHistory(const BmsDecoder *decoder, qint64 memoryBudget, int rawRetention, int aggregateRetention)
+    : decoder(decoder), history(memoryBudget, rawRetention, aggregateRetention)
+{
+    const float rate = 10.0f;
+
+    historyCellVoltage = history.signal_count();
+    for (int i = 0; i < bms_topology_t::cells; i++) {
+        history.add_signal(QString("Cell %1").arg(i + 1), 0.001f, rate);
+    }
+    historyTemperature = history.signal_count();
+    for (int i = 0; i < bms_topology_t::sensors; i++) {
+        history.add_signal(QString("Temperature %1").arg(i + 1), 0.1f, rate);
+    }
+    historyInfo = history.signal_count();
+    history.add_signal("Min cell voltage", 0.001f, rate);
+    history.add_signal("Max cell voltage", 0.001f, rate);
+    history.add_signal("Avg cell voltage", 0.001f, rate);
+    history.add_signal("Min SOC", 0.1f, rate);
+    history.add_signal("Max SOC", 0.1f, rate);
+    history.add_signal("Battery voltage", 0.1f, rate);
+    history.add_signal("DC-Link voltage", 0.1f, rate);
+    history.add_signal("Current", 0.01f, rate);
+    history.add_signal("Insulation resistance", 0.1f, rate);
+    history.add_signal("Min temperature", 0.1f, rate);
+    history.add_signal("Max temperature", 0.1f, rate);
+    history.add_signal("Avg temperature", 0.1f, rate);
+    history.add_signal("TS state", 1.0f, rate);
+    history.add_signal("Error", 1.0f, rate);
+    history.add_signal("Shutdown status", 1.0f, rate);
+    history.allocate();
+}
+
+void BmsHistory::record(quint32 frameId, quint8 stack)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const BmsDecoder::bms_info_t &bmsInfo = decoder->info();
+    const BmsDecoder::pack_t &pack = decoder->pack();
+
+    auto record_cells = [&](quint8 offset, quint8 count) {
+        for (quint8 cell = offset; cell < offset + count; cell++) {
+            if (pack.cellVoltageValidity[stack][cell + 1] == BmsDecoder::NOERROR) {
+                history.append(cell_voltage_signal(stack, cell), now, pack.cellVoltages[stack][cell] * 0.001f);
+            }
+        }
+    };
+    auto record_temperatures = [&](quint8 offset, quint8 count) {
+        for (quint8 sensor = offset; sensor < offset + count; sensor++) {
+            if (pack.temperatureValidity[stack][sensor] == BmsDecoder::NOERROR) {
+                history.append(temperature_signal(stack, sensor), now, pack.temperatures[stack][sensor]);
+            }
+        }
+    };
+
+    switch (frameId) {
+    case BmsDecoder::ID_BMS_INFO_1:
+        history.append(historyInfo + HISTORY_MIN_CELL_VOLT, now, bmsInfo.minCellVolt);
+        history.append(historyInfo + HISTORY_MAX_CELL_VOLT, now, bmsInfo.maxCellVolt);
+        history.append(historyInfo + HISTORY_AVG_CELL_VOLT, now, bmsInfo.avgCellVolt);
+        history.append(historyInfo + HISTORY_MIN_SOC, now, bmsInfo.minSoc);
+        history.append(historyInfo + HISTORY_MAX_SOC, now, bmsInfo.maxSoc);
+        break;
+    case BmsDecoder::ID_BMS_INFO_2:
+        history.append(historyInfo + HISTORY_BATTERY_VOLTAGE, now, bmsInfo.batteryVoltage);
+        history.append(historyInfo + HISTORY_DC_LINK_VOLTAGE, now, bmsInfo.dcLinkVoltage);
+        history.append(historyInfo + HISTORY_CURRENT, now, bmsInfo.current);
+        break;
+    case BmsDecoder::ID_BMS_INFO_3:
+        history.append(historyInfo + HISTORY_ISO_RES, now, bmsInfo.isoRes);
+        history.append(historyInfo + HISTORY_MIN_TEMP, now, bmsInfo.minTemp);
+        history.append(historyInfo + HISTORY_MAX_TEMP, now, bmsInfo.maxTemp);
+        history.append(historyInfo + HISTORY_AVG_TEMP, now, bmsInfo.avgTemp);
+        history.append(historyInfo + HISTORY_TS_STATE, now, bmsInfo.tsState);
+        history.append(historyInfo + HISTORY_ERROR, now, bmsInfo.error);
+        history.append(historyInfo + HISTORY_SHUTDOWN_STATUS, now, bmsInfo.shutdownStatus);
+        break;
+    }
+
+    if (stack >= bms_topology_t::stacks) {
+        return;
+    }
+
+    switch (frameId) {
+    case BmsDecoder::ID_CELL_VOLT_1:
+        record_cells(0, BmsDecoder::frame_cells(0));
+        break;
+    case BmsDecoder::ID_CELL_VOLT_2:
+        record_cells(3, BmsDecoder::frame_cells(3));
+        break;
+    case BmsDecoder::ID_CELL_VOLT_3:
+        record_cells(6, BmsDecoder::frame_cells(6));
+        break;
+    case BmsDecoder::ID_CELL_VOLT_4:
+        record_cells(9, BmsDecoder::frame_cells(9));
+        break;
+    case BmsDecoder::ID_CELL_TEMP_1:
+        record_temperatures(0, BmsDecoder::frame_sensors(0));
+        break;
+    case BmsDecoder::ID_CELL_TEMP_2:
+        record_temperatures(5, BmsDecoder::frame_sensors(5));
+        break;
+    case BmsDecoder::ID_CELL_TEMP_3:
+        record_temperatures(10, BmsDecoder::frame_sensors(10));
+        break;
+    case BmsDecoder::ID_FD_CELL_VOLT:
+        record_cells(0, bms_topology_t::cellsPerStack);
+        break;
+    case BmsDecoder::ID_FD_CELL_TEMP:
+        record_temperatures(0, bms_topology_t::sensorsPerStack);
+        break;
+    }
+}
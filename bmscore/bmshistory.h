@@ -0,0 +1,49 @@
+#ifndef BMSHISTORY_H
+#define BMSHISTORY_H
+
+#include "bmsdecoder.h"
+#include "timeseriesstore.h"
+
+//History of all decoded signals of the pack.
+//record() is called for every decoded frame and stores the values it carried.
+class BmsHistory
+{
+public:
+    enum history_info_t {
+        HISTORY_MIN_CELL_VOLT,
+        HISTORY_MAX_CELL_VOLT,
+        HISTORY_AVG_CELL_VOLT,
+        HISTORY_MIN_SOC,
+        HISTORY_MAX_SOC,
+        HISTORY_BATTERY_VOLTAGE,
+        HISTORY_DC_LINK_VOLTAGE,
+        HISTORY_CURRENT,
+        HISTORY_ISO_RES,
+        HISTORY_MIN_TEMP,
+        HISTORY_MAX_TEMP,
+        HISTORY_AVG_TEMP,
+        HISTORY_TS_STATE,
+        HISTORY_ERROR,
+        HISTORY_SHUTDOWN_STATUS
+    };
+
+    //Full rate for rawRetention seconds, 1 s aggregates for aggregateRetention seconds
+    explicit BmsHistory(const BmsDecoder *decoder, qint64 memoryBudget = 128 * 1024 * 1024,
+                        int rawRetention = 600, int aggregateRetention = 86400);
+
+    void record(quint32 frameId, quint8 stack);
+
+    const TimeSeriesStore &store() const { return history; }
+    int cell_voltage_signal(int stack, int cell) const { return historyCellVoltage + stack * bms_topology_t::cellsPerStack + cell; }
+    int temperature_signal(int stack, int sensor) const { return historyTemperature + stack * bms_topology_t::sensorsPerStack + sensor; }
+    int info_signal(history_info_t info) const { return historyInfo + info; }
+
+private:
+    const BmsDecoder *decoder;
+    TimeSeriesStore history;
+    int historyCellVoltage;
+    int historyTemperature;
+    int historyInfo;
+};
+
+#endif // BMSHISTORY_H
@@ -0,0 +1,426 @@
+#include "can.h"
+#include "canlink.h"
+#include "heartbeat.h"
+#include <QFile>
+#include <net/if_arp.h>
+#include <linux/can/netlink.h>
+
+Can::Can(QObject *parent) : QObject(parent)
+{
+    QSettings settings;
+    linkConfig.bitrate = settings.value("can/bitrate", 1000000).toUInt();
+    linkConfig.samplePoint = settings.value("can/samplePoint", 875).toUInt();
+    //The kernel owns the restart after bus off, the link monitor only waits for it and reopens the socket
+    linkConfig.restartMs = 100;
+    linkConfig.dataBitrate = settings.value("can/dataBitrate", 0).toUInt();
+    linkConfig.dataSamplePoint = settings.value("can/dataSamplePoint", 750).toUInt();
+
+    monitor = new LinkMonitor(this);
+    QObject::connect(monitor, &LinkMonitor::restart_link, this, &Can::restart_link);
+    QObject::connect(monitor, &LinkMonitor::recovered, this, [=] { connect_socket(); });
+    QObject::connect(this, &Can::device_up, this, [=] { monitor->start(deviceName); });
+    QObject::connect(this, &Can::device_down, monitor, &LinkMonitor::stop);
+
+    cyclic = new CyclicSender(this);
+}
+
+Can::~Can()
+{
+    if (socket) {
+        //Let the helper bring the interface down and exit without waiting for the heartbeat timeout
+        send_request(IPC_SHUTDOWN, helperOwnsLink ? deviceName.toLocal8Bit() : QByteArray());
+        socket->waitForBytesWritten(100);
+    }
+    if (heartbeatThread) {
+        heartbeatThread->quit();
+        heartbeatThread->wait();
+    }
+    if (server) {
+        QLocalServer::removeServer(ipcServerName);
+    }
+}
+
+void Can::init()
+{
+    set_state(STATE_PROBING, "Looking for CAN interfaces...");
+
+    QSettings settings;
+    QString lastDevice = settings.value("can/lastDevice").toString();
+    QStringList names = local_devices();
+    if (names.removeOne(lastDevice)) {
+        names.prepend(lastDevice);
+    }
+    if (!names.isEmpty()) {
+        emit available_devices(names);
+    }
+
+    //Nothing to configure, if the last used interface is already up at the right bitrate
+    can_link_info_t info;
+    if (!lastDevice.isEmpty() && link_ready(lastDevice, info)) {
+        deviceName = lastDevice;
+        if (connect_socket()) {
+            set_state(STATE_READY, describe_link(info));
+            emit device_up();
+            return;
+        }
+    }
+
+    start_helper();
+}
+
+void Can::start_helper()
+{
+    if (server) {
+        return;
+    }
+    set_state(STATE_STARTING_HELPER, "Waiting for root privileges to configure the CAN interface...");
+
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::WorldAccessOption);
+    QObject::connect(server, &QLocalServer::newConnection, this, &Can::new_client_connected);
+    QLocalServer::removeServer(ipcServerName);
+    if(!server->listen(ipcServerName)) {
+        qDebug() << "Could not start server!";
+    }
+
+    //The helper is launched once both servers are listening
+    heartbeatThread = new QThread(this);
+    Heartbeat *heartbeat = new Heartbeat();
+    heartbeat->moveToThread(heartbeatThread);
+    QObject::connect(heartbeatThread, &QThread::started, heartbeat, &Heartbeat::start);
+    QObject::connect(heartbeatThread, &QThread::finished, heartbeat, &QObject::deleteLater);
+    QObject::connect(heartbeat, &Heartbeat::listening, this, &Can::launch_helper);
+    QObject::connect(heartbeat, &Heartbeat::lost, this, [=] {
+        set_state(STATE_FAILED, "CAN helper stopped responding");
+        emit error("The CAN helper stopped responding!");
+    });
+    heartbeatThread->start();
+}
+
+void Can::launch_helper()
+{
+    QProcess *process = new QProcess();
+    QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+        Q_UNUSED(exitStatus)
+        if ((startupState != STATE_READY) && (exitCode != 0)) {
+            set_state(STATE_FAILED, "CAN helper could not be started");
+            emit error("Could not start the CAN helper! Only interfaces which are already up can be used.");
+        }
+        process->deleteLater();
+    });
+    QObject::connect(process, &QProcess::errorOccurred, this, [=](QProcess::ProcessError processError) {
+        if (processError == QProcess::FailedToStart) {
+            set_state(STATE_FAILED, "pkexec not found");
+            emit error("Could not start the CAN helper, pkexec not found!");
+            process->deleteLater();
+        }
+    });
+
+    QString path = QDir::currentPath() + /* "/../../" + "bms-viewer-helper/build*/ "/bms-viewer-helper";
+    process->start("pkexec", QStringList({path}));
+}
+
+void Can::get_devices()
+{
+    //The pcan network interfaces show up once the driver is loaded
+    emit available_devices(local_devices());
+}
+
+QStringList Can::local_devices()
+{
+    //Every SocketCAN interface (pcan, vcan, ...) has the link type ARPHRD_CAN.
+    //Reading sysfs is much faster than probing the peakcan plugin and does not need root privileges.
+    QStringList names;
+    QDir net("/sys/class/net");
+    for (const QString &name : net.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        QFile type(net.filePath(name + "/type"));
+        if (type.open(QIODevice::ReadOnly) && (type.readAll().trimmed().toInt() == ARPHRD_CAN)) {
+            names.append(name);
+        }
+    }
+    return names;
+}
+
+bool Can::link_ready(QString name, can_link_info_t &info)
+{
+    if (!canlink_query(name.toLocal8Bit().constData(), &info)) {
+        return false;
+    }
+    return info.exists && info.up && canlink_matches(&info, &linkConfig);
+}
+
+QString Can::describe_link(const can_link_info_t &info)
+{
+    if (info.isVirtual) {
+        return QString("%1 up (virtual)").arg(deviceName);
+    }
+    QString description = QString("%1 up at %2 kbit/s, sample point %3 %")
+            .arg(deviceName).arg(info.bitrate / 1000).arg(info.samplePoint / 10.0, 0, 'f', 1);
+    if (info.fd) {
+        description += QString(", CAN FD data phase %1 kbit/s, sample point %2 %")
+                .arg(info.dataBitrate / 1000).arg(info.dataSamplePoint / 10.0, 0, 'f', 1);
+    }
+    return description + QString(", TX/RX errors %1/%2").arg(info.txErrors).arg(info.rxErrors);
+}
+
+void Can::set_link_config(quint32 bitrate, quint16 samplePoint, quint32 dataBitrate)
+{
+    linkConfig.bitrate = bitrate;
+    linkConfig.samplePoint = samplePoint;
+    linkConfig.dataBitrate = dataBitrate;
+}
+
+void Can::set_state(startup_state_t state, QString message)
+{
+    startupState = state;
+    qDebug() << message;
+    emit progress(message);
+}
+
+quint16 Can::send_request(quint8 type, const QByteArray &payload)
+{
+    quint16 id = nextRequestId++;
+    pendingRequests.insert(id, type);
+    socket->write(ipc_encode(id, type, IPC_REQUEST, payload));
+    return id;
+}
+
+void Can::connect_device()
+{
+    QSettings settings;
+    settings.setValue("can/lastDevice", deviceName);
+    settings.setValue("can/bitrate", linkConfig.bitrate);
+    settings.setValue("can/samplePoint", linkConfig.samplePoint);
+    settings.setValue("can/dataBitrate", linkConfig.dataBitrate);
+
+    can_link_info_t info;
+    if (link_ready(deviceName, info)) {
+        helperOwnsLink = false;
+        if (connect_socket()) {
+            emit progress(describe_link(info));
+            emit device_up();
+        } else {
+            emit error("Could not connect to can socket!");
+        }
+    } else if (socket && (startupState == STATE_READY)) {
+        send_request(IPC_LINK_UP, ipc_encode_link_config(deviceName, linkConfig));
+    } else if (startupState == STATE_FAILED) {
+        emit error(QString("%1 is not up and the CAN helper is not available!").arg(deviceName));
+    } else {
+        pendingConnect = true;
+        start_helper();
+    }
+}
+
+void Can::disconnect_device()
+{
+    pendingConnect = false;
+    monitor->stop();
+    close_socket();
+    if (socket && helperOwnsLink) {
+        send_request(IPC_LINK_DOWN, deviceName.toLocal8Bit());
+    } else {
+        emit device_down();
+    }
+}
+
+void Can::send_frame(QCanBusFrame frame)
+{
+    if (can_device) {
+        can_device->writeFrame(frame);
+    }
+}
+
+void Can::start_cyclic(QCanBusFrame frame, int periodMs)
+{
+    //Kept across reconnects, the sender sets the job up again on the new socket
+    cyclic->start(frame, periodMs);
+}
+
+void Can::stop_cyclic(quint32 id)
+{
+    cyclic->stop(id);
+}
+
+void Can::set_device_name(QString deviceName)
+{
+    this->deviceName = deviceName;
+}
+
+bool Can::connect_socket()
+{
+    close_socket();
+
+    QString errorString;
+    //The bitrate is either set by the helper or already verified over netlink
+    can_device = QCanBus::instance()->createDevice(
+        QStringLiteral("socketcan"), QString("%1").arg(deviceName), &errorString);
+    if (!can_device) {
+        qDebug("Can device init failed");
+        return false;
+    }
+    //Lets the socket receive 64 byte CAN FD frames, classic frames are unaffected
+    can_device->setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+    //Error frames report bus state changes without polling
+    can_device->setConfigurationParameter(QCanBusDevice::ErrorFilterKey,
+                                          QVariant::fromValue(QCanBusFrame::FrameErrors(QCanBusFrame::AnyError)));
+    if (!can_device->connectDevice()) {
+        qDebug("Can device init failed");
+        close_socket();
+        return false;
+    }
+    QObject::connect(can_device, &QCanBusDevice::framesReceived, this, &Can::get_frame);
+    QObject::connect(can_device, &QCanBusDevice::errorOccurred, monitor, &LinkMonitor::poll);
+    if (!cyclic->open(deviceName)) {
+        qDebug() << "Cyclic transmission not available on" << deviceName;
+    }
+    qDebug("Pcan init successful");
+    return true;
+}
+
+void Can::close_socket()
+{
+    cyclic->close();
+    if (can_device) {
+        can_device->disconnectDevice();
+        can_device->deleteLater();
+        can_device = nullptr;
+    }
+}
+
+void Can::restart_link(int attempt)
+{
+    can_link_info_t info;
+    if (!canlink_query(deviceName.toLocal8Bit().constData(), &info) || !info.exists) {
+        //Wait for the adapter to come back
+        return;
+    }
+    if (info.up && (info.state == CAN_STATE_BUS_OFF) && (info.restartMs > 0)) {
+        //Restarted by the kernel after restart_ms, a manual restart would be rejected
+        return;
+    }
+    qDebug() << "Restarting" << deviceName << "attempt" << attempt;
+
+    if (socket && (startupState == STATE_READY)) {
+        if (!restartPending) {
+            restartPending = true;
+            send_request(IPC_LINK_RESTART, ipc_encode_link_config(deviceName, linkConfig));
+        }
+    } else if (info.up && (info.state != CAN_STATE_BUS_OFF)) {
+        //Restarted by someone else, the monitor notices it and the socket is reopened on recovery
+        monitor->poll();
+    } else {
+        //Configuring the interface needs the helper, the next attempt uses it once it is ready
+        start_helper();
+    }
+}
+
+void Can::new_client_connected()
+{
+    if (socket) {
+        server->nextPendingConnection()->abort();
+        return;
+    }
+    socket = server->nextPendingConnection();
+    QObject::connect(socket, &QLocalSocket::readyRead, this, &Can::message_from_client);
+}
+
+void Can::message_from_client()
+{
+    decoder.append(socket->readAll());
+    ipc_message_t message;
+    while (decoder.next(message)) {
+        handle_message(message);
+    }
+    if (decoder.error()) {
+        set_state(STATE_FAILED, "Invalid message from the CAN helper");
+        emit error("Invalid message from the CAN helper!");
+        socket->abort();
+    }
+}
+
+void Can::handle_message(const ipc_message_t &message)
+{
+    if (message.type == IPC_HELLO) {
+        set_state(STATE_LOADING_DRIVER, "Loading pcan driver...");
+        send_request(IPC_LOAD_DRIVER);
+        return;
+    }
+
+    //Responses to requests which are not pending any more are dropped
+    if (pendingRequests.value(message.id) != message.type) {
+        return;
+    }
+    pendingRequests.remove(message.id);
+    bool success = message.status == IPC_SUCCESS;
+    if (!success) {
+        qDebug() << message.payload;
+    }
+
+    switch (message.type) {
+    case IPC_LOAD_DRIVER:
+        if (success) {
+            set_state(STATE_READY, "CAN driver loaded");
+            get_devices();
+            if (pendingConnect) {
+                pendingConnect = false;
+                send_request(IPC_LINK_UP, ipc_encode_link_config(deviceName, linkConfig));
+            }
+        } else {
+            set_state(STATE_FAILED, "Could not load pcan driver");
+            emit error("Could not load pcan driver!");
+        }
+        break;
+
+    case IPC_LINK_UP: {
+        can_link_info_t info;
+        if (!success || !ipc_decode_link_info(message.payload, info)) {
+            emit error(QString("Could not bring can interface up! %1").arg(QString::fromLocal8Bit(message.payload)));
+            break;
+        }
+        helperOwnsLink = true;
+        if (connect_socket()) {
+            emit progress(describe_link(info));
+            emit device_up();
+        } else {
+            emit error("Could not connect to can socket!");
+        }
+        break;
+    }
+
+    case IPC_LINK_DOWN:
+        if (success) {
+            helperOwnsLink = false;
+            emit device_down();
+        } else {
+            emit error("Could not bring can interface down!");
+        }
+        break;
+
+    case IPC_LINK_RESTART:
+        //Failed restarts are retried by the link monitor
+        restartPending = false;
+        if (success) {
+            //The socket is reopened once the monitor sees the link back
+            helperOwnsLink = true;
+            monitor->poll();
+        } else {
+            qDebug() << "Restart failed:" << message.payload;
+        }
+        break;
+    }
+}
+
+void Can::get_frame()
+{
+    while(can_device->framesAvailable()) {
+        QCanBusFrame frame = can_device->readFrame();
+        if (frame.frameType() == QCanBusFrame::ErrorFrame) {
+            monitor->error_frame(frame);
+            continue;
+        }
+        //Loopback of the cyclic frames, measures their period
+        cyclic->loopback(frame);
+        emit new_frame(frame);
+    }
+}
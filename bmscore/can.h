@@ -0,0 +1,91 @@
+#ifndef CAN_H
+#define CAN_H
+
+#include <QObject>
+#include <QCanBus>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDir>
+#include <QProcess>
+#include <QTimer>
+#include <QSettings>
+#include <QThread>
+#include <QHash>
+#include "ipcprotocol.h"
+#include "linkmonitor.h"
+#include "cyclicsender.h"
+
+
+class Can : public QObject
+{
+    Q_OBJECT
+public:
+    enum startup_state_t {
+        STATE_IDLE,
+        STATE_PROBING,
+        STATE_STARTING_HELPER,
+        STATE_LOADING_DRIVER,
+        STATE_READY,
+        STATE_FAILED
+    };
+
+    explicit Can(QObject *parent = nullptr);
+    ~Can();
+    void init();
+
+    void connect_device();
+    void disconnect_device();
+    void send_frame(QCanBusFrame frame);
+    void set_device_name(QString deviceName);
+    void set_link_config(quint32 bitrate, quint16 samplePoint, quint32 dataBitrate);
+    can_link_config_t link_config() const { return linkConfig; }
+    startup_state_t state() const { return startupState; }
+    LinkMonitor *link_monitor() const { return monitor; }
+    CyclicSender *cyclic_sender() const { return cyclic; }
+    void start_cyclic(QCanBusFrame frame, int periodMs);
+    void stop_cyclic(quint32 id);
+
+
+private:
+
+    can_link_config_t linkConfig;
+    startup_state_t startupState = STATE_IDLE;
+    QThread *heartbeatThread = nullptr;
+    QCanBusDevice *can_device = nullptr;
+    bool connect_socket();
+    void close_socket();
+    LinkMonitor *monitor = nullptr;
+    CyclicSender *cyclic = nullptr;
+    bool restartPending = false;
+    void restart_link(int attempt);
+    QLocalServer *server = nullptr;
+    QLocalSocket *socket = nullptr;
+    void new_client_connected();
+    void message_from_client();
+    void handle_message(const ipc_message_t &message);
+    quint16 send_request(quint8 type, const QByteArray &payload = QByteArray());
+    IpcDecoder decoder;
+    quint16 nextRequestId = 1;
+    QHash<quint16, quint8> pendingRequests; //Request id -> message type
+    QString deviceName;
+    bool pendingConnect = false; //Bring the interface up as soon as the helper is ready
+    bool helperOwnsLink = false; //The helper brought the interface up and has to bring it down again
+    void get_frame();
+    void get_devices();
+    void start_helper();
+    void launch_helper();
+    void set_state(startup_state_t state, QString message);
+    bool link_ready(QString name, can_link_info_t &info);
+    QString describe_link(const can_link_info_t &info);
+    QStringList local_devices();
+
+signals:
+    void new_frame(QCanBusFrame);
+    void error(QString);
+    void device_up();
+    void device_down();
+    void available_devices(QStringList);
+    void progress(QString);
+};
+
+#endif // CAN_H
@@ -0,0 +1,122 @@
+#include "cellstatistics.h"
+#include <cfloat>
+
+CellStatistics::CellStatistics(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<cell_snapshot_t>();
+    qRegisterMetaType<cell_statistics_t>();
+    reset();
+}
+
+void CellStatistics::process(cell_snapshot_t snapshot)
+{
+    float dt = 0.0f;
+    if (lastTimestamp >= 0) {
+        dt = qMax(0.0f, (snapshot.timestamp - lastTimestamp) * 0.001f);
+    }
+
+    cell_statistics_t statistics;
+    statistics.timestamp = snapshot.timestamp;
+    evaluate<bms_topology_t::cells>(snapshot.voltage, snapshot.voltageValid, voltageFast, voltageSlow, dt, statistics.voltage);
+    evaluate<bms_topology_t::sensors>(snapshot.temperature, snapshot.temperatureValid, temperatureFast, temperatureSlow, dt, statistics.temperature);
+    lastTimestamp = snapshot.timestamp;
+
+    emit result(statistics);
+}
+
+void CellStatistics::reset()
+{
+    lastTimestamp = -1;
+    ::memset(voltageFast, 0, sizeof(voltageFast));
+    ::memset(voltageSlow, 0, sizeof(voltageSlow));
+    ::memset(temperatureFast, 0, sizeof(temperatureFast));
+    ::memset(temperatureSlow, 0, sizeof(temperatureSlow));
+}
+
+//The loops below are branch free so the compiler can vectorize them (-fopenmp-simd).
+//Invalid channels are masked by multiplying with their validity.
+template <int N>
+void CellStatistics::evaluate(const float *values, const float *valid, float *fast, float *slow, float dt, channel_statistics_t &stats)
+{
+    float sum = 0.0f;
+    float count = 0.0f;
+    #pragma omp simd reduction(+:sum, count)
+    for (int i = 0; i < N; i++) {
+        sum += values[i] * valid[i];
+        count += valid[i];
+    }
+
+    stats.count = (int)count;
+    stats.zscore.fill(0.0f, N);
+    stats.drift.fill(0.0f, N);
+    stats.outliers.clear();
+    stats.maxDriftChannel = 0;
+    if (stats.count == 0) {
+        stats.median = stats.mean = stats.stddev = stats.min = stats.max = 0.0f;
+        return;
+    }
+    float mean = sum / count;
+
+    float squares = 0.0f;
+    float min = FLT_MAX;
+    float max = -FLT_MAX;
+    #pragma omp simd reduction(+:squares) reduction(min:min) reduction(max:max)
+    for (int i = 0; i < N; i++) {
+        float delta = (values[i] - mean) * valid[i];
+        squares += delta * delta;
+        min = qMin(min, valid[i] > 0.5f ? values[i] : FLT_MAX);
+        max = qMax(max, valid[i] > 0.5f ? values[i] : -FLT_MAX);
+    }
+    float stddev = qSqrt(squares / count);
+    float inverse = stddev > 0.0f ? 1.0f / stddev : 0.0f;
+
+    //Offsets to the mean, smoothed with a fast and a slow time constant.
+    //The difference is the drift of a channel relative to the pack.
+    float fastAlpha = 1.0f - qExp(-dt / fastTimeConstant);
+    float slowAlpha = 1.0f - qExp(-dt / slowTimeConstant);
+    if (lastTimestamp < 0) {
+        fastAlpha = 1.0f;
+        slowAlpha = 1.0f;
+    }
+    float *zscore = stats.zscore.data();
+    float *drift = stats.drift.data();
+    #pragma omp simd
+    for (int i = 0; i < N; i++) {
+        float offset = values[i] - mean;
+        zscore[i] = offset * inverse * valid[i];
+        fast[i] += fastAlpha * (offset - fast[i]) * valid[i];
+        slow[i] += slowAlpha * (offset - slow[i]) * valid[i];
+        drift[i] = fast[i] - slow[i];
+    }
+
+    float maxDrift = 0.0f;
+    for (int i = 0; i < N; i++) {
+        if (qAbs(zscore[i]) > outlierThreshold) {
+            stats.outliers.append(i);
+        }
+        if (qAbs(drift[i]) > maxDrift) {
+            maxDrift = qAbs(drift[i]);
+            stats.maxDriftChannel = i;
+        }
+    }
+
+    //Median of the valid channels
+    float sorted[N];
+    int n = 0;
+    for (int i = 0; i < N; i++) {
+        if (valid[i] > 0.5f) {
+            sorted[n++] = values[i];
+        }
+    }
+    std::nth_element(sorted, sorted + n / 2, sorted + n);
+    float median = sorted[n / 2];
+    if ((n % 2) == 0) {
+        median = (median + *std::max_element(sorted, sorted + n / 2)) / 2.0f;
+    }
+
+    stats.median = median;
+    stats.mean = mean;
+    stats.stddev = stddev;
+    stats.min = min;
+    stats.max = max;
+}
@@ -0,0 +1,71 @@
+#ifndef CELLSTATISTICS_H
+#define CELLSTATISTICS_H
+
+#include <QObject>
+#include <QVector>
+#include <QMetaType>
+#include <QtMath>
+#include <algorithm>
+#include "packtopology.h"
+
+struct cell_snapshot_t {
+    qint64 timestamp; //ms since epoch
+    float voltage[bms_topology_t::cells];
+    float voltageValid[bms_topology_t::cells]; //1.0 if valid, 0.0 otherwise
+    float temperature[bms_topology_t::sensors];
+    float temperatureValid[bms_topology_t::sensors];
+};
+
+struct channel_statistics_t {
+    float median;
+    float mean;
+    float stddev;
+    float min;
+    float max;
+    int count;
+    QVector<quint16> outliers; //Channel indices with |z| above the threshold
+    QVector<float> zscore;
+    QVector<float> drift;      //Change of the offset to the mean over time
+    quint16 maxDriftChannel;
+};
+
+struct cell_statistics_t {
+    qint64 timestamp;
+    channel_statistics_t voltage;
+    channel_statistics_t temperature;
+};
+
+Q_DECLARE_METATYPE(cell_snapshot_t)
+Q_DECLARE_METATYPE(cell_statistics_t)
+
+//Host side statistics over all cell voltages and temperatures.
+//Lives in a worker thread, every snapshot updates the statistics incrementally.
+class CellStatistics : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CellStatistics(QObject *parent = nullptr);
+
+    void process(cell_snapshot_t snapshot);
+    void reset();
+
+signals:
+    void result(cell_statistics_t statistics);
+
+private:
+    static constexpr float outlierThreshold = 3.0f;
+    static constexpr float fastTimeConstant = 30.0f;   //s
+    static constexpr float slowTimeConstant = 1800.0f; //s
+
+    //Exponentially weighted offsets of every channel to the mean
+    float voltageFast[bms_topology_t::cells];
+    float voltageSlow[bms_topology_t::cells];
+    float temperatureFast[bms_topology_t::sensors];
+    float temperatureSlow[bms_topology_t::sensors];
+    qint64 lastTimestamp;
+
+    template <int N>
+    void evaluate(const float *values, const float *valid, float *fast, float *slow, float dt, channel_statistics_t &stats);
+};
+
+#endif // CELLSTATISTICS_H
@@ -0,0 +1,251 @@
+#include "cyclicsender.h"
+#include <QDebug>
+#include <limits>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/bcm.h>
+#include <linux/can/raw.h>
+
+namespace {
+
+struct bcm_message_t {
+    struct bcm_msg_head head;
+    struct can_frame frame;
+};
+
+void to_can_frame(const QCanBusFrame &frame, struct can_frame *raw)
+{
+    ::memset(raw, 0, sizeof(*raw));
+    raw->can_id = frame.frameId();
+    if (frame.hasExtendedFrameFormat()) {
+        raw->can_id |= CAN_EFF_FLAG;
+    }
+    const QByteArray payload = frame.payload();
+    raw->can_dlc = qMin(payload.size(), CAN_MAX_DLEN);
+    ::memcpy(raw->data, payload.constData(), raw->can_dlc);
+}
+
+qint64 monotonic_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (qint64)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+}
+
+CyclicSender::CyclicSender(QObject *parent) : QObject(parent), running(false)
+{
+
+}
+
+CyclicSender::~CyclicSender()
+{
+    close();
+}
+
+bool CyclicSender::open(QString deviceName)
+{
+    close();
+    this->deviceName = deviceName;
+
+    struct sockaddr_can address;
+    ::memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = if_nametoindex(deviceName.toLocal8Bit().constData());
+    if (address.can_ifindex == 0) {
+        return false;
+    }
+
+    bcmSocket = socket(PF_CAN, SOCK_DGRAM | SOCK_CLOEXEC, CAN_BCM);
+    if ((bcmSocket >= 0) && (::connect(bcmSocket, (struct sockaddr *)&address, sizeof(address)) < 0)) {
+        ::close(bcmSocket);
+        bcmSocket = -1;
+    }
+    if (bcmSocket >= 0) {
+        //Jobs survive a reconnect, e.g. after the link was recovered
+        QMutexLocker locker(&mutex);
+        for (const job_t &job : qAsConst(jobs)) {
+            setup_bcm(job);
+        }
+        return true;
+    }
+
+    qDebug() << "CAN_BCM not available, cyclic frames are sent by a thread";
+    rawSocket = socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if (rawSocket < 0) {
+        return false;
+    }
+    //Transmit only
+    setsockopt(rawSocket, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0);
+    if (bind(rawSocket, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        ::close(rawSocket);
+        rawSocket = -1;
+        return false;
+    }
+    start_fallback();
+    return true;
+}
+
+void CyclicSender::close()
+{
+    stop_fallback();
+    //Closing the socket removes its jobs from the broadcast manager
+    if (bcmSocket >= 0) {
+        ::close(bcmSocket);
+        bcmSocket = -1;
+    }
+    if (rawSocket >= 0) {
+        ::close(rawSocket);
+        rawSocket = -1;
+    }
+}
+
+void CyclicSender::start(const QCanBusFrame &frame, int periodMs)
+{
+    QMutexLocker locker(&mutex);
+    job_t &job = jobs[frame.frameId()];
+    job.frame = frame;
+    job.periodMs = periodMs;
+    job.nextDeadline = monotonic_ns();
+    job.lastTimestamp = -1;
+    job.period.count = 0;
+    job.period.last = 0;
+    job.period.min = std::numeric_limits<qint64>::max();
+    job.period.max = 0;
+    job.period.mean = 0.0;
+    if (bcmSocket >= 0) {
+        setup_bcm(job);
+    }
+}
+
+void CyclicSender::stop(quint32 id)
+{
+    QMutexLocker locker(&mutex);
+    if (!jobs.contains(id)) {
+        return;
+    }
+    struct can_frame raw;
+    to_can_frame(jobs.take(id).frame, &raw);
+    if (bcmSocket >= 0) {
+        bcm_message_t message;
+        ::memset(&message, 0, sizeof(message));
+        message.head.opcode = TX_DELETE;
+        message.head.can_id = raw.can_id;
+        if (write(bcmSocket, &message.head, sizeof(message.head)) < 0) {
+            qDebug() << "Could not delete cyclic frame" << id;
+        }
+    }
+}
+
+void CyclicSender::loopback(const QCanBusFrame &frame)
+{
+    QMutexLocker locker(&mutex);
+    auto it = jobs.find(frame.frameId());
+    if (it == jobs.end()) {
+        return;
+    }
+    qint64 timestamp = frame.timeStamp().seconds() * 1000000LL + frame.timeStamp().microSeconds();
+    if (it->lastTimestamp >= 0) {
+        qint64 interval = timestamp - it->lastTimestamp;
+        period_t &period = it->period;
+        period.count++;
+        period.last = interval;
+        period.min = qMin(period.min, interval);
+        period.max = qMax(period.max, interval);
+        period.mean += (interval - period.mean) / period.count;
+    }
+    it->lastTimestamp = timestamp;
+    quint32 id = frame.frameId();
+    locker.unlock();
+
+    emit transmitted(id, timestamp);
+}
+
+CyclicSender::period_t CyclicSender::period(quint32 id) const
+{
+    QMutexLocker locker(&mutex);
+    if (!jobs.contains(id)) {
+        return period_t{0, 0, 0, 0, 0.0};
+    }
+    return jobs.value(id).period;
+}
+
+bool CyclicSender::setup_bcm(const job_t &job)
+{
+    bcm_message_t message;
+    ::memset(&message, 0, sizeof(message));
+    to_can_frame(job.frame, &message.frame);
+    //Sent immediately and then every period by a kernel timer, until deleted
+    message.head.opcode = TX_SETUP;
+    message.head.flags = SETTIMER | STARTTIMER | TX_ANNOUNCE;
+    message.head.count = 0;
+    message.head.ival2.tv_sec = job.periodMs / 1000;
+    message.head.ival2.tv_usec = (job.periodMs % 1000) * 1000;
+    message.head.can_id = message.frame.can_id;
+    message.head.nframes = 1;
+    if (write(bcmSocket, &message, sizeof(message)) != sizeof(message)) {
+        qDebug() << "Could not set up cyclic frame" << job.frame.frameId();
+        return false;
+    }
+    return true;
+}
+
+void CyclicSender::start_fallback()
+{
+    running = true;
+    fallbackThread = QThread::create([this] { run_fallback(); });
+    fallbackThread->start(QThread::TimeCriticalPriority);
+}
+
+void CyclicSender::stop_fallback()
+{
+    if (!fallbackThread) {
+        return;
+    }
+    running = false;
+    fallbackThread->wait();
+    delete fallbackThread;
+    fallbackThread = nullptr;
+}
+
+void CyclicSender::run_fallback()
+{
+    //Real time scheduling needs CAP_SYS_NICE, without it the thread keeps its normal priority
+    struct sched_param parameter;
+    parameter.sched_priority = 50;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameter);
+
+    while (running) {
+        qint64 now = monotonic_ns();
+        qint64 wakeup = now + 10000000LL; //Check the stop flag at least every 10 ms
+        {
+            QMutexLocker locker(&mutex);
+            for (job_t &job : jobs) {
+                qint64 periodNs = job.periodMs * 1000000LL;
+                if (job.nextDeadline <= now) {
+                    struct can_frame raw;
+                    to_can_frame(job.frame, &raw);
+                    if (write(rawSocket, &raw, sizeof(raw)) < 0) {
+                        qDebug() << "Could not send cyclic frame" << job.frame.frameId();
+                    }
+                    //Absolute deadlines, a late wakeup does not shift the following ones
+                    job.nextDeadline += periodNs;
+                    if (job.nextDeadline <= now) {
+                        job.nextDeadline = now + periodNs;
+                    }
+                }
+                wakeup = qMin(wakeup, job.nextDeadline);
+            }
+        }
+        struct timespec deadline;
+        deadline.tv_sec = wakeup / 1000000000LL;
+        deadline.tv_nsec = wakeup % 1000000000LL;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef CYCLICSENDER_H
+#define CYCLICSENDER_H
+
+#include <QObject>
+#include <QCanBusFrame>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+
+//Periodic transmission of CAN frames, independent of the load of the GUI thread.
+//Jobs are handed to the kernel broadcast manager (CAN_BCM), which sends them from a kernel timer.
+//If CAN_BCM is not available, a high priority thread with absolute deadlines sends them instead.
+//The period is measured from the local loopback of the sent frames, which carries kernel timestamps.
+class CyclicSender : public QObject
+{
+    Q_OBJECT
+public:
+    struct period_t {
+        quint32 count;
+        qint64 last;  //us
+        qint64 min;
+        qint64 max;
+        double mean;
+    };
+
+    explicit CyclicSender(QObject *parent = nullptr);
+    ~CyclicSender();
+
+    bool open(QString deviceName);
+    void close();
+    bool uses_kernel() const { return bcmSocket >= 0; }
+
+    void start(const QCanBusFrame &frame, int periodMs);
+    void stop(quint32 id);
+
+    void loopback(const QCanBusFrame &frame);
+    period_t period(quint32 id) const;
+
+signals:
+    void transmitted(quint32 id, qint64 timestamp); //us, kernel time of the loopback
+
+private:
+    struct job_t {
+        QCanBusFrame frame;
+        int periodMs;
+        qint64 nextDeadline; //ns, CLOCK_MONOTONIC, fallback thread only
+        qint64 lastTimestamp;
+        period_t period;
+    };
+
+    QString deviceName;
+    int bcmSocket = -1;
+    int rawSocket = -1; //Fallback
+    QHash<quint32, job_t> jobs;
+    mutable QMutex mutex;
+    QThread *fallbackThread = nullptr;
+    std::atomic<bool> running;
+
+    bool setup_bcm(const job_t &job);
+    void start_fallback();
+    void stop_fallback();
+    void run_fallback();
+};
+
+#endif // CYCLICSENDER_H
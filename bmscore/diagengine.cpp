@@ -0,0 +1,166 @@
+#include "diagengine.h"
+#include <limits>
+
+DiagEngine::DiagEngine(quint32 requestId, QObject *parent) : QObject(parent), requestId(requestId)
+{
+    timeoutTimer = new QTimer(this);
+    timeoutTimer->setInterval(10);
+    QObject::connect(timeoutTimer, &QTimer::timeout, this, &DiagEngine::check_timeouts);
+    clear();
+}
+
+void DiagEngine::submit(quint8 command, quint8 stack, QByteArray arguments)
+{
+    //A queued request is updated, an identical request in flight would return the same answer
+    for (transaction_t &transaction : queued) {
+        if ((transaction.command == command) && (transaction.stack == stack)) {
+            transaction.arguments = arguments;
+            return;
+        }
+    }
+    for (const transaction_t &transaction : qAsConst(inFlight)) {
+        if ((transaction.command == command) && (transaction.stack == stack) && (transaction.arguments == arguments)) {
+            return;
+        }
+    }
+    transaction_t transaction;
+    transaction.command = command;
+    transaction.stack = stack;
+    transaction.arguments = arguments;
+    transaction.attempts = 0;
+    queued.enqueue(transaction);
+    dispatch();
+}
+
+void DiagEngine::send(quint8 command, quint8 stack, QByteArray arguments)
+{
+    emit send_frame(request_frame(command, stack, arguments));
+}
+
+bool DiagEngine::handle_response(const QCanBusFrame &frame)
+{
+    const QByteArray payload = frame.payload();
+    if (payload.size() < 2) {
+        return false;
+    }
+    quint8 command = (quint8)payload.at(0);
+    quint8 stack = (quint8)payload.at(1);
+
+    for (int i = 0; i < inFlight.size(); i++) {
+        if ((inFlight.at(i).command != command) || (inFlight.at(i).stack != stack)) {
+            continue;
+        }
+        //Measured from the last transmission, a late answer to an earlier attempt counts as well
+        qint64 roundTrip = inFlight.at(i).sent.nsecsElapsed() / 1000;
+        inFlight.remove(i);
+
+        statistics.count++;
+        statistics.last = roundTrip;
+        statistics.min = qMin(statistics.min, roundTrip);
+        statistics.max = qMax(statistics.max, roundTrip);
+        statistics.mean += (roundTrip - statistics.mean) / statistics.count;
+
+        emit completed(command, stack, roundTrip);
+        dispatch();
+        return true;
+    }
+    return false;
+}
+
+void DiagEngine::clear()
+{
+    queued.clear();
+    inFlight.clear();
+    timeoutTimer->stop();
+    statistics.count = 0;
+    statistics.last = 0;
+    statistics.min = std::numeric_limits<qint64>::max();
+    statistics.max = 0;
+    statistics.mean = 0.0;
+    statistics.timeouts = 0;
+    statistics.failures = 0;
+}
+
+void DiagEngine::set_window(int requests)
+{
+    window = qMax(1, requests);
+    dispatch();
+}
+
+void DiagEngine::set_timeout(int milliseconds)
+{
+    timeout = milliseconds;
+}
+
+void DiagEngine::set_retries(int retries)
+{
+    this->retries = retries;
+}
+
+void DiagEngine::dispatch()
+{
+    //Only one transaction per (command, stack) may be in flight, others wait in the queue
+    for (int i = 0; (i < queued.size()) && (inFlight.size() < window); ) {
+        bool busy = false;
+        for (const transaction_t &transaction : qAsConst(inFlight)) {
+            if ((transaction.command == queued.at(i).command) && (transaction.stack == queued.at(i).stack)) {
+                busy = true;
+                break;
+            }
+        }
+        if (busy) {
+            i++;
+            continue;
+        }
+        inFlight.append(queued.takeAt(i));
+        transmit(inFlight.last());
+    }
+
+    if (inFlight.isEmpty()) {
+        timeoutTimer->stop();
+    } else if (!timeoutTimer->isActive()) {
+        timeoutTimer->start();
+    }
+}
+
+QCanBusFrame DiagEngine::request_frame(quint8 command, quint8 stack, const QByteArray &arguments) const
+{
+    QCanBusFrame frame;
+    QByteArray payload;
+    payload.append(command);
+    payload.append(stack);
+    payload.append(arguments);
+    frame.setFrameId(requestId);
+    frame.setPayload(payload);
+    return frame;
+}
+
+void DiagEngine::transmit(transaction_t &transaction)
+{
+    transaction.attempts++;
+    transaction.sent.start();
+    emit send_frame(request_frame(transaction.command, transaction.stack, transaction.arguments));
+}
+
+void DiagEngine::check_timeouts()
+{
+    for (int i = 0; i < inFlight.size(); ) {
+        transaction_t &transaction = inFlight[i];
+        if (transaction.sent.elapsed() < timeout) {
+            i++;
+            continue;
+        }
+        statistics.timeouts++;
+        if (transaction.attempts <= retries) {
+            transmit(transaction);
+            i++;
+            continue;
+        }
+        statistics.failures++;
+        quint8 command = transaction.command;
+        quint8 stack = transaction.stack;
+        inFlight.remove(i);
+        emit failed(command, stack);
+    }
+    dispatch();
+}
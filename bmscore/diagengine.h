@@ -0,0 +1,76 @@
+#ifndef DIAGENGINE_H
+#define DIAGENGINE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QQueue>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QCanBusFrame>
+
+//Transaction layer for the diagnostic channel.
+//Requests are {command, stack, arguments...} on the request ID, the BMU answers with
+//{command, stack, ...} on the response ID. Up to window requests are in flight at the same time,
+//each (command, stack) pair at most once, so responses can be matched to their request.
+//Unanswered requests are retransmitted after the timeout and dropped after the last retry.
+//Commands without a response are sent once with send(), outside of the transactions.
+class DiagEngine : public QObject
+{
+    Q_OBJECT
+public:
+    struct latency_t {
+        quint32 count;
+        qint64 last;    //us
+        qint64 min;
+        qint64 max;
+        double mean;
+        quint32 timeouts;
+        quint32 failures;
+    };
+
+    explicit DiagEngine(quint32 requestId, QObject *parent = nullptr);
+
+    void submit(quint8 command, quint8 stack, QByteArray arguments = QByteArray());
+    //Fire and forget, neither matched to a response nor retransmitted
+    void send(quint8 command, quint8 stack, QByteArray arguments = QByteArray());
+    bool handle_response(const QCanBusFrame &frame);
+    void clear();
+
+    void set_window(int requests);
+    void set_timeout(int milliseconds);
+    void set_retries(int retries);
+
+    int in_flight() const { return inFlight.size(); }
+    latency_t latency() const { return statistics; }
+
+signals:
+    void send_frame(QCanBusFrame frame);
+    void completed(quint8 command, quint8 stack, qint64 roundTrip); //us
+    void failed(quint8 command, quint8 stack);
+
+private:
+    struct transaction_t {
+        quint8 command;
+        quint8 stack;
+        QByteArray arguments;
+        int attempts;
+        QElapsedTimer sent;
+    };
+
+    quint32 requestId;
+    int window = 12;
+    int timeout = 100; //ms
+    int retries = 2;
+
+    QQueue<transaction_t> queued;
+    QVector<transaction_t> inFlight;
+    QTimer *timeoutTimer;
+    latency_t statistics;
+
+    QCanBusFrame request_frame(quint8 command, quint8 stack, const QByteArray &arguments) const;
+    void dispatch();
+    void transmit(transaction_t &transaction);
+    void check_timeouts();
+};
+
+#endif // DIAGENGINE_H
@@ -0,0 +1,209 @@
+#include "eventlog.h"
+
+EventLog::EventLog(int capacity, QObject *parent) : QAbstractTableModel(parent)
+{
+    buffer.resize(capacity);
+    total = 0;
+    flushed = 0;
+    filter = 0xFFFFFFFF;
+}
+
+void EventLog::log(source_t source, quint16 code, qint32 value)
+{
+    event_t &e = buffer[total % buffer.size()];
+    e.timestamp = QDateTime::currentMSecsSinceEpoch();
+    e.source = source;
+    e.code = code;
+    e.value = value;
+    total++;
+}
+
+void EventLog::flush()
+{
+    if (flushed == total) {
+        return;
+    }
+
+    //Drop the rows whose events have been overwritten in the meantime
+    quint64 firstValid = first_valid();
+    int removed = 0;
+    while ((removed < (int)rows.size()) && (rows.at(removed) < firstValid)) {
+        removed++;
+    }
+    if (removed > 0) {
+        beginRemoveRows(QModelIndex(), 0, removed - 1);
+        rows.erase(rows.begin(), rows.begin() + removed);
+        endRemoveRows();
+    }
+
+    quint64 first = qMax(flushed, firstValid);
+    std::deque<quint64> appended;
+    for (quint64 sequence = first; sequence < total; sequence++) {
+        if (accepted(event_at(sequence))) {
+            appended.push_back(sequence);
+        }
+    }
+    flushed = total;
+
+    if (appended.empty()) {
+        return;
+    }
+    int firstRow = rows.size();
+    beginInsertRows(QModelIndex(), firstRow, firstRow + (int)appended.size() - 1);
+    rows.insert(rows.end(), appended.begin(), appended.end());
+    endInsertRows();
+    emit rows_appended();
+}
+
+void EventLog::clear()
+{
+    beginResetModel();
+    rows.clear();
+    total = 0;
+    flushed = 0;
+    endResetModel();
+}
+
+void EventLog::set_formatter(formatter_t formatter)
+{
+    this->formatter = formatter;
+}
+
+void EventLog::set_filter(quint32 sourceMask)
+{
+    beginResetModel();
+    filter = sourceMask;
+    rows.clear();
+    for (quint64 sequence = first_valid(); sequence < flushed; sequence++) {
+        if (accepted(event_at(sequence))) {
+            rows.push_back(sequence);
+        }
+    }
+    endResetModel();
+}
+
+bool EventLog::export_csv(QString fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << "Timestamp;Source;Code;Value;Message" << Qt::endl;
+    for (quint64 sequence : rows) {
+        const event_t &e = event_at(sequence);
+        stream << QDateTime::fromMSecsSinceEpoch(e.timestamp).toString("yyyy-MM-dd hh:mm:ss.zzz") << ";"
+               << source_to_string(e.source) << ";"
+               << e.code << ";"
+               << e.value << ";"
+               << format(e) << "\n";
+    }
+    file.close();
+    return true;
+}
+
+QString EventLog::source_to_string(quint8 source)
+{
+    switch (source) {
+    case SOURCE_BMS_ERROR:
+        return "BMS";
+    case SOURCE_TS_STATE:
+        return "TS state";
+    case SOURCE_SHUTDOWN:
+        return "Shutdown circuit";
+    case SOURCE_IMD:
+        return "IMD";
+    case SOURCE_IMD_SC:
+        return "IMD SC";
+    case SOURCE_AMS:
+        return "AMS";
+    case SOURCE_AMS_SC:
+        return "AMS SC";
+    case SOURCE_LINK:
+        return "Link";
+    case SOURCE_CAN_BUS:
+        return "CAN bus";
+    case SOURCE_CAN_RECOVERY:
+        return "CAN recovery";
+    case SOURCE_DIAG:
+    case SOURCE_DIAG_STACK:
+        return "Diagnostic";
+    }
+    return "Unknown";
+}
+
+int EventLog::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return rows.size();
+}
+
+int EventLog::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return COLUMN_COUNT;
+}
+
+QVariant EventLog::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole) || (index.row() >= (int)rows.size())) {
+        return QVariant();
+    }
+
+    const event_t &e = event_at(rows.at(index.row()));
+    switch (index.column()) {
+    case COLUMN_TIME:
+        return QDateTime::fromMSecsSinceEpoch(e.timestamp).toString("dd.MM.yyyy hh:mm:ss.zzz");
+    case COLUMN_SOURCE:
+        return source_to_string(e.source);
+    case COLUMN_MESSAGE:
+        return format(e);
+    }
+    return QVariant();
+}
+
+QVariant EventLog::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if ((orientation != Qt::Horizontal) || (role != Qt::DisplayRole)) {
+        return QVariant();
+    }
+    switch (section) {
+    case COLUMN_TIME:
+        return "Time";
+    case COLUMN_SOURCE:
+        return "Source";
+    case COLUMN_MESSAGE:
+        return "Message";
+    }
+    return QVariant();
+}
+
+quint64 EventLog::first_valid() const
+{
+    if (total < (quint64)buffer.size()) {
+        return 0;
+    }
+    return total - buffer.size();
+}
+
+const EventLog::event_t &EventLog::event_at(quint64 sequence) const
+{
+    return buffer.at(sequence % buffer.size());
+}
+
+bool EventLog::accepted(const event_t &event) const
+{
+    return (filter >> event.source) & 0x01;
+}
+
+QString EventLog::format(const event_t &event) const
+{
+    if (formatter) {
+        return formatter(event);
+    }
+    return QString("Code %1, value %2").arg(event.code).arg(event.value);
+}
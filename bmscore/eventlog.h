@@ -0,0 +1,87 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <deque>
+#include <functional>
+
+//Fixed capacity ring of compact event records.
+//Capturing an event is O(1) and does not touch any view. Pending events are handed
+//to attached views by flush(), texts are only formatted for the rows a view requests.
+class EventLog : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum source_t {
+        SOURCE_BMS_ERROR,
+        SOURCE_TS_STATE,
+        SOURCE_SHUTDOWN,
+        SOURCE_IMD,
+        SOURCE_IMD_SC,
+        SOURCE_AMS,
+        SOURCE_AMS_SC,
+        SOURCE_LINK,
+        SOURCE_CAN_BUS,      //Code: LinkMonitor::health_t, value: ms spent in the previous state
+        SOURCE_CAN_RECOVERY, //Code: LinkMonitor::recovery_event_t, value: attempt or outage in ms
+        SOURCE_DIAG,         //Code: diagnostic command, value: stack
+        SOURCE_DIAG_STACK,   //Code: 1 if the stack answers the balancing poll again, 0 if it stopped, value: stack
+        SOURCE_COUNT
+    };
+
+    enum column_t {
+        COLUMN_TIME,
+        COLUMN_SOURCE,
+        COLUMN_MESSAGE,
+        COLUMN_COUNT
+    };
+
+    struct event_t {
+        qint64 timestamp; //ms since epoch
+        quint8 source;
+        quint16 code;
+        qint32 value;
+    };
+
+    typedef std::function<QString(const event_t &)> formatter_t;
+
+    explicit EventLog(int capacity = 1 << 20, QObject *parent = nullptr);
+
+    void log(source_t source, quint16 code, qint32 value = 0);
+    void flush();
+    void clear();
+
+    void set_formatter(formatter_t formatter);
+    void set_filter(quint32 sourceMask);
+    bool export_csv(QString fileName) const;
+
+    static QString source_to_string(quint8 source);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+signals:
+    void rows_appended();
+
+private:
+    QVector<event_t> buffer;
+    quint64 total;       //Number of events ever logged, sequence number of the next event
+    quint64 flushed;     //Sequence number of the first event not yet handed to the views
+    quint32 filter;
+    formatter_t formatter;
+
+    //Sequence numbers of the events shown by the views
+    std::deque<quint64> rows;
+
+    quint64 first_valid() const;
+    const event_t &event_at(quint64 sequence) const;
+    bool accepted(const event_t &event) const;
+    QString format(const event_t &event) const;
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,170 @@
+#include "flightrecorder.h"
+#include "bmsdecoder.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <cstring>
+
+FlightRecorder::FlightRecorder(int capacity, QObject *parent) : QObject(parent)
+{
+    ring.resize(qMax(1, capacity));
+    snapshot.reserve(ring.size());
+    triggers = (1 << EventLog::SOURCE_BMS_ERROR) | (1 << EventLog::SOURCE_SHUTDOWN) | (1 << EventLog::SOURCE_IMD);
+
+    //Ends the capture if the bus falls silent after the trigger
+    postTimer = new QTimer(this);
+    postTimer->setSingleShot(true);
+    QObject::connect(postTimer, &QTimer::timeout, this, &FlightRecorder::finish);
+
+    writerThread = new QThread(this);
+    writer = new QObject();
+    writer->moveToThread(writerThread);
+    QObject::connect(writerThread, &QThread::finished, writer, &QObject::deleteLater);
+    writerThread->start(QThread::LowPriority);
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    stop();
+    writerThread->quit();
+    writerThread->wait();
+}
+
+void FlightRecorder::set_directory(QString directory)
+{
+    this->directory = directory;
+    QDir().mkpath(directory);
+}
+
+void FlightRecorder::set_windows(int preMs, int postMs)
+{
+    preWindow = preMs * 1000LL;
+    postWindow = postMs * 1000LL;
+}
+
+void FlightRecorder::record(const QCanBusFrame &frame)
+{
+    frame_record_t &record = ring[total % ring.size()];
+    record.timestamp = frame.timeStamp().seconds() * 1000000LL + frame.timeStamp().microSeconds();
+    if (record.timestamp == 0) {
+        record.timestamp = QDateTime::currentMSecsSinceEpoch() * 1000LL;
+    }
+    record.id = frame.frameId();
+    record.flags = (frame.hasExtendedFrameFormat() ? RECORD_EXTENDED : 0)
+            | (frame.hasFlexibleDataRateFormat() ? RECORD_FD : 0)
+            | (frame.hasBitrateSwitch() ? RECORD_BRS : 0);
+    const QByteArray payload = frame.payload();
+    record.length = qMin(payload.size(), (int)sizeof(record.data));
+    ::memcpy(record.data, payload.constData(), record.length);
+    total++;
+    lastTimestamp = record.timestamp;
+
+    if (!capturing()) {
+        return;
+    }
+    snapshot.append(record);
+    if ((record.timestamp >= postEnd) || (snapshot.size() >= ring.size())) {
+        finish();
+    }
+}
+
+void FlightRecorder::event(EventLog::source_t source, quint16 code)
+{
+    if (!(triggers & (1 << source))) {
+        return;
+    }
+    bool fire = (source == EventLog::SOURCE_BMS_ERROR) ? (code != BmsDecoder::ERROR_NO_ERROR) : (code == 0);
+    if (fire) {
+        trigger(EventLog::source_to_string(source));
+    }
+}
+
+void FlightRecorder::trigger(QString reason)
+{
+    //Later triggers are covered by the running capture
+    if (capturing() || directory.isEmpty()) {
+        return;
+    }
+
+    //Freeze the pre-trigger window, the ring keeps running
+    triggerTime = lastTimestamp;
+    quint64 first = (total > (quint64)ring.size()) ? total - ring.size() : 0;
+    quint64 begin = total;
+    while ((begin > first) && (ring.at((begin - 1) % ring.size()).timestamp >= triggerTime - preWindow)) {
+        begin--;
+    }
+    snapshot.clear();
+    for (quint64 sequence = begin; sequence < total; sequence++) {
+        snapshot.append(ring.at(sequence % ring.size()));
+    }
+
+    snapshotReason = reason;
+    postEnd = triggerTime + qMax<qint64>(1, postWindow);
+    postTimer->start(postWindow / 1000 + 1000);
+    emit triggered(reason);
+}
+
+void FlightRecorder::stop()
+{
+    if (capturing()) {
+        finish();
+    }
+    //Queued behind all pending snapshots
+    QMetaObject::invokeMethod(writer, [] {}, Qt::BlockingQueuedConnection);
+}
+
+void FlightRecorder::finish()
+{
+    if (!capturing()) {
+        return;
+    }
+    postTimer->stop();
+    postEnd = 0;
+
+    QString name = snapshotReason.toLower().replace(' ', '-');
+    QString fileName = QDir(directory).filePath(QString("flight-%1-%2.log")
+            .arg(QDateTime::fromMSecsSinceEpoch(triggerTime / 1000).toString("yyyyMMdd-hhmmss-zzz"), name));
+    QByteArray device = deviceName.toLatin1();
+    QVector<frame_record_t> frames;
+    frames.swap(snapshot);
+    snapshot.reserve(ring.size());
+    QMetaObject::invokeMethod(writer, [=] { write_snapshot(fileName, device, frames); });
+}
+
+//Runs on the writer thread
+void FlightRecorder::write_snapshot(QString fileName, QByteArray device, QVector<frame_record_t> frames)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        emit failed(fileName);
+        return;
+    }
+
+    static const char hex[] = "0123456789ABCDEF";
+    QByteArray line;
+    for (const frame_record_t &record : qAsConst(frames)) {
+        //(seconds.microseconds) interface id#data, CAN FD frames use id##flags followed by the data
+        line = QByteArray::number(record.timestamp / 1000000).prepend('(');
+        line += '.' + QByteArray::number(record.timestamp % 1000000).rightJustified(6, '0') + ") ";
+        line += device + ' ';
+        line += QByteArray::number(record.id, 16).toUpper().rightJustified((record.flags & RECORD_EXTENDED) ? 8 : 3, '0');
+        line += '#';
+        if (record.flags & RECORD_FD) {
+            line += '#';
+            line += hex[(record.flags & RECORD_BRS) ? 1 : 0];
+        }
+        for (int i = 0; i < record.length; i++) {
+            line += hex[record.data[i] >> 4];
+            line += hex[record.data[i] & 0xF];
+        }
+        line += '\n';
+        file.write(line);
+    }
+    file.close();
+
+    if (file.error() != QFileDevice::NoError) {
+        emit failed(fileName);
+    } else {
+        emit written(fileName, frames.size());
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QObject>
+#include <QCanBusFrame>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include "eventlog.h"
+
+//Always-on ring of the raw frames of the last seconds.
+//When a trigger fires, the frames of the pre-trigger window are frozen into a snapshot,
+//the frames of the post-trigger window are appended to it, and the snapshot is written
+//in candump log format by a background thread. Recording a frame is one copy into
+//preallocated memory, the ring never grows.
+class FlightRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FlightRecorder(int capacity = 1 << 16, QObject *parent = nullptr);
+    ~FlightRecorder();
+
+    void set_directory(QString directory);
+    void set_device_name(QString name) { deviceName = name; }
+    void set_windows(int preMs, int postMs);
+    //Mask of EventLog sources, see event()
+    void set_triggers(quint32 sourceMask) { triggers = sourceMask; }
+
+    void record(const QCanBusFrame &frame);
+    //BMS errors trigger when set, the status sources when they drop to 0
+    void event(EventLog::source_t source, quint16 code);
+    void trigger(QString reason);
+
+    bool capturing() const { return postEnd != 0; }
+    //Completes a running capture and waits for all snapshots to be written
+    void stop();
+
+signals:
+    void triggered(QString reason);
+    void written(QString fileName, int frames);
+    void failed(QString fileName);
+
+private:
+    struct frame_record_t {
+        qint64 timestamp; //us
+        quint32 id;
+        quint8 flags;
+        quint8 length;
+        quint8 data[64];
+    };
+
+    enum record_flags_t : quint8 {
+        RECORD_EXTENDED = 0x01,
+        RECORD_FD       = 0x02,
+        RECORD_BRS      = 0x04
+    };
+
+    QVector<frame_record_t> ring;
+    quint64 total = 0;
+    qint64 lastTimestamp = 0;
+
+    QString directory;
+    QString deviceName = "can0";
+    qint64 preWindow = 10000000; //us
+    qint64 postWindow = 5000000;
+    quint32 triggers;
+
+    QVector<frame_record_t> snapshot;
+    QString snapshotReason;
+    qint64 triggerTime = 0;
+    qint64 postEnd = 0;
+    QTimer *postTimer;
+
+    QThread *writerThread;
+    QObject *writer;
+
+    void finish();
+    void write_snapshot(QString fileName, QByteArray device, QVector<frame_record_t> frames);
+};
+
+#endif // FLIGHTRECORDER_H
@@ -0,0 +1,66 @@
+#include "heartbeat.h"
+
+Heartbeat::Heartbeat(QObject *parent) : QObject(parent)
+{
+
+}
+
+Heartbeat::~Heartbeat()
+{
+    if (server) {
+        QLocalServer::removeServer(ipcHeartbeatServerName);
+    }
+}
+
+void Heartbeat::start()
+{
+    //Called in the heartbeat thread, all children are created there
+    timer = new QTimer(this);
+    timer->setInterval(interval);
+    timer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(timer, &QTimer::timeout, this, &Heartbeat::send_heartbeat);
+
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::WorldAccessOption);
+    QObject::connect(server, &QLocalServer::newConnection, this, &Heartbeat::new_client_connected);
+    QLocalServer::removeServer(ipcHeartbeatServerName);
+    if (!server->listen(ipcHeartbeatServerName)) {
+        qDebug() << "Could not start heartbeat server!";
+    }
+    emit listening();
+}
+
+void Heartbeat::new_client_connected()
+{
+    if (socket) {
+        //Only the helper started by this viewer is served
+        server->nextPendingConnection()->abort();
+        return;
+    }
+    socket = server->nextPendingConnection();
+    QObject::connect(socket, &QLocalSocket::readyRead, this, &Heartbeat::message_from_client);
+    lastAcknowledge.start();
+    timer->start();
+}
+
+void Heartbeat::message_from_client()
+{
+    decoder.append(socket->readAll());
+    ipc_message_t message;
+    while (decoder.next(message)) {
+        if ((message.type == IPC_HEARTBEAT) && (message.status == IPC_SUCCESS)) {
+            lastAcknowledge.start();
+        }
+    }
+}
+
+void Heartbeat::send_heartbeat()
+{
+    socket->write(ipc_encode(sequence++, IPC_HEARTBEAT, IPC_REQUEST));
+    socket->flush();
+
+    if (!helperLost && (lastAcknowledge.elapsed() > lostTimeout)) {
+        helperLost = true;
+        emit lost();
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef HEARTBEAT_H
+#define HEARTBEAT_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "ipcprotocol.h"
+
+//Keeps bms-viewer-helper alive over a connection of its own.
+//Lives in a separate thread, so stalls of the GUI thread do not stop the heartbeat.
+class Heartbeat : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Heartbeat(QObject *parent = nullptr);
+    ~Heartbeat();
+
+    void start();
+
+signals:
+    void listening();
+    void lost();
+
+private:
+    static const int interval = 100;      //ms
+    static const int lostTimeout = 2000;  //ms, same as the helper
+
+    QLocalServer *server = nullptr;
+    QLocalSocket *socket = nullptr;
+    QTimer *timer = nullptr;
+    QElapsedTimer lastAcknowledge;
+    IpcDecoder decoder;
+    quint16 sequence = 0;
+    bool helperLost = false;
+
+    void new_client_connected();
+    void message_from_client();
+    void send_heartbeat();
+};
+
+#endif // HEARTBEAT_H
@@ -0,0 +1,136 @@
+#include "linkmonitor.h"
+#include "canlink.h"
+#include <linux/can/netlink.h>
+
+LinkMonitor::LinkMonitor(QObject *parent) : QObject(parent)
+{
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(pollInterval);
+    QObject::connect(pollTimer, &QTimer::timeout, this, &LinkMonitor::poll);
+
+    backoffTimer = new QTimer(this);
+    backoffTimer->setSingleShot(true);
+    QObject::connect(backoffTimer, &QTimer::timeout, this, &LinkMonitor::attempt_restart);
+}
+
+void LinkMonitor::start(QString deviceName)
+{
+    this->deviceName = deviceName;
+    currentHealth = HEALTH_OK;
+    recovering = false;
+    stateTimer.start();
+    pollTimer->setInterval(pollInterval);
+    pollTimer->start();
+    poll();
+}
+
+void LinkMonitor::stop()
+{
+    pollTimer->stop();
+    backoffTimer->stop();
+    recovering = false;
+}
+
+void LinkMonitor::poll()
+{
+    if (!pollTimer->isActive()) {
+        return;
+    }
+    can_link_info_t info;
+    if (!canlink_query(deviceName.toLocal8Bit().constData(), &info)) {
+        return;
+    }
+
+    health_t health;
+    if (!info.exists) {
+        health = HEALTH_MISSING;
+    } else if (!info.up) {
+        health = HEALTH_DOWN;
+    } else {
+        switch (info.state) {
+        case CAN_STATE_ERROR_WARNING:
+            health = HEALTH_WARNING;
+            break;
+        case CAN_STATE_ERROR_PASSIVE:
+            health = HEALTH_PASSIVE;
+            break;
+        case CAN_STATE_BUS_OFF:
+            health = HEALTH_BUS_OFF;
+            break;
+        case CAN_STATE_STOPPED:
+        case CAN_STATE_SLEEPING:
+            health = HEALTH_DOWN;
+            break;
+        default:
+            health = HEALTH_OK;
+            break;
+        }
+    }
+
+    if ((info.txErrors != txErrors) || (info.rxErrors != rxErrors)) {
+        txErrors = info.txErrors;
+        rxErrors = info.rxErrors;
+        emit error_counters(txErrors, rxErrors);
+    }
+    set_health(health);
+}
+
+void LinkMonitor::error_frame(const QCanBusFrame &frame)
+{
+    //Bus off is acted on without waiting for netlink, everything else refreshes the state
+    if (frame.error() & QCanBusFrame::BusOffError) {
+        set_health(HEALTH_BUS_OFF);
+    } else {
+        poll();
+    }
+}
+
+QString LinkMonitor::health_to_string(int health)
+{
+    switch (health) {
+    case HEALTH_OK:
+        return "OK";
+    case HEALTH_WARNING:
+        return "Error warning";
+    case HEALTH_PASSIVE:
+        return "Error passive";
+    case HEALTH_BUS_OFF:
+        return "Bus off";
+    case HEALTH_DOWN:
+        return "Interface down";
+    case HEALTH_MISSING:
+        return "Interface missing";
+    }
+    return "Unknown";
+}
+
+void LinkMonitor::set_health(health_t health)
+{
+    if (health == currentHealth) {
+        return;
+    }
+    currentHealth = health;
+    emit health_changed(health, stateTimer.restart());
+
+    if ((health >= HEALTH_BUS_OFF) && !recovering) {
+        recovering = true;
+        attempts = 0;
+        backoff = minimumBackoff;
+        outageTimer.start();
+        pollTimer->setInterval(recoveryPollInterval);
+        backoffTimer->start(backoff);
+    } else if ((health < HEALTH_BUS_OFF) && recovering) {
+        recovering = false;
+        backoffTimer->stop();
+        pollTimer->setInterval(pollInterval);
+        emit recovered(outageTimer.elapsed());
+    }
+}
+
+void LinkMonitor::attempt_restart()
+{
+    attempts++;
+    emit restart_link(attempts);
+    backoff = qMin(backoff * 2, maximumBackoff);
+    backoffTimer->start(backoff);
+}
@@ -0,0 +1,68 @@
+#ifndef LINKMONITOR_H
+#define LINKMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QCanBusFrame>
+
+//Tracks bus state and error counters of the CAN interface.
+//Error frames and device errors trigger an immediate check, otherwise the link is polled over netlink.
+//When the link is bus off, down or gone, restarts are requested with exponential backoff until it is back.
+class LinkMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    enum health_t {
+        HEALTH_OK,      //Error active
+        HEALTH_WARNING, //An error counter reached 96
+        HEALTH_PASSIVE, //An error counter reached 128
+        HEALTH_BUS_OFF,
+        HEALTH_DOWN,    //Interface is down
+        HEALTH_MISSING  //Interface is gone, e.g. the adapter was unplugged
+    };
+
+    enum recovery_event_t {
+        RECOVERY_ATTEMPT,
+        RECOVERY_DONE
+    };
+
+    explicit LinkMonitor(QObject *parent = nullptr);
+
+    void start(QString deviceName);
+    void stop();
+    void poll();
+    void error_frame(const QCanBusFrame &frame);
+    health_t health() const { return currentHealth; }
+
+    static QString health_to_string(int health);
+
+signals:
+    void health_changed(int health, qint64 duration); //Time spent in the previous state in ms
+    void error_counters(quint16 tx, quint16 rx);
+    void restart_link(int attempt);
+    void recovered(qint64 outage); //ms from losing the link to having it back
+
+private:
+    static const int pollInterval = 250;        //ms
+    static const int recoveryPollInterval = 20; //ms
+    static const int minimumBackoff = 20;       //ms
+    static const int maximumBackoff = 5000;     //ms
+
+    QTimer *pollTimer;
+    QTimer *backoffTimer;
+    QElapsedTimer stateTimer;
+    QElapsedTimer outageTimer;
+    QString deviceName;
+    health_t currentHealth = HEALTH_OK;
+    quint16 txErrors = 0;
+    quint16 rxErrors = 0;
+    bool recovering = false;
+    int attempts = 0;
+    int backoff = minimumBackoff;
+
+    void set_health(health_t health);
+    void attempt_restart();
+};
+
+#endif // LINKMONITOR_H
@@ -0,0 +1,54 @@
+#ifndef LOGGINGDATA_H
+#define LOGGINGDATA_H
+
+#include <stdint.h>
+#include "packtopology.h"
+
+//Record written by the BMU to its SD card, one base64 encoded record per line.
+//Host recordings use the same record, either as base64 lines or back to back in binary files.
+typedef struct {
+    uint8_t day;
+    uint8_t month;
+    uint16_t year;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+} rtc_date_time_t;
+
+//The record of every topology has the same layout, only the dimensions of the channel arrays differ
+template <class Topology>
+struct __attribute__((packed)) logging_record_t {
+    rtc_date_time_t timestamp;
+    uint16_t cellVoltage[Topology::stacks][Topology::cellsPerStack];
+    uint16_t temperature[Topology::stacks][Topology::sensorsPerStack];
+    float current;
+    float batteryVoltage;
+    float dcLinkVoltage;
+    uint16_t minCellVolt;
+    uint16_t maxCellVolt;
+    uint16_t avgCellVolt;
+    uint16_t minTemperature;
+    uint16_t maxTemperature;
+    uint16_t avgTemperature;
+    uint8_t stateMachineError;
+    uint8_t stateMachineState;
+    uint16_t minSoc;
+    uint16_t maxSoc;
+};
+
+//Base64 characters of a record and the line feed
+template <class Topology>
+constexpr int logging_line_length()
+{
+    return (sizeof(logging_record_t<Topology>) + 2) / 3 * 4 + 1;
+}
+
+typedef logging_record_t<spr21e_topology_t> logging_data_t;
+
+static_assert(sizeof(logging_data_t) == 662, "logging_data_t must match the BMU firmware");
+
+//884 base64 characters and the line feed
+static const int loggingLineLength = logging_line_length<spr21e_topology_t>();
+static_assert(loggingLineLength == 885, "Line length of the BMU firmware");
+
+#endif // LOGGINGDATA_H
@@ -0,0 +1,406 @@
+#include "logsummary.h"
+#include "bmsdecoder.h"
+#include <QDateTime>
+#include <QFile>
+#include <QtMath>
+#include <array>
+#include <cfloat>
+#include <cstring>
+
+template <class Topology>
+LogSummary<Topology>::LogSummary()
+{
+    clear();
+}
+
+template <class Topology>
+void LogSummary<Topology>::clear()
+{
+    clear_accumulator(voltages);
+    clear_accumulator(temperatures);
+    ::memset(voltageHistogram, 0, sizeof(voltageHistogram));
+    ::memset(temperatureHistogram, 0, sizeof(temperatureHistogram));
+    currentMin = DBL_MAX;
+    currentMax = -DBL_MAX;
+    currentSum = 0.0;
+    currentSquares = 0.0;
+    currentMinTime = 0;
+    currentMaxTime = 0;
+    ::memset(stateDuration, 0, sizeof(stateDuration));
+    ::memset(errorEvents, 0, sizeof(errorEvents));
+    recordCount = 0;
+    skippedLines = 0;
+    firstTime = 0;
+    lastTime = 0;
+    lastState = 0;
+    lastError = 0;
+}
+
+template <class Topology>
+void LogSummary<Topology>::add(const record_t &record)
+{
+    qint64 time = rtc_to_seconds(record.timestamp);
+
+    //Aligned copies, the record is packed
+    quint16 cells[Topology::cells];
+    quint16 sensors[Topology::sensors];
+    ::memcpy(cells, record.cellVoltage, sizeof(cells));
+    ::memcpy(sensors, record.temperature, sizeof(sensors));
+    update(voltages, cells, time);
+    update(temperatures, sensors, time);
+
+    //Scatter, does not vectorize
+    for (int i = 0; i < Topology::cells; i++) {
+        if (cells[i]) {
+            voltageHistogram[qMin(cells[i] / 10, voltageBins - 1)]++;
+        }
+    }
+    for (int i = 0; i < Topology::sensors; i++) {
+        if (sensors[i]) {
+            temperatureHistogram[qMin(sensors[i] / 10, temperatureBins - 1)]++;
+        }
+    }
+
+    float current;
+    ::memcpy(&current, &record.current, sizeof(float));
+    if (current < currentMin) {
+        currentMin = current;
+        currentMinTime = time;
+    }
+    if (current > currentMax) {
+        currentMax = current;
+        currentMaxTime = time;
+    }
+    currentSum += current;
+    currentSquares += (double)current * current;
+
+    if (recordCount == 0) {
+        firstTime = time;
+    } else {
+        qint64 dt = time - lastTime;
+        if ((dt >= 0) && (dt <= maxGap) && (lastState < stateCount)) {
+            stateDuration[lastState] += dt;
+        }
+    }
+    if ((record.stateMachineError != lastError) && (record.stateMachineError != 0)) {
+        errorEvents[qMin<int>(record.stateMachineError, errorCount - 1)]++;
+    }
+    lastState = record.stateMachineState;
+    lastError = record.stateMachineError;
+    lastTime = time;
+    recordCount++;
+}
+
+template <class Topology>
+bool LogSummary<Topology>::add_file(QString fileName, std::function<void(qint64, qint64)> progress)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    bool binary = fileName.endsWith(".bin", Qt::CaseInsensitive);
+    const qint64 chunkSize = 4 * 1024 * 1024;
+    QByteArray chunk(chunkSize, 0);
+    qint64 filled = 0;
+    qint64 total = 0;
+    record_t record;
+
+    //Large reads, records are decoded in place without per line allocations
+    while (true) {
+        qint64 count = file.read(chunk.data() + filled, chunkSize - filled);
+        if (count <= 0) {
+            break;
+        }
+        filled += count;
+        total += count;
+
+        const char *data = chunk.constData();
+        qint64 position = 0;
+        if (binary) {
+            for (; position + (qint64)sizeof(record_t) <= filled; position += sizeof(record_t)) {
+                ::memcpy(&record, data + position, sizeof(record_t));
+                add(record);
+            }
+        } else {
+            while (position < filled) {
+                const char *end = (const char *)::memchr(data + position, '\n', filled - position);
+                if (!end) {
+                    break;
+                }
+                int length = end - (data + position);
+                if ((length > 0) && (data[position + length - 1] == '\r')) {
+                    length--;
+                }
+                if (decode_base64(data + position, length, record)) {
+                    add(record);
+                } else if (length > 0) {
+                    skippedLines++;
+                }
+                position = end - data + 1;
+            }
+            //A line longer than a chunk can not be a record
+            if ((position == 0) && (filled == chunkSize)) {
+                skippedLines++;
+                position = filled;
+            }
+        }
+        ::memmove(chunk.data(), data + position, filled - position);
+        filled -= position;
+
+        if (progress) {
+            progress(total, file.size());
+        }
+    }
+    //Last line without a line feed
+    if (!binary && (filled > 0)) {
+        if (decode_base64(chunk.constData(), filled, record)) {
+            add(record);
+        } else {
+            skippedLines++;
+        }
+    }
+    return true;
+}
+
+template <class Topology>
+typename LogSummary<Topology>::channel_summary_t LogSummary<Topology>::voltage(int channel) const
+{
+    return summarize(voltages, channel, 0.001f);
+}
+
+template <class Topology>
+typename LogSummary<Topology>::channel_summary_t LogSummary<Topology>::temperature(int channel) const
+{
+    return summarize(temperatures, channel, 0.1f);
+}
+
+template <class Topology>
+typename LogSummary<Topology>::channel_summary_t LogSummary<Topology>::current() const
+{
+    channel_summary_t summary;
+    summary.count = recordCount;
+    summary.min = recordCount ? currentMin : 0.0f;
+    summary.max = recordCount ? currentMax : 0.0f;
+    summary.minTime = currentMinTime;
+    summary.maxTime = currentMaxTime;
+    double mean = recordCount ? currentSum / recordCount : 0.0;
+    summary.mean = mean;
+    summary.stddev = recordCount ? qSqrt(qMax(0.0, currentSquares / recordCount - mean * mean)) : 0.0;
+    return summary;
+}
+
+template <class Topology>
+QString LogSummary<Topology>::report() const
+{
+    auto time_to_string = [](qint64 time) {
+        return QDateTime::fromSecsSinceEpoch(time, Qt::UTC).toString("yyyy-MM-dd hh:mm:ss");
+    };
+
+    QString text;
+    text += QString("Records: %1 from %2 to %3\n").arg(recordCount)
+            .arg(time_to_string(firstTime)).arg(time_to_string(lastTime));
+    if (skippedLines) {
+        text += QString("Unreadable lines: %1\n").arg(skippedLines);
+    }
+
+    //Extremes over all channels
+    int lowest = -1, highest = -1, coldest = -1, hottest = -1;
+    for (int i = 0; i < Topology::cells; i++) {
+        if (!voltages.count[i]) {
+            continue;
+        }
+        if ((lowest < 0) || (voltages.min[i] < voltages.min[lowest])) {
+            lowest = i;
+        }
+        if ((highest < 0) || (voltages.max[i] > voltages.max[highest])) {
+            highest = i;
+        }
+    }
+    for (int i = 0; i < Topology::sensors; i++) {
+        if (!temperatures.count[i]) {
+            continue;
+        }
+        if ((coldest < 0) || (temperatures.min[i] < temperatures.min[coldest])) {
+            coldest = i;
+        }
+        if ((hottest < 0) || (temperatures.max[i] > temperatures.max[hottest])) {
+            hottest = i;
+        }
+    }
+    if (lowest >= 0) {
+        text += QString("Lowest cell: stack %1 cell %2, %3 V at %4\n").arg(lowest / Topology::cellsPerStack + 1).arg(lowest % Topology::cellsPerStack + 1)
+                .arg(voltages.min[lowest] * 0.001, 0, 'f', 3).arg(time_to_string(voltages.minTime[lowest]));
+        text += QString("Highest cell: stack %1 cell %2, %3 V at %4\n").arg(highest / Topology::cellsPerStack + 1).arg(highest % Topology::cellsPerStack + 1)
+                .arg(voltages.max[highest] * 0.001, 0, 'f', 3).arg(time_to_string(voltages.maxTime[highest]));
+    }
+    if (hottest >= 0) {
+        text += QString("Hottest sensor: stack %1 sensor %2, %3 °C at %4\n").arg(hottest / Topology::sensorsPerStack + 1).arg(hottest % Topology::sensorsPerStack + 1)
+                .arg(temperatures.max[hottest] * 0.1, 0, 'f', 1).arg(time_to_string(temperatures.maxTime[hottest]));
+        text += QString("Coldest sensor: stack %1 sensor %2, %3 °C at %4\n").arg(coldest / Topology::sensorsPerStack + 1).arg(coldest % Topology::sensorsPerStack + 1)
+                .arg(temperatures.min[coldest] * 0.1, 0, 'f', 1).arg(time_to_string(temperatures.minTime[coldest]));
+    }
+    channel_summary_t pack = current();
+    text += QString("Current: min %1 A at %2, max %3 A at %4, mean %5 A\n")
+            .arg(pack.min, 0, 'f', 2).arg(time_to_string(pack.minTime))
+            .arg(pack.max, 0, 'f', 2).arg(time_to_string(pack.maxTime)).arg(pack.mean, 0, 'f', 2);
+
+    text += "\nTime in state:\n";
+    qint64 totalDuration = 0;
+    for (int state = 0; state < stateCount; state++) {
+        totalDuration += stateDuration[state];
+    }
+    for (int state = 0; state < stateCount; state++) {
+        text += QString("  %1: %2 s (%3 %)\n").arg(BmsDecoder::ts_state_to_string((BmsDecoder::ts_state_t)state))
+                .arg(stateDuration[state]).arg(totalDuration ? 100.0 * stateDuration[state] / totalDuration : 0.0, 0, 'f', 1);
+    }
+    text += "\nErrors:\n";
+    for (int error = 1; error < errorCount; error++) {
+        text += QString("  %1 %2\n").arg(errorEvents[error])
+                .arg(BmsDecoder::error_to_string((BmsDecoder::error_code_t)error));
+    }
+
+    text += "\nCell voltage histogram (10 mV):\n";
+    for (int bin = 0; bin < voltageBins; bin++) {
+        if (voltageHistogram[bin]) {
+            text += QString("  %1 V: %2\n").arg(bin * 0.01, 0, 'f', 2).arg(voltageHistogram[bin]);
+        }
+    }
+    text += "\nTemperature histogram (1 °C):\n";
+    for (int bin = 0; bin < temperatureBins; bin++) {
+        if (temperatureHistogram[bin]) {
+            text += QString("  %1 °C: %2\n").arg(bin).arg(temperatureHistogram[bin]);
+        }
+    }
+
+    text += "\nChannel;Min;Min time;Max;Max time;Mean;Stddev\n";
+    auto channel_line = [&](QString name, const channel_summary_t &summary, int precision) {
+        text += QString("%1;%2;%3;%4;%5;%6;%7\n").arg(name)
+                .arg(summary.min, 0, 'f', precision).arg(time_to_string(summary.minTime))
+                .arg(summary.max, 0, 'f', precision).arg(time_to_string(summary.maxTime))
+                .arg(summary.mean, 0, 'f', precision + 1).arg(summary.stddev, 0, 'f', precision + 1);
+    };
+    for (int i = 0; i < Topology::cells; i++) {
+        if (voltages.count[i]) {
+            channel_line(QString("Cell %1").arg(i + 1), voltage(i), 3);
+        }
+    }
+    for (int i = 0; i < Topology::sensors; i++) {
+        if (temperatures.count[i]) {
+            channel_line(QString("Temperature %1").arg(i + 1), temperature(i), 1);
+        }
+    }
+    return text;
+}
+
+template <class Topology>
+template <int N>
+void LogSummary<Topology>::clear_accumulator(accumulator_t<N> &accumulator)
+{
+    ::memset(&accumulator, 0, sizeof(accumulator));
+    for (int i = 0; i < N; i++) {
+        accumulator.min[i] = 0xFFFF;
+    }
+}
+
+//Branch free, so the compiler can vectorize the loop over all channels (-fopenmp-simd)
+template <class Topology>
+template <int N>
+void LogSummary<Topology>::update(accumulator_t<N> &accumulator, const quint16 *values, qint64 time)
+{
+    quint16 *min = accumulator.min;
+    quint16 *max = accumulator.max;
+    qint64 *minTime = accumulator.minTime;
+    qint64 *maxTime = accumulator.maxTime;
+    quint64 *sum = accumulator.sum;
+    quint64 *squares = accumulator.squares;
+    quint64 *count = accumulator.count;
+    #pragma omp simd
+    for (int i = 0; i < N; i++) {
+        quint32 value = values[i];
+        quint32 valid = (value != 0);
+        bool lower = valid && (value < min[i]);
+        bool higher = value > max[i];
+        min[i] = lower ? value : min[i];
+        minTime[i] = lower ? time : minTime[i];
+        max[i] = higher ? value : max[i];
+        maxTime[i] = higher ? time : maxTime[i];
+        sum[i] += value;
+        squares[i] += value * value;
+        count[i] += valid;
+    }
+}
+
+template <class Topology>
+template <int N>
+typename LogSummary<Topology>::channel_summary_t LogSummary<Topology>::summarize(const accumulator_t<N> &accumulator, int channel, float scale)
+{
+    channel_summary_t summary;
+    summary.count = accumulator.count[channel];
+    if (!summary.count) {
+        ::memset(&summary, 0, sizeof(summary));
+        return summary;
+    }
+    double mean = (double)accumulator.sum[channel] / summary.count;
+    double variance = (double)accumulator.squares[channel] / summary.count - mean * mean;
+    summary.min = accumulator.min[channel] * scale;
+    summary.max = accumulator.max[channel] * scale;
+    summary.minTime = accumulator.minTime[channel];
+    summary.maxTime = accumulator.maxTime[channel];
+    summary.mean = mean * scale;
+    summary.stddev = qSqrt(qMax(0.0, variance)) * scale;
+    return summary;
+}
+
+//The RTC keeps local time, it is counted as if it was UTC and formatted the same way
+template <class Topology>
+qint64 LogSummary<Topology>::rtc_to_seconds(const rtc_date_time_t &rtc)
+{
+    //Days from civil, proleptic Gregorian calendar
+    qint64 year = rtc.year - (rtc.month <= 2);
+    qint64 era = (year >= 0 ? year : year - 399) / 400;
+    qint64 yearOfEra = year - era * 400;
+    qint64 month = rtc.month;
+    qint64 dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + rtc.day - 1;
+    qint64 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    qint64 days = era * 146097 + dayOfEra - 719468;
+    return days * 86400 + rtc.hour * 3600 + rtc.minute * 60 + rtc.second;
+}
+
+template <class Topology>
+bool LogSummary<Topology>::decode_base64(const char *line, int length, record_t &record)
+{
+    static const int encodedLength = (sizeof(record_t) + 2) / 3 * 4;
+    static const std::array<signed char, 256> table = [] {
+        std::array<signed char, 256> values;
+        values.fill(-1);
+        const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 64; i++) {
+            values[(quint8)alphabet[i]] = i;
+        }
+        return values;
+    }();
+    if (length != encodedLength) {
+        return false;
+    }
+
+    quint8 raw[encodedLength / 4 * 3];
+    int size = 0;
+    for (int i = 0; i < length; i += 4) {
+        int a = table[(quint8)line[i]];
+        int b = table[(quint8)line[i + 1]];
+        int c = (line[i + 2] == '=') ? 0 : table[(quint8)line[i + 2]];
+        int d = (line[i + 3] == '=') ? 0 : table[(quint8)line[i + 3]];
+        if ((a | b | c | d) < 0) {
+            return false;
+        }
+        quint32 group = (a << 18) | (b << 12) | (c << 6) | d;
+        raw[size++] = group >> 16;
+        raw[size++] = group >> 8;
+        raw[size++] = group;
+    }
+    ::memcpy(&record, raw, sizeof(record_t));
+    return true;
+}
+
+//One instantiation per entry of log_topologies_t
+template class LogSummary<spr21e_topology_t>;
@@ -0,0 +1,101 @@
+#ifndef LOGSUMMARY_H
+#define LOGSUMMARY_H
+
+#include <QString>
+#include <functional>
+#include "loggingdata.h"
+
+//Single pass statistics over BMU log records, without converting them.
+//Per channel min, max, mean and standard deviation with the time of the extremes, value histograms
+//over all channels, the time spent in every state and the number of errors.
+//Values of 0 are treated as missing, like the channels of stacks which are not connected.
+//Instantiated for every entry of log_topologies_t, so all channel loops have a fixed trip count.
+template <class Topology>
+class LogSummary
+{
+public:
+    typedef logging_record_t<Topology> record_t;
+
+    struct channel_summary_t {
+        float min;
+        float max;
+        float mean;
+        float stddev;
+        qint64 minTime; //RTC time as s since epoch
+        qint64 maxTime;
+        quint64 count;
+    };
+
+    static const int stateCount = 4;
+    static const int errorCount = 5;
+    static const int voltageBins = 500;     //10 mV
+    static const int temperatureBins = 103; //1 degC, the temperatures are 10 bit in 0.1 degC
+
+    LogSummary();
+
+    void clear();
+    void add(const record_t &record);
+    //Reads base64 lines or binary records (.bin), progress gets the bytes read and the file size
+    bool add_file(QString fileName, std::function<void(qint64, qint64)> progress = nullptr);
+
+    quint64 records() const { return recordCount; }
+    quint64 skipped() const { return skippedLines; }
+    channel_summary_t voltage(int channel) const;
+    channel_summary_t temperature(int channel) const;
+    channel_summary_t current() const;
+    qint64 state_duration(int state) const { return stateDuration[state]; } //s
+    quint32 errors(int error) const { return errorEvents[error]; }
+    const quint32 *voltage_histogram() const { return voltageHistogram; }
+    const quint32 *temperature_histogram() const { return temperatureHistogram; }
+
+    QString report() const;
+
+private:
+    //Gaps in the log longer than this are not counted as time in a state
+    static const qint64 maxGap = 10; //s
+
+    //Structure of arrays, so the updates of all channels vectorize
+    template <int N>
+    struct accumulator_t {
+        quint16 min[N];
+        quint16 max[N];
+        qint64 minTime[N];
+        qint64 maxTime[N];
+        quint64 sum[N];
+        quint64 squares[N];
+        quint64 count[N];
+    };
+
+    accumulator_t<Topology::cells> voltages;
+    accumulator_t<Topology::sensors> temperatures;
+    quint32 voltageHistogram[voltageBins];
+    quint32 temperatureHistogram[temperatureBins];
+
+    double currentMin;
+    double currentMax;
+    double currentSum;
+    double currentSquares;
+    qint64 currentMinTime;
+    qint64 currentMaxTime;
+
+    qint64 stateDuration[stateCount];
+    quint32 errorEvents[errorCount];
+    quint64 recordCount;
+    quint64 skippedLines;
+    qint64 firstTime;
+    qint64 lastTime;
+    quint8 lastState;
+    quint8 lastError;
+
+    template <int N>
+    static void clear_accumulator(accumulator_t<N> &accumulator);
+    template <int N>
+    static void update(accumulator_t<N> &accumulator, const quint16 *values, qint64 time);
+    template <int N>
+    static channel_summary_t summarize(const accumulator_t<N> &accumulator, int channel, float scale);
+
+    static qint64 rtc_to_seconds(const rtc_date_time_t &rtc);
+    static bool decode_base64(const char *line, int length, record_t &record);
+};
+
+#endif // LOGSUMMARY_H
@@ -0,0 +1,123 @@
+#include "packpublisher.h"
+#include <QDateTime>
+#include <QDebug>
+#include <signal.h>
+#include <unistd.h>
+
+PackPublisher::PackPublisher(const BmsDecoder *decoder, QObject *parent) : QObject(parent), decoder(decoder)
+{
+    ::memset(&snapshot, 0, sizeof(snapshot));
+}
+
+PackPublisher::~PackPublisher()
+{
+    close();
+}
+
+bool PackPublisher::open(QString name)
+{
+    close();
+    this->name = name.toLocal8Bit();
+
+    const packshm_segment_t *existing = packshm_open(this->name.constData());
+    if (existing) {
+        pid_t publisher = existing->publisher;
+        packshm_close(existing);
+        if ((publisher != 0) && (publisher != getpid()) && (kill(publisher, 0) == 0)) {
+            qWarning() << "Pack state is already published by process" << publisher;
+            return false;
+        }
+    }
+
+    segment = packshm_create(this->name.constData());
+    if (!segment) {
+        qWarning() << "Could not create shared memory segment" << name;
+        return false;
+    }
+    snapshot.updates = 0;
+    return true;
+}
+
+void PackPublisher::close()
+{
+    if (segment) {
+        packshm_destroy(segment, name.constData());
+        segment = nullptr;
+    }
+}
+
+void PackPublisher::set_balancing(const Balancing *balancing)
+{
+    this->balancing = balancing;
+}
+
+void PackPublisher::publish()
+{
+    if (!segment) {
+        return;
+    }
+    const BmsDecoder::bms_info_t &bmsInfo = decoder->info();
+    const BmsDecoder::pack_t &pack = decoder->pack();
+
+    snapshot.timestamp = QDateTime::currentMSecsSinceEpoch();
+    snapshot.updates++;
+
+    packshm_info_t &info = snapshot.info;
+    info.minCellVolt = bmsInfo.minCellVolt;
+    info.maxCellVolt = bmsInfo.maxCellVolt;
+    info.avgCellVolt = bmsInfo.avgCellVolt;
+    info.minSoc = bmsInfo.minSoc;
+    info.maxSoc = bmsInfo.maxSoc;
+    info.batteryVoltage = bmsInfo.batteryVoltage;
+    info.dcLinkVoltage = bmsInfo.dcLinkVoltage;
+    info.current = bmsInfo.current;
+    info.isoRes = bmsInfo.isoRes;
+    info.minTemp = bmsInfo.minTemp;
+    info.maxTemp = bmsInfo.maxTemp;
+    info.avgTemp = bmsInfo.avgTemp;
+    info.valid = (bmsInfo.minCellVoltValid ? PACKSHM_VALID_MIN_CELL_VOLT : 0)
+            | (bmsInfo.maxCellVoltValid ? PACKSHM_VALID_MAX_CELL_VOLT : 0)
+            | (bmsInfo.avgCellVoltValid ? PACKSHM_VALID_AVG_CELL_VOLT : 0)
+            | (bmsInfo.minSocValid ? PACKSHM_VALID_MIN_SOC : 0)
+            | (bmsInfo.maxSocValid ? PACKSHM_VALID_MAX_SOC : 0)
+            | (bmsInfo.batteryVoltageValid ? PACKSHM_VALID_BATTERY_VOLTAGE : 0)
+            | (bmsInfo.dcLinkVoltageValid ? PACKSHM_VALID_DC_LINK_VOLTAGE : 0)
+            | (bmsInfo.currentValid ? PACKSHM_VALID_CURRENT : 0)
+            | (bmsInfo.isoResValid ? PACKSHM_VALID_ISO_RES : 0)
+            | (bmsInfo.minTempValid ? PACKSHM_VALID_MIN_TEMP : 0)
+            | (bmsInfo.maxTempValid ? PACKSHM_VALID_MAX_TEMP : 0)
+            | (bmsInfo.avgTempValid ? PACKSHM_VALID_AVG_TEMP : 0);
+    info.imdStatus = bmsInfo.imdStatus;
+    info.imdScStatus = bmsInfo.imdScStatus;
+    info.amsStatus = bmsInfo.amsStatus;
+    info.amsScStatus = bmsInfo.amsScStatus;
+    info.shutdownStatus = bmsInfo.shutdownStatus;
+    info.tsState = bmsInfo.tsState;
+    info.error = bmsInfo.error;
+
+    //Same dimensions as the decoder, the arrays are copied as a whole
+    static_assert((bms_topology_t::stacks == PACKSHM_STACKS) && (bms_topology_t::cellsPerStack == PACKSHM_CELLS_PER_STACK)
+                  && (bms_topology_t::sensorsPerStack == PACKSHM_SENSORS_PER_STACK), "Topology does not match the segment");
+    static_assert(sizeof(snapshot.cellVoltage) == sizeof(pack.cellVoltages), "Layout mismatch");
+    static_assert(sizeof(snapshot.cellVoltageValidity) == sizeof(pack.cellVoltageValidity), "Layout mismatch");
+    static_assert(sizeof(snapshot.temperature) == sizeof(pack.temperatures), "Layout mismatch");
+    static_assert(sizeof(snapshot.temperatureValidity) == sizeof(pack.temperatureValidity), "Layout mismatch");
+    static_assert(sizeof(snapshot.uid) == sizeof(pack.uid), "Layout mismatch");
+    ::memcpy(snapshot.cellVoltage, pack.cellVoltages, sizeof(snapshot.cellVoltage));
+    ::memcpy(snapshot.cellVoltageValidity, pack.cellVoltageValidity, sizeof(snapshot.cellVoltageValidity));
+    ::memcpy(snapshot.temperature, pack.temperatures, sizeof(snapshot.temperature));
+    ::memcpy(snapshot.temperatureValidity, pack.temperatureValidity, sizeof(snapshot.temperatureValidity));
+    ::memcpy(snapshot.uid, pack.uid, sizeof(snapshot.uid));
+
+    for (int stack = 0; stack < PACKSHM_STACKS; stack++) {
+        quint16 cells = 0;
+        for (int cell = 0; balancing && (cell < PACKSHM_CELLS_PER_STACK); cell++) {
+            if (balancing->is_balancing(stack, cell)) {
+                cells |= (1 << cell);
+            }
+        }
+        snapshot.balancing[stack] = cells;
+    }
+
+    packshm_publish(segment, &snapshot);
+}
@@ -0,0 +1,34 @@
+#ifndef PACKPUBLISHER_H
+#define PACKPUBLISHER_H
+
+#include <QObject>
+#include "packshm.h"
+#include "bmsdecoder.h"
+#include "balancing.h"
+
+//Publishes the decoded pack state to a shared memory segment (see packshm.h),
+//so other local tools can read it without touching the bus or the viewer.
+class PackPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PackPublisher(const BmsDecoder *decoder, QObject *parent = nullptr);
+    ~PackPublisher();
+
+    //Fails if another process is already publishing under that name
+    bool open(QString name = PACKSHM_NAME);
+    void close();
+    bool is_open() const { return segment != nullptr; }
+
+    void set_balancing(const Balancing *balancing);
+    void publish();
+
+private:
+    const BmsDecoder *decoder;
+    const Balancing *balancing = nullptr;
+    packshm_segment_t *segment = nullptr;
+    packshm_snapshot_t snapshot;
+    QByteArray name;
+};
+
+#endif // PACKPUBLISHER_H
@@ -0,0 +1,85 @@
+#ifndef PACKTOPOLOGY_H
+#define PACKTOPOLOGY_H
+
+#include <QString>
+#include <QStringList>
+#include <type_traits>
+
+//Dimensions of a pack, every array sized by them has its size fixed at compile time.
+//Code which depends on the dimensions is written as a template over the topology, or uses
+//bms_topology_t for the pack on the bus.
+template <int Stacks, int CellsPerStack, int SensorsPerStack>
+struct pack_topology_t {
+    //The stack is sent in the upper nibble of the first payload byte
+    static_assert((Stacks > 0) && (Stacks <= 16), "The CAN layout addresses at most 16 stacks");
+    static_assert((CellsPerStack > 0) && (CellsPerStack <= 16), "The cell masks of a stack are 16 bit");
+    static_assert(SensorsPerStack > 0, "A stack needs at least one sensor");
+
+    static constexpr int stacks = Stacks;
+    static constexpr int cellsPerStack = CellsPerStack;
+    static constexpr int sensorsPerStack = SensorsPerStack;
+    static constexpr int cells = Stacks * CellsPerStack;
+    static constexpr int sensors = Stacks * SensorsPerStack;
+
+    static QString name()
+    {
+        return QString("%1 stacks, %2 cells, %3 sensors per stack").arg(stacks).arg(cellsPerStack).arg(sensorsPerStack);
+    }
+};
+
+typedef pack_topology_t<12, 12, 14> spr21e_topology_t;
+
+//The pack on the bus, selected at build time, e.g. DEFINES += BMS_STACKS=10
+#ifndef BMS_STACKS
+#define BMS_STACKS 12
+#endif
+#ifndef BMS_CELLS_PER_STACK
+#define BMS_CELLS_PER_STACK 12
+#endif
+#ifndef BMS_SENSORS_PER_STACK
+#define BMS_SENSORS_PER_STACK 14
+#endif
+
+typedef pack_topology_t<BMS_STACKS, BMS_CELLS_PER_STACK, BMS_SENSORS_PER_STACK> bms_topology_t;
+
+//The classic layout has 4 cell voltage frames, 3 temperature frames and a 12 bit balancing status per stack
+static_assert(bms_topology_t::cellsPerStack <= 12, "The classic CAN layout carries at most 12 cells per stack");
+static_assert(bms_topology_t::sensorsPerStack <= 14, "The classic CAN layout carries at most 14 sensors per stack");
+
+//Topologies the log tools can read, one instantiation of their code per entry.
+//Log files carry no header, the topology is selected at runtime by its index in the list.
+template <class... Topologies>
+struct topology_list_t {
+    static constexpr int count = sizeof...(Topologies);
+
+    static QStringList names()
+    {
+        return QStringList{Topologies::name()...};
+    }
+
+    //Calls function with a value of the selected topology type, false if the index is out of range
+    template <class Function>
+    static bool dispatch(int index, Function &&function)
+    {
+        int i = 0;
+        bool found = false;
+        auto call = [&](auto topology) {
+            if (!found && (i++ == index)) {
+                found = true;
+                function(topology);
+            }
+        };
+        (call(Topologies()), ...);
+        return found;
+    }
+
+    template <class Topology>
+    static constexpr bool contains()
+    {
+        return (std::is_same<Topology, Topologies>::value || ...);
+    }
+};
+
+typedef topology_list_t<spr21e_topology_t> log_topologies_t;
+
+#endif // PACKTOPOLOGY_H
@@ -0,0 +1,228 @@
+#include "sessionlogger.h"
+#include <QDateTime>
+#include <cstring>
+
+SessionLogger::SessionLogger(const BmsDecoder *decoder, QObject *parent) : QObject(parent), decoder(decoder)
+{
+    ::memset(&record, 0, sizeof(record_t));
+    writerBusy = false;
+
+    sampleTimer = new QTimer(this);
+    sampleTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(sampleTimer, &QTimer::timeout, this, &SessionLogger::sample);
+
+    //Large enough for either format, a buffer in flight is never resized by the sampling thread
+    for (QByteArray &buffer : buffers) {
+        buffer.reserve(recordsPerBuffer * qMax((int)sizeof(record_t), logging_line_length<bms_topology_t>()));
+    }
+
+    writerThread = new QThread(this);
+    writer = new QObject();
+    writer->moveToThread(writerThread);
+    QObject::connect(writerThread, &QThread::finished, writer, &QObject::deleteLater);
+    writerThread->start(QThread::LowPriority);
+}
+
+SessionLogger::~SessionLogger()
+{
+    stop();
+    writerThread->quit();
+    writerThread->wait();
+}
+
+void SessionLogger::start(QString fileName, format_t format, int intervalMs)
+{
+    stop();
+    //Records sampled before the file is open are queued behind the open on the writer thread
+    quint32 id = ++session;
+    QMetaObject::invokeMethod(writer, [=] { open_file(fileName, id); });
+
+    this->format = format;
+    recording = true;
+    written = 0;
+    dropped = 0;
+    sampleTimer->start(qMax(1, intervalMs));
+}
+
+void SessionLogger::stop()
+{
+    if (!recording) {
+        return;
+    }
+    sampleTimer->stop();
+    recording = false;
+    //The partial buffer goes with the close, the other one may still be in flight
+    QByteArray tail;
+    tail.swap(buffers[filling]);
+    buffers[filling].reserve(tail.capacity());
+    written += recordsInBuffer;
+    recordsInBuffer = 0;
+    QMetaObject::invokeMethod(writer, [=] { close_file(tail); });
+}
+
+void SessionLogger::update(quint32 frameId, quint8 stack)
+{
+    const BmsDecoder::bms_info_t &info = decoder->info();
+    const BmsDecoder::pack_t &pack = decoder->pack();
+
+    //Only the channels of the frame are copied, the others were cleared or are stale in the decoder
+    auto copy_cells = [&](int offset, int count) {
+        for (int cell = offset; cell < offset + count; cell++) {
+            record.cellVoltage[stack][cell] = pack.cellVoltages[stack][cell];
+        }
+    };
+    auto copy_temperatures = [&](int offset, int count) {
+        for (int sensor = offset; sensor < offset + count; sensor++) {
+            record.temperature[stack][sensor] = qRound(pack.temperatures[stack][sensor] * 10.0f);
+        }
+    };
+
+    switch (frameId) {
+    case BmsDecoder::ID_BMS_INFO_1:
+        record.minCellVolt = qRound(info.minCellVolt * 1000.0f);
+        record.maxCellVolt = qRound(info.maxCellVolt * 1000.0f);
+        record.avgCellVolt = qRound(info.avgCellVolt * 1000.0f);
+        record.minSoc = qRound(info.minSoc * 10.0f);
+        record.maxSoc = qRound(info.maxSoc * 10.0f);
+        break;
+    case BmsDecoder::ID_BMS_INFO_2:
+        record.current = info.current;
+        record.batteryVoltage = info.batteryVoltage;
+        record.dcLinkVoltage = info.dcLinkVoltage;
+        break;
+    case BmsDecoder::ID_BMS_INFO_3:
+        record.stateMachineState = info.tsState;
+        record.stateMachineError = info.error;
+        record.minTemperature = qRound(info.minTemp * 10.0f);
+        record.maxTemperature = qRound(info.maxTemp * 10.0f);
+        record.avgTemperature = qRound(info.avgTemp * 10.0f);
+        break;
+    }
+
+    if (stack >= bms_topology_t::stacks) {
+        return;
+    }
+
+    switch (frameId) {
+    case BmsDecoder::ID_CELL_VOLT_1:
+        copy_cells(0, BmsDecoder::frame_cells(0));
+        break;
+    case BmsDecoder::ID_CELL_VOLT_2:
+        copy_cells(3, BmsDecoder::frame_cells(3));
+        break;
+    case BmsDecoder::ID_CELL_VOLT_3:
+        copy_cells(6, BmsDecoder::frame_cells(6));
+        break;
+    case BmsDecoder::ID_CELL_VOLT_4:
+        copy_cells(9, BmsDecoder::frame_cells(9));
+        break;
+    case BmsDecoder::ID_CELL_TEMP_1:
+        copy_temperatures(0, BmsDecoder::frame_sensors(0));
+        break;
+    case BmsDecoder::ID_CELL_TEMP_2:
+        copy_temperatures(5, BmsDecoder::frame_sensors(5));
+        break;
+    case BmsDecoder::ID_CELL_TEMP_3:
+        copy_temperatures(10, BmsDecoder::frame_sensors(10));
+        break;
+    case BmsDecoder::ID_FD_CELL_VOLT:
+        copy_cells(0, bms_topology_t::cellsPerStack);
+        break;
+    case BmsDecoder::ID_FD_CELL_TEMP:
+        copy_temperatures(0, bms_topology_t::sensorsPerStack);
+        break;
+    }
+}
+
+SessionLogger::format_t SessionLogger::format_for(QString fileName)
+{
+    return fileName.endsWith(".bin", Qt::CaseInsensitive) ? FORMAT_BINARY : FORMAT_BASE64;
+}
+
+void SessionLogger::sample()
+{
+    //The BMU uses local time for its RTC
+    QDateTime now = QDateTime::currentDateTime();
+    record.timestamp.day = now.date().day();
+    record.timestamp.month = now.date().month();
+    record.timestamp.year = now.date().year();
+    record.timestamp.hour = now.time().hour();
+    record.timestamp.minute = now.time().minute();
+    record.timestamp.second = now.time().second();
+
+    QByteArray raw = QByteArray::fromRawData((const char *)&record, sizeof(record_t));
+    if (format == FORMAT_BINARY) {
+        buffers[filling].append(raw);
+    } else {
+        buffers[filling].append(raw.toBase64());
+        buffers[filling].append('\n');
+    }
+    if (++recordsInBuffer >= recordsPerBuffer) {
+        hand_over();
+    }
+}
+
+void SessionLogger::hand_over()
+{
+    if (recordsInBuffer == 0) {
+        return;
+    }
+    if (writerBusy.exchange(true)) {
+        dropped += recordsInBuffer;
+        buffers[filling].resize(0);
+        recordsInBuffer = 0;
+        return;
+    }
+
+    int index = filling;
+    written += recordsInBuffer;
+    filling ^= 1;
+    recordsInBuffer = 0;
+    QMetaObject::invokeMethod(writer, [=] { write_buffer(index); });
+}
+
+//Runs on the writer thread
+void SessionLogger::open_file(QString fileName, quint32 id)
+{
+    file = new QFile(fileName);
+    if (file->open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QString message = "Cannot open " + fileName + ": " + file->errorString();
+    delete file;
+    file = nullptr;
+    //Ends the recording unless it was stopped or restarted in the meantime
+    QMetaObject::invokeMethod(this, [=] {
+        if (id == session) {
+            stop();
+        }
+        emit failed(message);
+    });
+}
+
+//Runs on the writer thread, the buffers of a recording whose file did not open are discarded
+void SessionLogger::write_buffer(int index)
+{
+    if (file) {
+        if (file->write(buffers[index]) != buffers[index].size()) {
+            emit failed("Cannot write " + file->fileName() + ": " + file->errorString());
+        }
+        file->flush();
+    }
+    buffers[index].resize(0);
+    writerBusy = false;
+}
+
+//Runs on the writer thread
+void SessionLogger::close_file(QByteArray tail)
+{
+    if (!file) {
+        return;
+    }
+    if (file->write(tail) != tail.size()) {
+        emit failed("Cannot write " + file->fileName() + ": " + file->errorString());
+    }
+    file->close();
+    delete file;
+    file = nullptr;
+}
@@ -0,0 +1,77 @@
+#ifndef SESSIONLOGGER_H
+#define SESSIONLOGGER_H
+
+#include <QObject>
+#include <QFile>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include "bmsdecoder.h"
+#include "loggingdata.h"
+
+//Records the live session in the logging_data_t format of the BMU, sized for the pack on the bus.
+//Decoded frames update one record, which is sampled at the configured interval into a buffer.
+//Full buffers are handed to a writer thread while the other buffer is filled, so neither the
+//sampling nor the reception of frames waits for the disk. If the writer still holds the other
+//buffer when a buffer is full, the records of the full buffer are dropped and counted.
+//The file is opened, written, closed and deleted by the writer thread only, start() and stop()
+//return at once. A file which cannot be opened ends the recording and is reported by failed().
+class SessionLogger : public QObject
+{
+    Q_OBJECT
+public:
+    enum format_t {
+        FORMAT_BASE64, //Same lines as the SD card of the BMU
+        FORMAT_BINARY  //Records back to back
+    };
+
+    explicit SessionLogger(const BmsDecoder *decoder, QObject *parent = nullptr);
+    ~SessionLogger();
+
+    void start(QString fileName, format_t format, int intervalMs = 100);
+    void stop();
+    bool is_recording() const { return recording; }
+
+    //Updates the record from the decoder state, connect to BmsDecoder::decoded
+    void update(quint32 frameId, quint8 stack);
+
+    quint64 records() const { return written; }
+    quint64 dropped_records() const { return dropped; }
+
+    static format_t format_for(QString fileName);
+
+signals:
+    void failed(QString message);
+
+private:
+    static const int recordsPerBuffer = 64;
+
+    typedef logging_record_t<bms_topology_t> record_t;
+    static_assert(log_topologies_t::contains<bms_topology_t>(), "Session logs must be readable by the log tools");
+
+    const BmsDecoder *decoder;
+    record_t record;
+    QTimer *sampleTimer;
+    format_t format = FORMAT_BASE64;
+    bool recording = false;
+    quint32 session = 0; //Identifies the recording an open failure belongs to
+
+    QByteArray buffers[2];
+    int filling = 0;
+    int recordsInBuffer = 0;
+    std::atomic<bool> writerBusy;
+    quint64 written = 0;
+    quint64 dropped = 0;
+
+    QThread *writerThread;
+    QObject *writer;
+    QFile *file = nullptr; //Only used by the writer thread
+
+    void sample();
+    void hand_over();
+    void open_file(QString fileName, quint32 id);
+    void write_buffer(int index);
+    void close_file(QByteArray tail);
+};
+
+#endif // SESSIONLOGGER_H
@@ -0,0 +1,80 @@
+#include "streamclient.h"
+
+StreamClient::StreamClient(QObject *parent) : QObject(parent)
+{
+    socket = new QTcpSocket(this);
+    QObject::connect(socket, &QTcpSocket::connected, this, [=] {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        socket->write(stream_encode(STREAM_SUBSCRIBE, stream_encode_subscribe(subscription)));
+        emit connected();
+    });
+    QObject::connect(socket, &QTcpSocket::disconnected, this, &StreamClient::disconnected);
+    QObject::connect(socket, &QTcpSocket::readyRead, this, &StreamClient::data_received);
+    QObject::connect(socket, &QTcpSocket::errorOccurred, this, [=] {
+        emit error(socket->errorString());
+    });
+}
+
+void StreamClient::connect_to(const QString &host, quint16 port)
+{
+    disconnect_from();
+    decoder.clear();
+    deltaDecoder.reset();
+    gapCount = 0;
+    socket->connectToHost(host, port);
+}
+
+void StreamClient::disconnect_from()
+{
+    socket->abort();
+}
+
+void StreamClient::subscribe(const QVector<quint32> &ids)
+{
+    subscription = ids;
+    if (is_connected()) {
+        socket->write(stream_encode(STREAM_SUBSCRIBE, stream_encode_subscribe(subscription)));
+    }
+}
+
+void StreamClient::data_received()
+{
+    decoder.append(socket->readAll());
+
+    stream_message_t message;
+    while (decoder.next(message)) {
+        switch (message.type) {
+        case STREAM_HELLO: {
+            quint16 version;
+            quint16 interval;
+            if (!stream_decode_hello(message.payload, version, interval) || (version != streamProtocolVersion)) {
+                emit error("Incompatible telemetry server");
+                socket->abort();
+                return;
+            }
+            break;
+        }
+        case STREAM_BATCH: {
+            QVector<QCanBusFrame> frames;
+            bool gap = false;
+            bool valid = deltaDecoder.decode(message.payload, frames, gap);
+            if (gap) {
+                gapCount++;
+            }
+            for (const QCanBusFrame &frame : qAsConst(frames)) {
+                emit new_frame(frame);
+            }
+            if (!valid) {
+                emit error("Malformed telemetry batch");
+                socket->abort();
+                return;
+            }
+            break;
+        }
+        }
+    }
+    if (decoder.error()) {
+        emit error("Telemetry stream out of sync");
+        socket->abort();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef STREAMCLIENT_H
+#define STREAMCLIENT_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include "streamprotocol.h"
+
+//Receives the frames of a remote bus from a StreamServer.
+//Frames are emitted one by one with their original timestamps, like the frames of a local device.
+class StreamClient : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamClient(QObject *parent = nullptr);
+
+    void connect_to(const QString &host, quint16 port = streamDefaultPort);
+    void disconnect_from();
+    bool is_connected() const { return socket->state() == QAbstractSocket::ConnectedState; }
+
+    //Only these frame ids are sent by the server, an empty list subscribes to all frames
+    void subscribe(const QVector<quint32> &ids);
+
+    quint64 gaps() const { return gapCount; }
+
+signals:
+    void new_frame(QCanBusFrame frame);
+    void connected();
+    void disconnected();
+    void error(QString);
+
+private:
+    QTcpSocket *socket;
+    StreamDecoder decoder;
+    DeltaDecoder deltaDecoder;
+    QVector<quint32> subscription;
+    quint64 gapCount = 0;
+
+    void data_received();
+};
+
+#endif // STREAMCLIENT_H
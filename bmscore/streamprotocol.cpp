@@ -0,0 +1,229 @@
+#include "streamprotocol.h"
+#include <QtEndian>
+
+namespace {
+
+const int maxFramePayload = 64;
+
+void append_varint(QByteArray &out, quint64 value)
+{
+    do {
+        quint8 byte = value & 0x7F;
+        value >>= 7;
+        if (value) {
+            byte |= 0x80;
+        }
+        out.append((char)byte);
+    } while (value);
+}
+
+bool read_varint(const QByteArray &in, int &position, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= in.size()) {
+            return false;
+        }
+        quint8 byte = (quint8)in.at(position++);
+        value |= (quint64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+qint64 timestamp_us(const QCanBusFrame &frame)
+{
+    return frame.timeStamp().seconds() * 1000000LL + frame.timeStamp().microSeconds();
+}
+
+}
+
+QByteArray stream_encode(quint8 type, const QByteArray &payload)
+{
+    QByteArray message(5, 0);
+    qToLittleEndian<quint32>(payload.size(), message.data());
+    message[4] = (char)type;
+    message.append(payload);
+    return message;
+}
+
+QByteArray stream_encode_hello(quint16 interval)
+{
+    QByteArray payload(4, 0);
+    qToLittleEndian<quint16>(streamProtocolVersion, payload.data());
+    qToLittleEndian<quint16>(interval, payload.data() + 2);
+    return payload;
+}
+
+bool stream_decode_hello(const QByteArray &payload, quint16 &version, quint16 &interval)
+{
+    if (payload.size() < 4) {
+        return false;
+    }
+    version = qFromLittleEndian<quint16>(payload.constData());
+    interval = qFromLittleEndian<quint16>(payload.constData() + 2);
+    return true;
+}
+
+QByteArray stream_encode_subscribe(const QVector<quint32> &ids)
+{
+    QByteArray payload(ids.size() * 4, 0);
+    for (int i = 0; i < ids.size(); i++) {
+        qToLittleEndian<quint32>(ids.at(i), payload.data() + 4 * i);
+    }
+    return payload;
+}
+
+QVector<quint32> stream_decode_subscribe(const QByteArray &payload)
+{
+    QVector<quint32> ids;
+    for (int i = 0; i + 4 <= payload.size(); i += 4) {
+        ids.append(qFromLittleEndian<quint32>(payload.constData() + i));
+    }
+    return ids;
+}
+
+QByteArray DeltaEncoder::encode(const QVector<QCanBusFrame> &frames, bool gap)
+{
+    QByteArray batch(9, 0);
+    batch[0] = (char)(gap ? STREAM_BATCH_GAP : 0);
+    qint64 last = frames.isEmpty() ? 0 : timestamp_us(frames.first());
+    qToLittleEndian<qint64>(last, batch.data() + 1);
+
+    for (const QCanBusFrame &frame : frames) {
+        const QByteArray payload = frame.payload().left(maxFramePayload);
+        qint64 time = timestamp_us(frame);
+        append_varint(batch, frame.frameId());
+        //Out of order timestamps are clamped, the receiver sees the same clamped value
+        append_varint(batch, qMax<qint64>(0, time - last));
+        last = qMax(last, time);
+
+        quint8 flags = (frame.hasExtendedFrameFormat() ? STREAM_FRAME_EXTENDED : 0)
+                | (frame.hasFlexibleDataRateFormat() ? STREAM_FRAME_FD : 0);
+        auto it = previous.find(frame.frameId());
+        if ((it == previous.end()) || (it->size() != payload.size())) {
+            batch.append((char)(flags | STREAM_FRAME_FULL));
+            batch.append((char)payload.size());
+            batch.append(payload);
+        } else {
+            batch.append((char)flags);
+            batch.append((char)payload.size());
+            int mask = batch.size();
+            batch.append(QByteArray((payload.size() + 7) / 8, 0));
+            for (int i = 0; i < payload.size(); i++) {
+                if (payload.at(i) != it->at(i)) {
+                    batch[mask + i / 8] = (char)(batch.at(mask + i / 8) | (1 << (i % 8)));
+                    batch.append(payload.at(i));
+                }
+            }
+        }
+        previous.insert(frame.frameId(), payload);
+    }
+    return batch;
+}
+
+void DeltaEncoder::reset()
+{
+    previous.clear();
+}
+
+bool DeltaDecoder::decode(const QByteArray &batch, QVector<QCanBusFrame> &frames, bool &gap)
+{
+    if (batch.size() < 9) {
+        return false;
+    }
+    gap = batch.at(0) & STREAM_BATCH_GAP;
+    qint64 time = qFromLittleEndian<qint64>(batch.constData() + 1);
+
+    int position = 9;
+    while (position < batch.size()) {
+        quint64 id;
+        quint64 delta;
+        if (!read_varint(batch, position, id) || !read_varint(batch, position, delta)
+                || (position + 2 > batch.size())) {
+            return false;
+        }
+        quint8 flags = (quint8)batch.at(position);
+        int length = (quint8)batch.at(position + 1);
+        position += 2;
+        if (length > maxFramePayload) {
+            return false;
+        }
+
+        QByteArray payload;
+        if (flags & STREAM_FRAME_FULL) {
+            if (position + length > batch.size()) {
+                return false;
+            }
+            payload = batch.mid(position, length);
+            position += length;
+        } else {
+            auto it = previous.constFind((quint32)id);
+            int maskSize = (length + 7) / 8;
+            if ((it == previous.constEnd()) || (it->size() != length) || (position + maskSize > batch.size())) {
+                return false;
+            }
+            payload = *it;
+            int mask = position;
+            position += maskSize;
+            for (int i = 0; i < length; i++) {
+                if (!(batch.at(mask + i / 8) & (1 << (i % 8)))) {
+                    continue;
+                }
+                if (position >= batch.size()) {
+                    return false;
+                }
+                payload[i] = batch.at(position++);
+            }
+        }
+        previous.insert((quint32)id, payload);
+
+        time += (qint64)delta;
+        QCanBusFrame frame((quint32)id, payload);
+        frame.setExtendedFrameFormat(flags & STREAM_FRAME_EXTENDED);
+        frame.setFlexibleDataRateFormat(flags & STREAM_FRAME_FD);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(time));
+        frames.append(frame);
+    }
+    return true;
+}
+
+void DeltaDecoder::reset()
+{
+    previous.clear();
+}
+
+void StreamDecoder::append(const QByteArray &data)
+{
+    buffer.append(data);
+}
+
+bool StreamDecoder::next(stream_message_t &message)
+{
+    if (invalid || (buffer.size() < headerSize)) {
+        return false;
+    }
+    quint32 length = qFromLittleEndian<quint32>(buffer.constData());
+    if (length > maxPayload) {
+        //Out of sync, the stream can not be recovered
+        invalid = true;
+        buffer.clear();
+        return false;
+    }
+    if ((quint32)buffer.size() < headerSize + length) {
+        return false;
+    }
+
+    message.type = (quint8)buffer.at(4);
+    message.payload = buffer.mid(headerSize, length);
+    buffer.remove(0, headerSize + length);
+    return true;
+}
+
+void StreamDecoder::clear()
+{
+    buffer.clear();
+    invalid = false;
+}
@@ -0,0 +1,87 @@
+#ifndef STREAMPROTOCOL_H
+#define STREAMPROTOCOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include <QCanBusFrame>
+
+//Telemetry stream between a capture node and remote viewers over TCP.
+//Every message is a 5 byte little endian header followed by the payload:
+//  quint32 payload length, quint8 type
+//The server sends the raw frames of the bus in batches, one batch per interval.
+
+enum stream_type_t : quint8 {
+    STREAM_HELLO = 1,    //Server -> client: quint16 protocol version, quint16 batch interval in ms
+    STREAM_SUBSCRIBE,    //Client -> server: quint32 frame ids, empty for all frames
+    STREAM_BATCH         //Server -> client: delta encoded frames
+};
+
+struct stream_message_t {
+    quint8 type;
+    QByteArray payload;
+};
+
+static const quint16 streamProtocolVersion = 1;
+static const quint16 streamDefaultPort = 29536;
+
+QByteArray stream_encode(quint8 type, const QByteArray &payload = QByteArray());
+QByteArray stream_encode_hello(quint16 interval);
+bool stream_decode_hello(const QByteArray &payload, quint16 &version, quint16 &interval);
+QByteArray stream_encode_subscribe(const QVector<quint32> &ids);
+QVector<quint32> stream_decode_subscribe(const QByteArray &payload);
+
+//Batch: quint8 flags, qint64 timestamp of the first frame in us, then for every frame:
+//  varint frame id, varint us since the previous frame, quint8 frame flags, quint8 length,
+//  the complete payload if STREAM_FRAME_FULL is set, otherwise a bit mask with one bit per
+//  payload byte followed by the bytes which changed since the last frame with this id.
+enum stream_batch_flags_t : quint8 {
+    STREAM_BATCH_GAP = 0x01   //Batches have been dropped before this one
+};
+
+enum stream_frame_flags_t : quint8 {
+    STREAM_FRAME_FULL     = 0x01,
+    STREAM_FRAME_EXTENDED = 0x02,
+    STREAM_FRAME_FD       = 0x04
+};
+
+//Both ends keep the last payload of every frame id, so only the changed bytes are sent.
+//A reset encoder sends every id in full again, the decoder must be reset with it.
+class DeltaEncoder
+{
+public:
+    QByteArray encode(const QVector<QCanBusFrame> &frames, bool gap = false);
+    void reset();
+
+private:
+    QHash<quint32, QByteArray> previous;
+};
+
+class DeltaDecoder
+{
+public:
+    //Returns false on a malformed batch, frames decoded so far are kept
+    bool decode(const QByteArray &batch, QVector<QCanBusFrame> &frames, bool &gap);
+    void reset();
+
+private:
+    QHash<quint32, QByteArray> previous;
+};
+
+//Reassembles messages from a byte stream, independent of how the reads are split
+class StreamDecoder
+{
+public:
+    void append(const QByteArray &data);
+    bool next(stream_message_t &message);
+    bool error() const { return invalid; }
+    void clear();
+
+private:
+    static const int headerSize = 5;
+    static const quint32 maxPayload = 4 * 1024 * 1024;
+    QByteArray buffer;
+    bool invalid = false;
+};
+
+#endif // STREAMPROTOCOL_H
@@ -0,0 +1,136 @@
+#include "streamserver.h"
+
+StreamServer::StreamServer(QObject *parent) : QObject(parent)
+{
+    server = new QTcpServer(this);
+    QObject::connect(server, &QTcpServer::newConnection, this, &StreamServer::new_connection);
+
+    batchTimer = new QTimer(this);
+    batchTimer->setTimerType(Qt::PreciseTimer);
+    batchTimer->setInterval(20);
+    QObject::connect(batchTimer, &QTimer::timeout, this, &StreamServer::send_batch);
+}
+
+StreamServer::~StreamServer()
+{
+    close();
+}
+
+bool StreamServer::listen(quint16 port, const QHostAddress &address)
+{
+    close();
+    if (!server->listen(address, port)) {
+        return false;
+    }
+    batchTimer->start();
+    return true;
+}
+
+void StreamServer::close()
+{
+    batchTimer->stop();
+    server->close();
+    const QList<QTcpSocket *> sockets = clients.keys();
+    for (QTcpSocket *socket : sockets) {
+        remove_client(socket);
+    }
+    pending.clear();
+}
+
+void StreamServer::set_interval(int milliseconds)
+{
+    batchTimer->setInterval(qMax(1, milliseconds));
+}
+
+void StreamServer::set_queue_limit(qint64 bytes)
+{
+    queueLimit = bytes;
+}
+
+void StreamServer::add_frame(const QCanBusFrame &frame)
+{
+    if (clients.isEmpty()) {
+        return;
+    }
+    pending.append(frame);
+}
+
+void StreamServer::new_connection()
+{
+    while (server->hasPendingConnections()) {
+        QTcpSocket *socket = server->nextPendingConnection();
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        clients.insert(socket, client_t());
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [=] { message_from_client(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [=] { remove_client(socket); });
+        socket->write(stream_encode(STREAM_HELLO, stream_encode_hello(batchTimer->interval())));
+        emit clients_changed(clients.size());
+    }
+}
+
+void StreamServer::message_from_client(QTcpSocket *socket)
+{
+    auto it = clients.find(socket);
+    if (it == clients.end()) {
+        return;
+    }
+    it->decoder.append(socket->readAll());
+
+    stream_message_t message;
+    while (it->decoder.next(message)) {
+        if (message.type == STREAM_SUBSCRIBE) {
+            const QVector<quint32> ids = stream_decode_subscribe(message.payload);
+            it->subscription = QSet<quint32>(ids.begin(), ids.end());
+        }
+    }
+    if (it->decoder.error()) {
+        socket->abort();
+    }
+}
+
+void StreamServer::remove_client(QTcpSocket *socket)
+{
+    if (!clients.remove(socket)) {
+        return;
+    }
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+    emit clients_changed(clients.size());
+}
+
+void StreamServer::send_batch()
+{
+    if (pending.isEmpty()) {
+        return;
+    }
+
+    QVector<QCanBusFrame> selected;
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+        QTcpSocket *socket = it.key();
+        client_t &client = it.value();
+        //Dropped before encoding, so the delta state of both ends stays the same
+        if (socket->bytesToWrite() > queueLimit) {
+            client.gap = true;
+            dropped++;
+            continue;
+        }
+
+        const QVector<QCanBusFrame> *frames = &pending;
+        if (!client.subscription.isEmpty()) {
+            selected.clear();
+            for (const QCanBusFrame &frame : qAsConst(pending)) {
+                if (client.subscription.contains(frame.frameId())) {
+                    selected.append(frame);
+                }
+            }
+            frames = &selected;
+        }
+        if (frames->isEmpty()) {
+            continue;
+        }
+        socket->write(stream_encode(STREAM_BATCH, client.encoder.encode(*frames, client.gap)));
+        client.gap = false;
+    }
+    pending.clear();
+}
@@ -0,0 +1,62 @@
+#ifndef STREAMSERVER_H
+#define STREAMSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+#include "streamprotocol.h"
+
+//Serves the frames of the bus to remote viewers over TCP.
+//Frames are collected for one interval and sent as one delta encoded batch per client.
+//Each client only gets the ids it subscribed to. A client whose socket buffer exceeds the
+//queue limit loses whole batches instead of delaying the others. The next batch is flagged,
+//and the delta state stays consistent because dropped batches are never encoded.
+class StreamServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamServer(QObject *parent = nullptr);
+    ~StreamServer();
+
+    bool listen(quint16 port = streamDefaultPort, const QHostAddress &address = QHostAddress::Any);
+    void close();
+    bool is_listening() const { return server->isListening(); }
+    quint16 port() const { return server->serverPort(); }
+    QString errorString() const { return server->errorString(); }
+
+    void set_interval(int milliseconds);
+    void set_queue_limit(qint64 bytes);
+
+    void add_frame(const QCanBusFrame &frame);
+
+    int client_count() const { return clients.size(); }
+    quint64 dropped_batches() const { return dropped; }
+
+signals:
+    void clients_changed(int count);
+
+private:
+    struct client_t {
+        StreamDecoder decoder;
+        DeltaEncoder encoder;
+        QSet<quint32> subscription; //Empty for all frames
+        bool gap = false;
+    };
+
+    QTcpServer *server;
+    QTimer *batchTimer;
+    QHash<QTcpSocket *, client_t> clients;
+    QVector<QCanBusFrame> pending;
+    qint64 queueLimit = 1024 * 1024;
+    quint64 dropped = 0;
+
+    void new_connection();
+    void message_from_client(QTcpSocket *socket);
+    void remove_client(QTcpSocket *socket);
+    void send_batch();
+};
+
+#endif // STREAMSERVER_H
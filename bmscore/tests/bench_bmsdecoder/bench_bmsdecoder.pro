@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = bench_bmsdecoder
+
+SOURCES += \
+    main.cpp
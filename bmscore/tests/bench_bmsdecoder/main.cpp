@@ -0,0 +1,148 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVector>
+#include "balancing.h"
+#include "bmsdecoder.h"
+#include "referenceencoder.h"
+
+//Decode cost of every BMU frame in ns/frame and heap allocations/frame.
+//Allocations are counted by wrapping the allocator of glibc, which exports it as __libc_*.
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+}
+
+namespace {
+
+bool counting = false;
+quint64 allocations = 0;
+
+struct bench_t {
+    QString name;
+    QCanBusFrame frame;
+};
+
+struct result_t {
+    double nsPerFrame;
+    double allocationsPerFrame;
+};
+
+template <class Function>
+result_t measure(int frames, Function &&function)
+{
+    //Warm up caches and the lazily allocated parts of Qt
+    for (int i = 0; i < 1000; i++) {
+        function();
+    }
+
+    allocations = 0;
+    counting = true;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; i++) {
+        function();
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    counting = false;
+    return {(double)elapsed / frames, (double)allocations / frames};
+}
+
+QVector<bench_t> frames()
+{
+    ReferenceEncoder::stack_t values = {};
+    for (int cell = 0; cell < ReferenceEncoder::cellsPerStack; cell++) {
+        values.cellVoltages[cell] = 3600 + cell;
+    }
+    for (int sensor = 0; sensor < ReferenceEncoder::sensorsPerStack; sensor++) {
+        values.temperatures[sensor] = 250 + sensor;
+    }
+    values.uid = 0x12345678;
+    values.balancing = 0x0F0;
+
+    ReferenceEncoder::bms_info_1_t info1 = {3300, 4100, 3700, 500, 520, true, true, true, true, true};
+    ReferenceEncoder::bms_info_2_t info2 = {5300, 5290, -800, true, true, true};
+    ReferenceEncoder::bms_info_3_t info3 = {20000, true, true, BmsDecoder::TS_STATE_OPERATE, true, true, true, true,
+                                            BmsDecoder::ERROR_NO_ERROR, 250, 310, 280, true, true, true};
+
+    QVector<bench_t> benches;
+    benches.append({"0x1", ReferenceEncoder::bms_info_1(info1)});
+    benches.append({"0x2", ReferenceEncoder::bms_info_2(info2)});
+    benches.append({"0x3", ReferenceEncoder::bms_info_3(info3)});
+    for (int index = 0; index < 3; index++) {
+        benches.append({QString("0x%1").arg(BmsDecoder::ID_CELL_TEMP_1 + index, 0, 16),
+                        ReferenceEncoder::cell_temperatures(5, index, values)});
+    }
+    for (int index = 0; index < 4; index++) {
+        benches.append({QString("0x%1").arg(BmsDecoder::ID_CELL_VOLT_1 + index, 0, 16),
+                        ReferenceEncoder::cell_voltages(5, index, values)});
+    }
+    benches.append({"0xb", ReferenceEncoder::uid(5, values)});
+    benches.append({"0x10", ReferenceEncoder::fd_cell_voltages(5, values)});
+    benches.append({"0x11", ReferenceEncoder::fd_cell_temperatures(5, values)});
+    return benches;
+}
+
+}
+
+extern "C" void *malloc(size_t size)
+{
+    if (counting) {
+        allocations++;
+    }
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if (counting) {
+        allocations++;
+    }
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    if (counting) {
+        allocations++;
+    }
+    return __libc_realloc(pointer, size);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the decode cost of the BMU frames");
+    parser.addHelpOption();
+    QCommandLineOption framesOption({"n", "frames"}, "Frames decoded per ID", "count", "1000000");
+    parser.addOption(framesOption);
+    parser.process(app);
+
+    int count = parser.value(framesOption).toInt();
+    if (count <= 0) {
+        qCritical() << "The frame count must be positive";
+        return 1;
+    }
+
+    BmsDecoder decoder;
+    const QVector<bench_t> benches = frames();
+    qInfo().noquote() << QString("%1 %2 %3").arg("ID", -6).arg("ns/frame", 10).arg("allocations/frame", 18);
+    for (const bench_t &bench : benches) {
+        result_t result = measure(count, [&]() { decoder.decode(bench.frame); });
+        qInfo().noquote() << QString("%1 %2 %3").arg(bench.name, -6)
+                             .arg(result.nsPerFrame, 10, 'f', 1).arg(result.allocationsPerFrame, 18, 'f', 2);
+    }
+
+    ReferenceEncoder::stack_t values = {};
+    values.balancing = 0xA5A;
+    const QByteArray balancingPayload = ReferenceEncoder::balancing(5, values).payload();
+    Balancing balancing;
+    result_t result = measure(count, [&]() { balancing.merge_activity(balancingPayload); });
+    qInfo().noquote() << QString("%1 %2 %3").arg("0xe", -6)
+                         .arg(result.nsPerFrame, 10, 'f', 1).arg(result.allocationsPerFrame, 18, 'f', 2);
+    return 0;
+}
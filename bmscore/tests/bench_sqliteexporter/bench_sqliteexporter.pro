@@ -0,0 +1,14 @@
+include(../tests.pri)
+
+QT += sql
+
+TARGET = bench_sqliteexporter
+
+INCLUDEPATH += $$PWD/../../../spr21e-bms-viewer
+
+SOURCES += \
+    main.cpp \
+    $$PWD/../../../spr21e-bms-viewer/sqliteexporter.cpp
+
+HEADERS += \
+    $$PWD/../../../spr21e-bms-viewer/sqliteexporter.h
@@ -0,0 +1,72 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include "loggingdata.h"
+#include "sqliteexporter.h"
+
+//Load rate of SqliteExporter in records/s and rows/s, from open() to the end of finish(),
+//so the index build and the checkpoint are included
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the SQLite export of BMU log records");
+    parser.addHelpOption();
+    QCommandLineOption recordsOption({"n", "records"}, "Records loaded", "count", "100000");
+    QCommandLineOption outputOption({"o", "output"}, "Database file, a temporary file if not set", "file");
+    parser.addOption(recordsOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    int count = parser.value(recordsOption).toInt();
+    if (count <= 0) {
+        qCritical() << "The record count must be positive";
+        return 1;
+    }
+
+    QTemporaryDir directory;
+    QString fileName = parser.isSet(outputOption) ? parser.value(outputOption) : directory.filePath("bench.db");
+
+    logging_data_t data = {};
+    data.timestamp = {1, 6, 2021, 12, 0, 0};
+    data.current = -12.5f;
+    data.batteryVoltage = 520.0f;
+    data.dcLinkVoltage = 519.0f;
+    data.stateMachineState = 3;
+
+    SqliteExporter exporter;
+    QElapsedTimer timer;
+    timer.start();
+    if (!exporter.open(fileName, spr21e_topology_t::cells, spr21e_topology_t::sensors)) {
+        qCritical().noquote() << exporter.error();
+        return 1;
+    }
+    for (int record = 0; record < count; record++) {
+        for (int stack = 0; stack < spr21e_topology_t::stacks; stack++) {
+            for (int cell = 0; cell < spr21e_topology_t::cellsPerStack; cell++) {
+                data.cellVoltage[stack][cell] = 3600 + (record + cell) % 200;
+            }
+            for (int sensor = 0; sensor < spr21e_topology_t::sensorsPerStack; sensor++) {
+                data.temperature[stack][sensor] = 250 + (record + sensor) % 100;
+            }
+        }
+        data.timestamp.second = record % 60;
+        if (!exporter.append(data)) {
+            qCritical().noquote() << exporter.error();
+            return 1;
+        }
+    }
+    if (!exporter.finish()) {
+        qCritical().noquote() << exporter.error();
+        return 1;
+    }
+    double seconds = timer.nsecsElapsed() * 1e-9;
+
+    qint64 rows = (qint64)count * (1 + spr21e_topology_t::cells + spr21e_topology_t::sensors);
+    qInfo().noquote() << QString("%1 records, %2 rows in %3 s").arg(count).arg(rows).arg(seconds, 0, 'f', 2);
+    qInfo().noquote() << QString("%1 records/s, %2 rows/s").arg(count / seconds, 0, 'f', 0).arg(rows / seconds, 0, 'f', 0);
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "referenceencoder.h"
+#include "bmsdecoder.h"
+
+//Fields are written MSB first, unused bits are skipped and stay 0
+namespace {
+
+class BitWriter
+{
+public:
+    explicit BitWriter(int bytes) : payload(bytes, 0) {}
+
+    void put(quint32 value, int bits)
+    {
+        for (int i = bits - 1; i >= 0; i--) {
+            if ((value >> i) & 0x01) {
+                payload[position / 8] = (char)((quint8)payload.at(position / 8) | (0x80 >> (position % 8)));
+            }
+            position++;
+        }
+    }
+
+    void skip(int bits) { position += bits; }
+
+    QByteArray payload;
+
+private:
+    int position = 0;
+};
+
+}
+
+QCanBusFrame ReferenceEncoder::bms_info_1(const bms_info_1_t &info)
+{
+    BitWriter writer(8);
+    writer.put(info.minCellVolt, 13);
+    writer.put(info.minCellVoltValid, 1);
+    writer.put(info.maxCellVolt, 13);
+    writer.put(info.maxCellVoltValid, 1);
+    writer.put(info.avgCellVolt, 13);
+    writer.put(info.avgCellVoltValid, 1);
+    writer.put(info.minSoc, 10);
+    writer.put(info.minSocValid, 1);
+    writer.put(info.maxSoc, 10);
+    writer.put(info.maxSocValid, 1);
+    return QCanBusFrame(BmsDecoder::ID_BMS_INFO_1, writer.payload);
+}
+
+QCanBusFrame ReferenceEncoder::bms_info_2(const bms_info_2_t &info)
+{
+    BitWriter writer(7);
+    writer.put(info.batteryVoltage, 13);
+    writer.put(info.batteryVoltageValid, 1);
+    writer.skip(2);
+    writer.put(info.dcLinkVoltage, 13);
+    writer.put(info.dcLinkVoltageValid, 1);
+    writer.skip(2);
+    writer.put((quint16)info.current, 16);
+    writer.put(info.currentValid, 1);
+    return QCanBusFrame(BmsDecoder::ID_BMS_INFO_2, writer.payload);
+}
+
+QCanBusFrame ReferenceEncoder::bms_info_3(const bms_info_3_t &info)
+{
+    BitWriter writer(8);
+    writer.put(info.isoRes, 15);
+    writer.put(info.isoResValid, 1);
+    writer.put(info.shutdownStatus, 1);
+    writer.put(info.tsState, 2);
+    writer.put(info.amsScStatus, 1);
+    writer.put(info.amsStatus, 1);
+    writer.put(info.imdScStatus, 1);
+    writer.put(info.imdStatus, 1);
+    writer.skip(1);
+    writer.put(info.error, 7);
+    writer.put(info.minTemp, 10);
+    writer.put(info.minTempValid, 1);
+    writer.put(info.maxTemp, 10);
+    writer.put(info.maxTempValid, 1);
+    writer.put(info.avgTemp, 10);
+    writer.put(info.avgTempValid, 1);
+    return QCanBusFrame(BmsDecoder::ID_BMS_INFO_3, writer.payload);
+}
+
+//Stack nibble, 2 unused bits and the stack validity (first frame only), then per cell
+//13 bit voltage, 1 unused bit and 2 bit validity
+QCanBusFrame ReferenceEncoder::cell_voltages(quint8 stack, int index, const stack_t &values)
+{
+    BitWriter writer(7);
+    writer.put(stack, 4);
+    writer.skip(2);
+    writer.put((index == 0) ? values.cellVoltageValidity[0] : 0, 2);
+    for (int cell = 3 * index; cell < 3 * index + 3; cell++) {
+        writer.put(values.cellVoltages[cell], 13);
+        writer.skip(1);
+        writer.put(values.cellVoltageValidity[cell + 1], 2);
+    }
+    return QCanBusFrame(BmsDecoder::ID_CELL_VOLT_1 + index, writer.payload);
+}
+
+//Stack nibble, then per sensor 10 bit temperature and 2 bit validity
+QCanBusFrame ReferenceEncoder::cell_temperatures(quint8 stack, int index, const stack_t &values)
+{
+    int count = (index == 2) ? 4 : 5;
+    BitWriter writer(count + 3);
+    writer.put(stack, 4);
+    for (int i = 0; i < count; i++) {
+        int sensor = 5 * index + i;
+        writer.put(values.temperatures[sensor], 10);
+        writer.put(values.temperatureValidity[sensor], 2);
+    }
+    return QCanBusFrame(BmsDecoder::ID_CELL_TEMP_1 + index, writer.payload);
+}
+
+QCanBusFrame ReferenceEncoder::uid(quint8 stack, const stack_t &values)
+{
+    BitWriter writer(5);
+    writer.put(stack, 4);
+    writer.skip(4);
+    writer.put(values.uid, 32);
+    return QCanBusFrame(BmsDecoder::ID_UID, writer.payload);
+}
+
+//Whole stack byte, then cells 11 down to 0
+QCanBusFrame ReferenceEncoder::balancing(quint8 stack, const stack_t &values)
+{
+    BitWriter writer(3);
+    writer.put(stack, 8);
+    writer.put(values.balancing & 0xFFF, 12);
+    return QCanBusFrame(BmsDecoder::ID_BALANCING, writer.payload);
+}
+
+QCanBusFrame ReferenceEncoder::fd_cell_voltages(quint8 stack, const stack_t &values)
+{
+    BitWriter writer(1 + 2 * cellsPerStack);
+    writer.put(stack, 4);
+    writer.skip(2);
+    writer.put(values.cellVoltageValidity[0], 2);
+    for (int cell = 0; cell < cellsPerStack; cell++) {
+        writer.put(values.cellVoltages[cell], 13);
+        writer.skip(1);
+        writer.put(values.cellVoltageValidity[cell + 1], 2);
+    }
+    QCanBusFrame frame(BmsDecoder::ID_FD_CELL_VOLT, writer.payload);
+    frame.setFlexibleDataRateFormat(true);
+    return frame;
+}
+
+QCanBusFrame ReferenceEncoder::fd_cell_temperatures(quint8 stack, const stack_t &values)
+{
+    BitWriter writer(1 + 2 * sensorsPerStack);
+    writer.put(stack, 4);
+    writer.skip(4);
+    for (int sensor = 0; sensor < sensorsPerStack; sensor++) {
+        writer.put(values.temperatures[sensor], 10);
+        writer.skip(4);
+        writer.put(values.temperatureValidity[sensor], 2);
+    }
+    QCanBusFrame frame(BmsDecoder::ID_FD_CELL_TEMP, writer.payload);
+    frame.setFlexibleDataRateFormat(true);
+    return frame;
+}
@@ -0,0 +1,79 @@
+#ifndef REFERENCEENCODER_H
+#define REFERENCEENCODER_H
+
+#include <QByteArray>
+#include <QCanBusFrame>
+
+//Builds BMU frames from raw bus values, written from the CAN layout of the firmware and
+//independent of BmsDecoder, so the decoder can be checked against it.
+//All values are the integers sent on the bus, e.g. mV or 0.1 degC, without scaling.
+class ReferenceEncoder
+{
+public:
+    struct bms_info_1_t {
+        quint16 minCellVolt;    //mV, 13 bit
+        quint16 maxCellVolt;
+        quint16 avgCellVolt;
+        quint16 minSoc;         //0.1 %, 10 bit
+        quint16 maxSoc;
+        bool minCellVoltValid;
+        bool maxCellVoltValid;
+        bool avgCellVoltValid;
+        bool minSocValid;
+        bool maxSocValid;
+    };
+
+    struct bms_info_2_t {
+        quint16 batteryVoltage; //0.1 V, 13 bit
+        quint16 dcLinkVoltage;
+        qint16 current;         //6.25 mA
+        bool batteryVoltageValid;
+        bool dcLinkVoltageValid;
+        bool currentValid;
+    };
+
+    struct bms_info_3_t {
+        quint16 isoRes;         //0.1 kOhm, 15 bit
+        bool isoResValid;
+        bool shutdownStatus;
+        quint8 tsState;         //2 bit
+        bool amsScStatus;
+        bool amsStatus;
+        bool imdScStatus;
+        bool imdStatus;
+        quint8 error;           //7 bit
+        quint16 minTemp;        //0.1 degC, 10 bit
+        quint16 maxTemp;
+        quint16 avgTemp;
+        bool minTempValid;
+        bool maxTempValid;
+        bool avgTempValid;
+    };
+
+    //Classic frames carry 12 cells and 14 sensors per stack
+    static const int cellsPerStack = 12;
+    static const int sensorsPerStack = 14;
+
+    struct stack_t {
+        quint16 cellVoltages[cellsPerStack];             //mV, 13 bit
+        quint8 cellVoltageValidity[cellsPerStack + 1];   //2 bit, [0]: stack
+        quint16 temperatures[sensorsPerStack];           //0.1 degC, 10 bit
+        quint8 temperatureValidity[sensorsPerStack];     //2 bit
+        quint32 uid;
+        quint16 balancing;                               //Bit n: cell n
+    };
+
+    static QCanBusFrame bms_info_1(const bms_info_1_t &info);
+    static QCanBusFrame bms_info_2(const bms_info_2_t &info);
+    static QCanBusFrame bms_info_3(const bms_info_3_t &info);
+    //index 0..3, 3 cells each
+    static QCanBusFrame cell_voltages(quint8 stack, int index, const stack_t &values);
+    //index 0..2, 5, 5 and 4 sensors
+    static QCanBusFrame cell_temperatures(quint8 stack, int index, const stack_t &values);
+    static QCanBusFrame uid(quint8 stack, const stack_t &values);
+    static QCanBusFrame balancing(quint8 stack, const stack_t &values);
+    static QCanBusFrame fd_cell_voltages(quint8 stack, const stack_t &values);
+    static QCanBusFrame fd_cell_temperatures(quint8 stack, const stack_t &values);
+};
+
+#endif // REFERENCEENCODER_H
@@ -0,0 +1,16 @@
+# Included by every test and bench project below bmscore/tests
+QT -= gui
+QT += network serialbus
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+include($$PWD/../bmscore.pri)
+
+INCLUDEPATH += $$PWD/shared
+
+SOURCES += \
+    $$PWD/shared/referenceencoder.cpp
+
+HEADERS += \
+    $$PWD/shared/referenceencoder.h
@@ -0,0 +1,570 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include "balancing.h"
+#include "bmsdecoder.h"
+#include "referenceencoder.h"
+
+//Golden frames of the BMU, the bytes were taken from the CAN layout of the firmware.
+//The decoder is checked against the expected values, the reference encoder against the bytes.
+class tst_BmsDecoder : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void golden_bms_info_1();
+    void golden_bms_info_2();
+    void golden_bms_info_3();
+    void golden_cell_temperatures();
+    void golden_cell_voltages();
+    void golden_uid();
+    void golden_balancing();
+    void golden_fd_cell_voltages();
+    void golden_fd_cell_temperatures();
+    void encoder_matches_golden_data();
+    void encoder_matches_golden();
+
+    void round_trip_classic();
+    void round_trip_fd();
+    void round_trip_balancing();
+    void balancing_backoff();
+
+    void rejects_missing_stacks_data();
+    void rejects_missing_stacks();
+    void rejects_short_payloads_data();
+    void rejects_short_payloads();
+    void link_available();
+
+private:
+    static const int rounds = 1000;
+
+    static QCanBusFrame frame(quint32 id, const char *hex);
+    static void add_golden_row(const char *name, const QCanBusFrame &encoded, quint32 id, const char *hex);
+    static void add_rejected_row(const char *name, const QCanBusFrame &rejected);
+    static ReferenceEncoder::bms_info_1_t golden_info_1();
+    static ReferenceEncoder::bms_info_2_t golden_info_2();
+    static ReferenceEncoder::bms_info_3_t golden_info_3();
+    static ReferenceEncoder::stack_t golden_stack();
+    static ReferenceEncoder::stack_t golden_fd_stack();
+    static ReferenceEncoder::stack_t random_stack(QRandomGenerator &random);
+};
+
+static const char goldenInfo1[] = "67860b77a087bfb6";
+static const char goldenInfo2[] = "a9c4a8b0fb2e80";
+static const char goldenInfo3[] = "9c41d6066be59271";
+static const char goldenTemp1[] = "5324ffd00257b800";
+static const char goldenTemp2[] = "b3e83ec3f03f43f8";
+static const char goldenTemp3[] = "04b04b44bbf9c0";
+static const char goldenVolt1[] = "326720fff90003";
+static const char goldenVolt2[] = "70834072105dc8";
+static const char goldenVolt3[] = "0000090012001b";
+static const char goldenVolt4[] = "b07ff880009c40";
+static const char goldenUid[] = "90deadbeef";
+static const char goldenBalancing[] = "04a590";
+static const char goldenFdVolt[] = "215dc060e1640267236a406d617082"
+                                   "73a376c079e17d028023";
+static const char goldenFdTemp[] = "a0320033c3358237413900"
+                                   "3ac33c823e41400041c343"
+                                   "824541470048c3";
+
+QCanBusFrame tst_BmsDecoder::frame(quint32 id, const char *hex)
+{
+    QCanBusFrame result(id, QByteArray::fromHex(hex));
+    if (id >= BmsDecoder::ID_FD_CELL_VOLT) {
+        result.setFlexibleDataRateFormat(true);
+    }
+    return result;
+}
+
+void tst_BmsDecoder::add_golden_row(const char *name, const QCanBusFrame &encoded, quint32 id, const char *hex)
+{
+    QTest::newRow(name) << (uint)encoded.frameId() << encoded.hasFlexibleDataRateFormat() << encoded.payload()
+                        << (uint)id << (id >= BmsDecoder::ID_FD_CELL_VOLT) << QByteArray::fromHex(hex);
+}
+
+void tst_BmsDecoder::add_rejected_row(const char *name, const QCanBusFrame &rejected)
+{
+    QTest::newRow(name) << (uint)rejected.frameId() << rejected.payload();
+}
+
+ReferenceEncoder::bms_info_1_t tst_BmsDecoder::golden_info_1()
+{
+    ReferenceEncoder::bms_info_1_t info = {};
+    info.minCellVolt = 3312;
+    info.minCellVoltValid = true;
+    info.maxCellVolt = 4187;
+    info.maxCellVoltValid = true;
+    info.avgCellVolt = 3905;
+    info.minSoc = 123;
+    info.minSocValid = true;
+    info.maxSoc = 987;
+    return info;
+}
+
+ReferenceEncoder::bms_info_2_t tst_BmsDecoder::golden_info_2()
+{
+    ReferenceEncoder::bms_info_2_t info = {};
+    info.batteryVoltage = 5432;
+    info.batteryVoltageValid = true;
+    info.dcLinkVoltage = 5398;
+    info.current = -1234;
+    info.currentValid = true;
+    return info;
+}
+
+ReferenceEncoder::bms_info_3_t tst_BmsDecoder::golden_info_3()
+{
+    ReferenceEncoder::bms_info_3_t info = {};
+    info.isoRes = 20000;
+    info.isoResValid = true;
+    info.shutdownStatus = true;
+    info.tsState = BmsDecoder::TS_STATE_OPERATE;
+    info.amsScStatus = true;
+    info.imdScStatus = true;
+    info.imdStatus = true;
+    info.error = BmsDecoder::ERROR_PRE_CHARGE_TOO_SHORT;
+    info.minTemp = 215;
+    info.minTempValid = true;
+    info.maxTemp = 601;
+    info.avgTemp = 312;
+    info.avgTempValid = true;
+    return info;
+}
+
+//Values of the classic golden frames, every frame uses its own stack
+ReferenceEncoder::stack_t tst_BmsDecoder::golden_stack()
+{
+    static const quint16 voltages[] = {3300, 8191, 0, 4200, 3650, 3001, 1, 2, 3, 4095, 4096, 5000};
+    static const quint8 voltageValidity[] = {2, 0, 1, 3, 0, 0, 0, 1, 2, 3, 0, 0, 0};
+    static const quint16 temperatures[] = {201, 1023, 0, 350, 512, 250, 251, 252, 253, 254, 300, 301, 302, 999};
+    static const quint8 temperatureValidity[] = {0, 1, 2, 3, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0};
+
+    ReferenceEncoder::stack_t values = {};
+    ::memcpy(values.cellVoltages, voltages, sizeof(voltages));
+    ::memcpy(values.cellVoltageValidity, voltageValidity, sizeof(voltageValidity));
+    ::memcpy(values.temperatures, temperatures, sizeof(temperatures));
+    ::memcpy(values.temperatureValidity, temperatureValidity, sizeof(temperatureValidity));
+    values.uid = 0xDEADBEEF;
+    values.balancing = 0xA59;
+    return values;
+}
+
+ReferenceEncoder::stack_t tst_BmsDecoder::golden_fd_stack()
+{
+    ReferenceEncoder::stack_t values = {};
+    values.cellVoltageValidity[0] = 1;
+    for (int cell = 0; cell < ReferenceEncoder::cellsPerStack; cell++) {
+        values.cellVoltages[cell] = 3000 + 100 * cell;
+        values.cellVoltageValidity[cell + 1] = cell % 4;
+    }
+    for (int sensor = 0; sensor < ReferenceEncoder::sensorsPerStack; sensor++) {
+        values.temperatures[sensor] = 200 + 7 * sensor;
+        values.temperatureValidity[sensor] = (3 * sensor) % 4;
+    }
+    return values;
+}
+
+ReferenceEncoder::stack_t tst_BmsDecoder::random_stack(QRandomGenerator &random)
+{
+    ReferenceEncoder::stack_t values = {};
+    values.cellVoltageValidity[0] = random.bounded(4);
+    for (int cell = 0; cell < ReferenceEncoder::cellsPerStack; cell++) {
+        values.cellVoltages[cell] = random.bounded(1 << 13);
+        values.cellVoltageValidity[cell + 1] = random.bounded(4);
+    }
+    for (int sensor = 0; sensor < ReferenceEncoder::sensorsPerStack; sensor++) {
+        values.temperatures[sensor] = random.bounded(1 << 10);
+        values.temperatureValidity[sensor] = random.bounded(4);
+    }
+    values.uid = random.generate();
+    values.balancing = random.bounded(1 << 12);
+    return values;
+}
+
+void tst_BmsDecoder::initTestCase()
+{
+    //The golden frames are those of the SPR21e pack, other topologies drop some of them
+    if (!std::is_same<bms_topology_t, spr21e_topology_t>::value) {
+        QSKIP("The golden frames need the SPR21e topology");
+    }
+}
+
+void tst_BmsDecoder::golden_bms_info_1()
+{
+    BmsDecoder decoder;
+    decoder.decode(frame(BmsDecoder::ID_BMS_INFO_1, goldenInfo1));
+    const BmsDecoder::bms_info_t &info = decoder.info();
+    QCOMPARE(qRound(info.minCellVolt * 1000), 3312);
+    QCOMPARE(info.minCellVoltValid, true);
+    QCOMPARE(qRound(info.maxCellVolt * 1000), 4187);
+    QCOMPARE(info.maxCellVoltValid, true);
+    QCOMPARE(qRound(info.avgCellVolt * 1000), 3905);
+    QCOMPARE(info.avgCellVoltValid, false);
+    QCOMPARE(qRound(info.minSoc * 10), 123);
+    QCOMPARE(info.minSocValid, true);
+    QCOMPARE(qRound(info.maxSoc * 10), 987);
+    QCOMPARE(info.maxSocValid, false);
+}
+
+void tst_BmsDecoder::golden_bms_info_2()
+{
+    BmsDecoder decoder;
+    decoder.decode(frame(BmsDecoder::ID_BMS_INFO_2, goldenInfo2));
+    const BmsDecoder::bms_info_t &info = decoder.info();
+    QCOMPARE(qRound(info.batteryVoltage * 10), 5432);
+    QCOMPARE(info.batteryVoltageValid, true);
+    QCOMPARE(qRound(info.dcLinkVoltage * 10), 5398);
+    QCOMPARE(info.dcLinkVoltageValid, false);
+    QCOMPARE(qRound(info.current / 0.00625f), -1234);
+    QCOMPARE(info.currentValid, true);
+}
+
+void tst_BmsDecoder::golden_bms_info_3()
+{
+    BmsDecoder decoder;
+    QSignalSpy transitions(&decoder, &BmsDecoder::transition);
+    decoder.decode(frame(BmsDecoder::ID_BMS_INFO_3, goldenInfo3));
+    const BmsDecoder::bms_info_t &info = decoder.info();
+    QCOMPARE(qRound(info.isoRes * 10), 20000);
+    QCOMPARE(info.isoResValid, true);
+    QCOMPARE(info.shutdownStatus, true);
+    QCOMPARE(info.tsState, BmsDecoder::TS_STATE_OPERATE);
+    QCOMPARE(info.amsScStatus, true);
+    QCOMPARE(info.amsStatus, false);
+    QCOMPARE(info.imdScStatus, true);
+    QCOMPARE(info.imdStatus, true);
+    QCOMPARE(info.error, BmsDecoder::ERROR_PRE_CHARGE_TOO_SHORT);
+    QCOMPARE(qRound(info.minTemp * 10), 215);
+    QCOMPARE(info.minTempValid, true);
+    QCOMPARE(qRound(info.maxTemp * 10), 601);
+    QCOMPARE(info.maxTempValid, false);
+    QCOMPARE(qRound(info.avgTemp * 10), 312);
+    QCOMPARE(info.avgTempValid, true);
+    //The initial error is logged, the states are assumed to be OK
+    QCOMPARE(transitions.count(), 1);
+}
+
+void tst_BmsDecoder::golden_cell_temperatures()
+{
+    const ReferenceEncoder::stack_t expected = golden_stack();
+    BmsDecoder decoder;
+    decoder.decode(frame(BmsDecoder::ID_CELL_TEMP_1, goldenTemp1));
+    decoder.decode(frame(BmsDecoder::ID_CELL_TEMP_2, goldenTemp2));
+    decoder.decode(frame(BmsDecoder::ID_CELL_TEMP_3, goldenTemp3));
+    const BmsDecoder::pack_t &pack = decoder.pack();
+
+    const int stacks[] = {5, 11, 0};
+    for (int sensor = 0; sensor < ReferenceEncoder::sensorsPerStack; sensor++) {
+        int stack = stacks[sensor / 5];
+        QCOMPARE(qRound(pack.temperatures[stack][sensor] * 10), (int)expected.temperatures[sensor]);
+        QCOMPARE(pack.temperatureValidity[stack][sensor], expected.temperatureValidity[sensor]);
+    }
+}
+
+void tst_BmsDecoder::golden_cell_voltages()
+{
+    const ReferenceEncoder::stack_t expected = golden_stack();
+    BmsDecoder decoder;
+    decoder.decode(frame(BmsDecoder::ID_CELL_VOLT_1, goldenVolt1));
+    decoder.decode(frame(BmsDecoder::ID_CELL_VOLT_2, goldenVolt2));
+    decoder.decode(frame(BmsDecoder::ID_CELL_VOLT_3, goldenVolt3));
+    decoder.decode(frame(BmsDecoder::ID_CELL_VOLT_4, goldenVolt4));
+    const BmsDecoder::pack_t &pack = decoder.pack();
+
+    const int stacks[] = {3, 7, 0, 11};
+    QCOMPARE(pack.cellVoltageValidity[3][0], expected.cellVoltageValidity[0]);
+    for (int cell = 0; cell < ReferenceEncoder::cellsPerStack; cell++) {
+        int stack = stacks[cell / 3];
+        QCOMPARE(pack.cellVoltages[stack][cell], expected.cellVoltages[cell]);
+        QCOMPARE(pack.cellVoltageValidity[stack][cell + 1], expected.cellVoltageValidity[cell + 1]);
+    }
+}
+
+void tst_BmsDecoder::golden_uid()
+{
+    BmsDecoder decoder;
+    decoder.decode(frame(BmsDecoder::ID_UID, goldenUid));
+    QCOMPARE(decoder.pack().uid[9], 0xDEADBEEFu);
+}
+
+void tst_BmsDecoder::golden_balancing()
+{
+    const ReferenceEncoder::stack_t expected = golden_stack();
+    Balancing balancing;
+    balancing.merge_activity(QByteArray::fromHex(goldenBalancing));
+    for (int stack = 0; stack < Balancing::numberOfStacks; stack++) {
+        for (int cell = 0; cell < Balancing::cellsPerStack; cell++) {
+            bool active = (stack == 4) && ((expected.balancing >> cell) & 0x01);
+            QCOMPARE(balancing.is_balancing(stack, cell), active);
+        }
+    }
+}
+
+void tst_BmsDecoder::golden_fd_cell_voltages()
+{
+    const ReferenceEncoder::stack_t expected = golden_fd_stack();
+    BmsDecoder decoder;
+    decoder.decode(frame(BmsDecoder::ID_FD_CELL_VOLT, goldenFdVolt));
+    const BmsDecoder::pack_t &pack = decoder.pack();
+    QCOMPARE(pack.cellVoltageValidity[2][0], expected.cellVoltageValidity[0]);
+    for (int cell = 0; cell < ReferenceEncoder::cellsPerStack; cell++) {
+        QCOMPARE(pack.cellVoltages[2][cell], expected.cellVoltages[cell]);
+        QCOMPARE(pack.cellVoltageValidity[2][cell + 1], expected.cellVoltageValidity[cell + 1]);
+    }
+}
+
+void tst_BmsDecoder::golden_fd_cell_temperatures()
+{
+    const ReferenceEncoder::stack_t expected = golden_fd_stack();
+    BmsDecoder decoder;
+    decoder.decode(frame(BmsDecoder::ID_FD_CELL_TEMP, goldenFdTemp));
+    const BmsDecoder::pack_t &pack = decoder.pack();
+    for (int sensor = 0; sensor < ReferenceEncoder::sensorsPerStack; sensor++) {
+        QCOMPARE(qRound(pack.temperatures[10][sensor] * 10), (int)expected.temperatures[sensor]);
+        QCOMPARE(pack.temperatureValidity[10][sensor], expected.temperatureValidity[sensor]);
+    }
+}
+
+void tst_BmsDecoder::encoder_matches_golden_data()
+{
+    QTest::addColumn<uint>("encodedId");
+    QTest::addColumn<bool>("encodedFd");
+    QTest::addColumn<QByteArray>("encodedPayload");
+    QTest::addColumn<uint>("goldenId");
+    QTest::addColumn<bool>("goldenFd");
+    QTest::addColumn<QByteArray>("goldenPayload");
+
+    const ReferenceEncoder::stack_t values = golden_stack();
+    const ReferenceEncoder::stack_t fdValues = golden_fd_stack();
+    add_golden_row("0x1", ReferenceEncoder::bms_info_1(golden_info_1()), 0x1, goldenInfo1);
+    add_golden_row("0x2", ReferenceEncoder::bms_info_2(golden_info_2()), 0x2, goldenInfo2);
+    add_golden_row("0x3", ReferenceEncoder::bms_info_3(golden_info_3()), 0x3, goldenInfo3);
+    add_golden_row("0x4", ReferenceEncoder::cell_temperatures(5, 0, values), 0x4, goldenTemp1);
+    add_golden_row("0x5", ReferenceEncoder::cell_temperatures(11, 1, values), 0x5, goldenTemp2);
+    add_golden_row("0x6", ReferenceEncoder::cell_temperatures(0, 2, values), 0x6, goldenTemp3);
+    add_golden_row("0x7", ReferenceEncoder::cell_voltages(3, 0, values), 0x7, goldenVolt1);
+    add_golden_row("0x8", ReferenceEncoder::cell_voltages(7, 1, values), 0x8, goldenVolt2);
+    add_golden_row("0x9", ReferenceEncoder::cell_voltages(0, 2, values), 0x9, goldenVolt3);
+    add_golden_row("0xA", ReferenceEncoder::cell_voltages(11, 3, values), 0xA, goldenVolt4);
+    add_golden_row("0xB", ReferenceEncoder::uid(9, values), 0xB, goldenUid);
+    add_golden_row("0xE", ReferenceEncoder::balancing(4, values), 0xE, goldenBalancing);
+    add_golden_row("0x10", ReferenceEncoder::fd_cell_voltages(2, fdValues), 0x10, goldenFdVolt);
+    add_golden_row("0x11", ReferenceEncoder::fd_cell_temperatures(10, fdValues), 0x11, goldenFdTemp);
+}
+
+void tst_BmsDecoder::encoder_matches_golden()
+{
+    QFETCH(uint, encodedId);
+    QFETCH(bool, encodedFd);
+    QFETCH(QByteArray, encodedPayload);
+    QFETCH(uint, goldenId);
+    QFETCH(bool, goldenFd);
+    QFETCH(QByteArray, goldenPayload);
+    QCOMPARE(encodedId, goldenId);
+    QCOMPARE(encodedFd, goldenFd);
+    QCOMPARE(encodedPayload.toHex(), goldenPayload.toHex());
+}
+
+//Random stacks sent through the classic frames of every stack, compared on the raw bus values
+void tst_BmsDecoder::round_trip_classic()
+{
+    QRandomGenerator random(0x5A21E);
+    BmsDecoder decoder;
+    for (int round = 0; round < rounds; round++) {
+        quint8 stack = random.bounded(bms_topology_t::stacks);
+        const ReferenceEncoder::stack_t values = random_stack(random);
+        for (int index = 0; index < 4; index++) {
+            decoder.decode(ReferenceEncoder::cell_voltages(stack, index, values));
+        }
+        for (int index = 0; index < 3; index++) {
+            decoder.decode(ReferenceEncoder::cell_temperatures(stack, index, values));
+        }
+        decoder.decode(ReferenceEncoder::uid(stack, values));
+
+        const BmsDecoder::pack_t &pack = decoder.pack();
+        QCOMPARE(pack.cellVoltageValidity[stack][0], values.cellVoltageValidity[0]);
+        for (int cell = 0; cell < ReferenceEncoder::cellsPerStack; cell++) {
+            QCOMPARE(pack.cellVoltages[stack][cell], values.cellVoltages[cell]);
+            QCOMPARE(pack.cellVoltageValidity[stack][cell + 1], values.cellVoltageValidity[cell + 1]);
+        }
+        for (int sensor = 0; sensor < ReferenceEncoder::sensorsPerStack; sensor++) {
+            QCOMPARE(qRound(pack.temperatures[stack][sensor] * 10), (int)values.temperatures[sensor]);
+            QCOMPARE(pack.temperatureValidity[stack][sensor], values.temperatureValidity[sensor]);
+        }
+        QCOMPARE(pack.uid[stack], values.uid);
+    }
+}
+
+void tst_BmsDecoder::round_trip_fd()
+{
+    QRandomGenerator random(0xFD);
+    BmsDecoder decoder;
+    for (int round = 0; round < rounds; round++) {
+        quint8 stack = random.bounded(bms_topology_t::stacks);
+        const ReferenceEncoder::stack_t values = random_stack(random);
+        decoder.decode(ReferenceEncoder::fd_cell_voltages(stack, values));
+        decoder.decode(ReferenceEncoder::fd_cell_temperatures(stack, values));
+
+        const BmsDecoder::pack_t &pack = decoder.pack();
+        QCOMPARE(pack.cellVoltageValidity[stack][0], values.cellVoltageValidity[0]);
+        for (int cell = 0; cell < ReferenceEncoder::cellsPerStack; cell++) {
+            QCOMPARE(pack.cellVoltages[stack][cell], values.cellVoltages[cell]);
+            QCOMPARE(pack.cellVoltageValidity[stack][cell + 1], values.cellVoltageValidity[cell + 1]);
+        }
+        for (int sensor = 0; sensor < ReferenceEncoder::sensorsPerStack; sensor++) {
+            QCOMPARE(qRound(pack.temperatures[stack][sensor] * 10), (int)values.temperatures[sensor]);
+            QCOMPARE(pack.temperatureValidity[stack][sensor], values.temperatureValidity[sensor]);
+        }
+    }
+}
+
+void tst_BmsDecoder::round_trip_balancing()
+{
+    QRandomGenerator random(0xBA1);
+    Balancing balancing;
+    for (int round = 0; round < rounds; round++) {
+        quint8 stack = random.bounded(Balancing::numberOfStacks);
+        const ReferenceEncoder::stack_t values = random_stack(random);
+        balancing.merge_activity(ReferenceEncoder::balancing(stack, values).payload());
+        for (int cell = 0; cell < Balancing::cellsPerStack; cell++) {
+            QCOMPARE(balancing.is_balancing(stack, cell), (bool)((values.balancing >> cell) & 0x01));
+        }
+    }
+}
+
+//A stack which does not answer is skipped for 1, 3, 7, ... poll intervals and reported once
+void tst_BmsDecoder::balancing_backoff()
+{
+    Balancing balancing;
+    balancing.set_poll_interval(5);
+    QSignalSpy answering(&balancing, &Balancing::stack_answering);
+    int requests[Balancing::numberOfStacks] = {};
+    QObject::connect(&balancing, &Balancing::diag_request, [&](quint8 command, quint8 stack, QByteArray) {
+        QCOMPARE(command, (quint8)0x3);
+        requests[stack]++;
+        if ((stack == 0) && (requests[0] == 5)) {
+            balancing.stop_polling();
+        }
+    });
+
+    balancing.start_polling();
+    QCOMPARE(requests[5], 1);
+    QCOMPARE(balancing.request_failed(0x4, 5), false);
+    QCOMPARE(balancing.request_failed(0x3, 5), true);
+    QCOMPARE(balancing.request_failed(0x3, 5), true);
+    QCOMPARE(answering.count(), 1);
+    QCOMPARE(answering.at(0).at(0).value<quint8>(), (quint8)5);
+    QCOMPARE(answering.at(0).at(1).toBool(), false);
+
+    //Two failures in a row skip 3 intervals, the stack is polled again in the 4th
+    QTRY_COMPARE(requests[0], 5);
+    QCOMPARE(requests[5], 2);
+    QCOMPARE(requests[6], 5);
+
+    balancing.merge_diag_response(QByteArray::fromHex("0305000000"));
+    QCOMPARE(answering.count(), 2);
+    QCOMPARE(answering.at(1).at(1).toBool(), true);
+    balancing.merge_diag_response(QByteArray::fromHex("0305000000"));
+    QCOMPARE(answering.count(), 2);
+}
+
+//Stacks 12 to 15 can be addressed by the nibble but do not exist
+void tst_BmsDecoder::rejects_missing_stacks_data()
+{
+    QTest::addColumn<uint>("id");
+    QTest::addColumn<QByteArray>("payload");
+
+    const ReferenceEncoder::stack_t values = golden_stack();
+    for (quint8 stack = bms_topology_t::stacks; stack < 16; stack++) {
+        QByteArray suffix = " stack " + QByteArray::number(stack);
+        add_rejected_row(("0x4" + suffix).constData(), ReferenceEncoder::cell_temperatures(stack, 0, values));
+        add_rejected_row(("0x6" + suffix).constData(), ReferenceEncoder::cell_temperatures(stack, 2, values));
+        add_rejected_row(("0x7" + suffix).constData(), ReferenceEncoder::cell_voltages(stack, 0, values));
+        add_rejected_row(("0xA" + suffix).constData(), ReferenceEncoder::cell_voltages(stack, 3, values));
+        add_rejected_row(("0xB" + suffix).constData(), ReferenceEncoder::uid(stack, values));
+        add_rejected_row(("0x10" + suffix).constData(), ReferenceEncoder::fd_cell_voltages(stack, values));
+        add_rejected_row(("0x11" + suffix).constData(), ReferenceEncoder::fd_cell_temperatures(stack, values));
+    }
+}
+
+void tst_BmsDecoder::rejects_missing_stacks()
+{
+    QFETCH(uint, id);
+    QFETCH(QByteArray, payload);
+    BmsDecoder decoder;
+    QSignalSpy decoded(&decoder, &BmsDecoder::decoded);
+    decoder.decode(QCanBusFrame(id, payload));
+    QCOMPARE(decoded.count(), 0);
+}
+
+void tst_BmsDecoder::rejects_short_payloads_data()
+{
+    QTest::addColumn<uint>("id");
+    QTest::addColumn<QByteArray>("payload");
+
+    const ReferenceEncoder::stack_t values = golden_stack();
+    const QCanBusFrame frames[] = {
+        ReferenceEncoder::bms_info_1(golden_info_1()),
+        ReferenceEncoder::bms_info_2(golden_info_2()),
+        ReferenceEncoder::bms_info_3(golden_info_3()),
+        ReferenceEncoder::cell_temperatures(1, 0, values),
+        ReferenceEncoder::cell_temperatures(1, 1, values),
+        ReferenceEncoder::cell_temperatures(1, 2, values),
+        ReferenceEncoder::cell_voltages(1, 0, values),
+        ReferenceEncoder::cell_voltages(1, 1, values),
+        ReferenceEncoder::cell_voltages(1, 2, values),
+        ReferenceEncoder::cell_voltages(1, 3, values),
+        ReferenceEncoder::uid(1, values),
+        ReferenceEncoder::fd_cell_voltages(1, values),
+        ReferenceEncoder::fd_cell_temperatures(1, values)
+    };
+    for (const QCanBusFrame &full : frames) {
+        QCanBusFrame truncated = full;
+        truncated.setPayload(full.payload().left(full.payload().size() - 1));
+        add_rejected_row(("0x" + QByteArray::number(full.frameId(), 16)).constData(), truncated);
+    }
+}
+
+void tst_BmsDecoder::rejects_short_payloads()
+{
+    QFETCH(uint, id);
+    QFETCH(QByteArray, payload);
+    BmsDecoder decoder;
+    QSignalSpy decoded(&decoder, &BmsDecoder::decoded);
+    decoder.decode(QCanBusFrame(id, payload));
+    QCOMPARE(decoded.count(), 0);
+}
+
+void tst_BmsDecoder::link_available()
+{
+    const ReferenceEncoder::stack_t values = golden_stack();
+    BmsDecoder decoder;
+    decoder.decode(ReferenceEncoder::bms_info_1(golden_info_1()));
+    decoder.decode(ReferenceEncoder::bms_info_2(golden_info_2()));
+    decoder.decode(ReferenceEncoder::bms_info_3(golden_info_3()));
+    for (int index = 0; index < 3; index++) {
+        decoder.decode(ReferenceEncoder::cell_temperatures(0, index, values));
+    }
+    for (int index = 0; index < 4; index++) {
+        decoder.decode(ReferenceEncoder::cell_voltages(0, index, values));
+    }
+    QCOMPARE(decoder.take_link_available(), false);
+    decoder.decode(ReferenceEncoder::uid(0, values));
+    QCOMPARE(decoder.take_link_available(), true);
+    QCOMPARE(decoder.take_link_available(), false);
+
+    //The FD frames stand in for the classic cell frames
+    decoder.decode(ReferenceEncoder::bms_info_1(golden_info_1()));
+    decoder.decode(ReferenceEncoder::bms_info_2(golden_info_2()));
+    decoder.decode(ReferenceEncoder::bms_info_3(golden_info_3()));
+    decoder.decode(ReferenceEncoder::uid(0, values));
+    decoder.decode(ReferenceEncoder::fd_cell_voltages(0, values));
+    QCOMPARE(decoder.take_link_available(), false);
+    decoder.decode(ReferenceEncoder::fd_cell_temperatures(0, values));
+    QCOMPARE(decoder.take_link_available(), true);
+}
+
+QTEST_GUILESS_MAIN(tst_BmsDecoder)
+
+#include "tst_bmsdecoder.moc"
@@ -0,0 +1,9 @@
+QT += testlib
+CONFIG += testcase
+
+include(../tests.pri)
+
+TARGET = tst_bmsdecoder
+
+SOURCES += \
+    tst_bmsdecoder.cpp
@@ -0,0 +1,80 @@
+#include <QtTest>
+#include <QApplication>
+#include <QCheckBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTemporaryDir>
+#include "logfileconverter.h"
+
+//Follow mode of the logfile converter, driven through its widgets
+class tst_LogfileConverter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void truncated_input_leaves_follow_mode();
+
+private:
+    static bool write_lines(QString fileName, int records);
+};
+
+bool tst_LogfileConverter::write_lines(QString fileName, int records)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    logging_data_t record = {};
+    record.timestamp = {1, 6, 2021, 12, 0, 0};
+    for (int i = 0; i < records; i++) {
+        record.timestamp.second = i;
+        file.write(QByteArray::fromRawData((const char *)&record, sizeof(record)).toBase64() + '\n');
+    }
+    return true;
+}
+
+void tst_LogfileConverter::truncated_input_leaves_follow_mode()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString inputName = directory.filePath("input.log");
+    QVERIFY(write_lines(inputName, 3));
+
+    LogfileConverter converter;
+    QLineEdit *inputPath = converter.findChild<QLineEdit *>("inputPath");
+    QLineEdit *outputPath = converter.findChild<QLineEdit *>("outputPath");
+    QCheckBox *chkFollow = converter.findChild<QCheckBox *>("chkFollow");
+    QPushButton *btnConvert = converter.findChild<QPushButton *>("btnConvert");
+    QLabel *status = converter.findChild<QLabel *>("status");
+    QVERIFY(inputPath && outputPath && chkFollow && btnConvert && status);
+
+    inputPath->setText(inputName);
+    outputPath->setText(directory.filePath("output.csv"));
+    chkFollow->setChecked(true);
+    btnConvert->setEnabled(true);
+
+    QTest::mouseClick(btnConvert, Qt::LeftButton);
+    QCOMPARE(btnConvert->text(), QString("Stop"));
+    QVERIFY(!chkFollow->isEnabled());
+    QTRY_COMPARE(status->text(), QString("Following, 3 records appended"));
+
+    QFile input(inputName);
+    QVERIFY(input.resize(10));
+    QTRY_COMPARE_WITH_TIMEOUT(btnConvert->text(), QString("Convert"), 5000);
+    QVERIFY(chkFollow->isEnabled());
+    QVERIFY(!converter.findChild<LogFollower *>()->is_running());
+    QCOMPARE(status->text(), QString("Input file was truncated, following stopped"));
+}
+
+//Runs without a display unless a platform is chosen
+int main(int argc, char *argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    tst_LogfileConverter test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_logfileconverter.moc"
@@ -0,0 +1,25 @@
+QT += testlib
+CONFIG += testcase
+
+include(../tests.pri)
+
+QT += gui widgets sql
+
+TARGET = tst_logfileconverter
+
+VIEWER = $$PWD/../../../spr21e-bms-viewer
+INCLUDEPATH += $$VIEWER
+
+SOURCES += \
+    tst_logfileconverter.cpp \
+    $$VIEWER/logfileconverter.cpp \
+    $$VIEWER/logfollower.cpp \
+    $$VIEWER/sqliteexporter.cpp
+
+HEADERS += \
+    $$VIEWER/logfileconverter.h \
+    $$VIEWER/logfollower.h \
+    $$VIEWER/sqliteexporter.h
+
+FORMS += \
+    $$VIEWER/logfileconverter.ui
@@ -0,0 +1,147 @@
+//Writer and reader thread on one segment, every snapshot the reader accepts has to be consistent.
+//The writer fills every field of snapshot n with values derived from n, a torn read mixes two of them.
+//Plain C11 like the reader it tests, exits with 0 on success.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "packshm.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+
+#define SNAPSHOTS 200000
+
+typedef struct {
+    packshm_segment_t *writer;
+    const packshm_segment_t *reader;
+    atomic_int failed;
+    unsigned long accepted;
+    unsigned long busy;
+} test_t;
+
+static void fill(packshm_snapshot_t *snapshot, uint64_t n)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->timestamp = n;
+    snapshot->updates = n;
+    snapshot->info.current = (float)n;
+    snapshot->info.valid = (uint32_t)n;
+    for (int stack = 0; stack < PACKSHM_STACKS; stack++) {
+        snapshot->uid[stack] = (uint32_t)n;
+        snapshot->balancing[stack] = (uint16_t)n;
+        for (int cell = 0; cell < PACKSHM_CELLS_PER_STACK; cell++) {
+            snapshot->cellVoltage[stack][cell] = (uint16_t)n;
+        }
+        for (int cell = 0; cell < PACKSHM_CELLS_PER_STACK + 1; cell++) {
+            snapshot->cellVoltageValidity[stack][cell] = (uint8_t)n;
+        }
+        for (int sensor = 0; sensor < PACKSHM_SENSORS_PER_STACK; sensor++) {
+            snapshot->temperature[stack][sensor] = (float)n;
+            snapshot->temperatureValidity[stack][sensor] = (uint8_t)n;
+        }
+    }
+}
+
+static int writer(void *argument)
+{
+    test_t *test = argument;
+    packshm_snapshot_t snapshot;
+    for (uint64_t n = 1; n <= SNAPSHOTS; n++) {
+        fill(&snapshot, n);
+        packshm_publish(test->writer, &snapshot);
+    }
+    return 0;
+}
+
+static int reader(void *argument)
+{
+    test_t *test = argument;
+    packshm_snapshot_t snapshot;
+    packshm_snapshot_t expected;
+    uint64_t last = 0;
+    while (last < SNAPSHOTS) {
+        int result = packshm_read(test->reader, &snapshot);
+        if (result == PACKSHM_BUSY) {
+            test->busy++;
+            continue;
+        }
+        if (result != PACKSHM_OK) {
+            fprintf(stderr, "FAIL: read returned %d\n", result);
+            atomic_store(&test->failed, 1);
+            return 1;
+        }
+        if (snapshot.updates < last) {
+            fprintf(stderr, "FAIL: snapshot %lu after %lu\n", (unsigned long)snapshot.updates, (unsigned long)last);
+            atomic_store(&test->failed, 1);
+            return 1;
+        }
+        fill(&expected, snapshot.updates);
+        if (memcmp(&snapshot, &expected, sizeof(snapshot)) != 0) {
+            fprintf(stderr, "FAIL: torn snapshot %lu\n", (unsigned long)snapshot.updates);
+            atomic_store(&test->failed, 1);
+            return 1;
+        }
+        last = snapshot.updates;
+        test->accepted++;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/spr_bms_test_%ld", (long)getpid());
+
+    test_t test;
+    memset(&test, 0, sizeof(test));
+    atomic_init(&test.failed, 0);
+    test.writer = packshm_create(name);
+    if (!test.writer) {
+        fprintf(stderr, "FAIL: cannot create %s\n", name);
+        return 1;
+    }
+    test.reader = packshm_open(name);
+    if (!test.reader) {
+        fprintf(stderr, "FAIL: cannot open %s\n", name);
+        packshm_destroy(test.writer, name);
+        return 1;
+    }
+
+    //A new segment is empty and readable
+    packshm_snapshot_t snapshot;
+    if ((packshm_read(test.reader, &snapshot) != PACKSHM_OK) || (snapshot.updates != 0)) {
+        fprintf(stderr, "FAIL: new segment not empty\n");
+        atomic_store(&test.failed, 1);
+    }
+
+    thrd_t readerThread;
+    thrd_t writerThread;
+    if ((thrd_create(&readerThread, reader, &test) != thrd_success)
+            || (thrd_create(&writerThread, writer, &test) != thrd_success)) {
+        fprintf(stderr, "FAIL: cannot start threads\n");
+        return 1;
+    }
+    thrd_join(writerThread, NULL);
+    thrd_join(readerThread, NULL);
+
+    //Mapped readers see that the publisher has gone
+    packshm_destroy(test.writer, name);
+    if (packshm_read(test.reader, &snapshot) != PACKSHM_CLOSED) {
+        fprintf(stderr, "FAIL: destroyed segment still readable\n");
+        atomic_store(&test.failed, 1);
+    }
+    packshm_close(test.reader);
+    if (packshm_open(name) != NULL) {
+        fprintf(stderr, "FAIL: destroyed segment can be opened\n");
+        atomic_store(&test.failed, 1);
+    }
+
+    if (atomic_load(&test.failed)) {
+        return 1;
+    }
+    printf("PASS: %d snapshots published, %lu consistent reads, %lu busy\n", SNAPSHOTS, test.accepted, test.busy);
+    return 0;
+}
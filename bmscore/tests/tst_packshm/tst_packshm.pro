@@ -0,0 +1,20 @@
+# Plain C, like the reader it tests
+TEMPLATE = app
+CONFIG += console testcase
+CONFIG -= qt app_bundle
+
+QMAKE_CFLAGS += -std=c11
+
+INCLUDEPATH += ../../../common
+include(../../topology.pri)
+
+LIBS += -lrt -lpthread
+
+TARGET = tst_packshm
+
+SOURCES += \
+    ../../../common/packshm.c \
+    tst_packshm.c
+
+HEADERS += \
+    ../../../common/packshm.h
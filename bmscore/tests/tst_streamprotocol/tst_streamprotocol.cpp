@@ -0,0 +1,366 @@
+#include <QtTest>
+#include <QMutex>
+#include <QRandomGenerator>
+#include <QSemaphore>
+#include <QThread>
+#include <QtEndian>
+#include "streamclient.h"
+#include "streamprotocol.h"
+#include "streamserver.h"
+
+//Delta encoding, message framing and the TCP link between StreamServer and StreamClient
+class tst_StreamProtocol : public QObject
+{
+    Q_OBJECT
+private slots:
+    void delta_round_trip();
+    void delta_full_frames();
+    void delta_random_round_trip();
+    void delta_gap_flag();
+    void delta_rejects_unknown_delta();
+    void stream_split_reads();
+    void stream_out_of_sync();
+    void loopback();
+    void loopback_stalled_client();
+
+private:
+    static QCanBusFrame make_frame(quint32 id, const QByteArray &payload, qint64 us, bool fd = false);
+    static QStringList describe(const QVector<QCanBusFrame> &frames);
+    //Flags of the only frame of a batch, its id and time delta fit into one byte each
+    static quint8 single_frame_flags(const QByteArray &batch);
+};
+
+QCanBusFrame tst_StreamProtocol::make_frame(quint32 id, const QByteArray &payload, qint64 us, bool fd)
+{
+    QCanBusFrame frame(id, payload);
+    frame.setFlexibleDataRateFormat(fd);
+    frame.setExtendedFrameFormat(id > 0x7FF);
+    frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(us));
+    return frame;
+}
+
+QStringList tst_StreamProtocol::describe(const QVector<QCanBusFrame> &frames)
+{
+    QStringList list;
+    for (const QCanBusFrame &frame : frames) {
+        list.append(QString("%1 %2 ext %3 fd %4 at %5 us").arg(frame.frameId(), 0, 16)
+                    .arg(QString::fromLatin1(frame.payload().toHex()))
+                    .arg(frame.hasExtendedFrameFormat()).arg(frame.hasFlexibleDataRateFormat())
+                    .arg(frame.timeStamp().seconds() * 1000000LL + frame.timeStamp().microSeconds()));
+    }
+    return list;
+}
+
+quint8 tst_StreamProtocol::single_frame_flags(const QByteArray &batch)
+{
+    return (quint8)batch.at(9 + 2);
+}
+
+void tst_StreamProtocol::delta_round_trip()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    QVector<QCanBusFrame> decoded;
+    bool gap = true;
+
+    //First frame of an id is sent in full
+    QVector<QCanBusFrame> first{make_frame(0x7, QByteArray::fromHex("32672000000003"), 1000000)};
+    QByteArray batch = encoder.encode(first);
+    QVERIFY(single_frame_flags(batch) & STREAM_FRAME_FULL);
+    QVERIFY(decoder.decode(batch, decoded, gap));
+    QCOMPARE(gap, false);
+    QCOMPARE(describe(decoded), describe(first));
+
+    //Same length, only the changed byte is sent
+    QVector<QCanBusFrame> changed{make_frame(0x7, QByteArray::fromHex("32672000ff0003"), 1000150)};
+    QByteArray delta = encoder.encode(changed);
+    QVERIFY(!(single_frame_flags(delta) & STREAM_FRAME_FULL));
+    QVERIFY(delta.size() < batch.size());
+    decoded.clear();
+    QVERIFY(decoder.decode(delta, decoded, gap));
+    QCOMPARE(describe(decoded), describe(changed));
+
+    //A length change is sent in full again
+    QVector<QCanBusFrame> shorter{make_frame(0x7, QByteArray::fromHex("3267"), 1000300)};
+    batch = encoder.encode(shorter);
+    QVERIFY(single_frame_flags(batch) & STREAM_FRAME_FULL);
+    decoded.clear();
+    QVERIFY(decoder.decode(batch, decoded, gap));
+    QCOMPARE(describe(decoded), describe(shorter));
+
+    //Unchanged payload of the new length
+    decoded.clear();
+    QVERIFY(decoder.decode(encoder.encode(shorter), decoded, gap));
+    QCOMPARE(describe(decoded), describe(shorter));
+}
+
+//A reset encoder sends every id in full, a decoder with the old state accepts that
+void tst_StreamProtocol::delta_full_frames()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    QVector<QCanBusFrame> decoded;
+    bool gap;
+
+    QVector<QCanBusFrame> frames{make_frame(0x10, QByteArray(25, 0x21), 50, true),
+                                make_frame(0x18FF50E5, QByteArray::fromHex("0102030405060708"), 80)};
+    QVERIFY(decoder.decode(encoder.encode(frames), decoded, gap));
+    encoder.reset();
+    frames[0].setPayload(QByteArray(25, 0x22));
+    frames[1].setPayload(QByteArray::fromHex("0102030405060709"));
+    decoded.clear();
+    QVERIFY(decoder.decode(encoder.encode(frames), decoded, gap));
+    QCOMPARE(describe(decoded), describe(frames));
+}
+
+void tst_StreamProtocol::delta_random_round_trip()
+{
+    QRandomGenerator random(0x29536);
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    qint64 time = 0;
+    for (int round = 0; round < 200; round++) {
+        QVector<QCanBusFrame> frames;
+        int count = random.bounded(50);
+        for (int i = 0; i < count; i++) {
+            quint32 id = random.bounded(16);
+            //Mostly the usual length of the id, sometimes another one
+            int length = (random.bounded(10) == 0) ? random.bounded(65) : (id * 4) % 65;
+            QByteArray payload(length, 0);
+            for (int byte = 0; byte < length; byte++) {
+                payload[byte] = (char)((random.bounded(4) == 0) ? random.bounded(256) : byte);
+            }
+            time += random.bounded(2000);
+            frames.append(make_frame(id, payload, time, length > 8));
+        }
+        QVector<QCanBusFrame> decoded;
+        bool gap;
+        QVERIFY(decoder.decode(encoder.encode(frames), decoded, gap));
+        QCOMPARE(describe(decoded), describe(frames));
+    }
+}
+
+void tst_StreamProtocol::delta_gap_flag()
+{
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    QVector<QCanBusFrame> frames{make_frame(0x1, QByteArray(8, 0x11), 10)};
+    QVector<QCanBusFrame> decoded;
+    bool gap = false;
+
+    QVERIFY(decoder.decode(encoder.encode(frames, true), decoded, gap));
+    QCOMPARE(gap, true);
+    QVERIFY(decoder.decode(encoder.encode(frames, false), decoded, gap));
+    QCOMPARE(gap, false);
+    //An empty batch still carries the flag
+    QVERIFY(decoder.decode(encoder.encode(QVector<QCanBusFrame>(), true), decoded, gap));
+    QCOMPARE(gap, true);
+    QCOMPARE(decoded.size(), 2);
+}
+
+//A delta needs the previous payload, a decoder which missed it must not invent one
+void tst_StreamProtocol::delta_rejects_unknown_delta()
+{
+    DeltaEncoder encoder;
+    QVector<QCanBusFrame> frames{make_frame(0x3, QByteArray(8, 0x33), 10)};
+    encoder.encode(frames);
+    frames[0].setPayload(QByteArray(8, 0x34));
+    const QByteArray delta = encoder.encode(frames);
+
+    DeltaDecoder decoder;
+    QVector<QCanBusFrame> decoded;
+    bool gap;
+    QVERIFY(!decoder.decode(delta, decoded, gap));
+    QVERIFY(decoded.isEmpty());
+    QVERIFY(!decoder.decode(delta.left(5), decoded, gap));
+}
+
+void tst_StreamProtocol::stream_split_reads()
+{
+    QVector<stream_message_t> messages;
+    messages.append({STREAM_HELLO, stream_encode_hello(20)});
+    messages.append({STREAM_SUBSCRIBE, stream_encode_subscribe({0x1, 0x10, 0x18FF50E5})});
+    messages.append({STREAM_SUBSCRIBE, QByteArray()});
+    messages.append({STREAM_BATCH, QByteArray(300, 0x5A)});
+    QByteArray stream;
+    for (const stream_message_t &message : qAsConst(messages)) {
+        stream.append(stream_encode(message.type, message.payload));
+    }
+
+    //Every chunk size, from single bytes to the whole stream in one read
+    for (int chunk = 1; chunk <= stream.size(); chunk++) {
+        StreamDecoder decoder;
+        QVector<stream_message_t> received;
+        stream_message_t message;
+        for (int position = 0; position < stream.size(); position += chunk) {
+            decoder.append(stream.mid(position, chunk));
+            while (decoder.next(message)) {
+                received.append(message);
+            }
+        }
+        QVERIFY(!decoder.error());
+        QCOMPARE(received.size(), messages.size());
+        for (int i = 0; i < messages.size(); i++) {
+            QCOMPARE(received.at(i).type, messages.at(i).type);
+            QCOMPARE(received.at(i).payload, messages.at(i).payload);
+        }
+    }
+
+    quint16 version;
+    quint16 interval;
+    QVERIFY(stream_decode_hello(messages.at(0).payload, version, interval));
+    QCOMPARE(version, streamProtocolVersion);
+    QCOMPARE(interval, (quint16)20);
+    QCOMPARE(stream_decode_subscribe(messages.at(1).payload), QVector<quint32>({0x1, 0x10, 0x18FF50E5}));
+}
+
+void tst_StreamProtocol::stream_out_of_sync()
+{
+    StreamDecoder decoder;
+    QByteArray header(5, 0);
+    qToLittleEndian<quint32>(0x7FFFFFFF, header.data());
+    decoder.append(header);
+    stream_message_t message;
+    QVERIFY(!decoder.next(message));
+    QVERIFY(decoder.error());
+
+    decoder.clear();
+    decoder.append(stream_encode(STREAM_HELLO, stream_encode_hello(20)));
+    QVERIFY(decoder.next(message));
+    QVERIFY(!decoder.error());
+}
+
+void tst_StreamProtocol::loopback()
+{
+    StreamServer server;
+    server.set_interval(5);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    StreamClient client;
+    QVector<QCanBusFrame> received;
+    QObject::connect(&client, &StreamClient::new_frame, &client, [&](QCanBusFrame frame) {
+        received.append(frame);
+    });
+    QStringList errors;
+    QObject::connect(&client, &StreamClient::error, &client, [&](QString message) {
+        errors.append(message);
+    });
+    client.subscribe({0x7, 0x10});
+    client.connect_to("127.0.0.1", server.port());
+    QTRY_COMPARE(server.client_count(), 1);
+    //The subscription is sent on connect, give the server a turn to read it
+    QTest::qWait(50);
+
+    QVector<QCanBusFrame> sent;
+    QVector<QCanBusFrame> expected;
+    for (int i = 0; i < 30; i++) {
+        QCanBusFrame frame = make_frame(0x1 + (i % 3) * 0x6, QByteArray(7, (char)i), 1000 * i);
+        if (i % 3 == 2) {
+            frame = make_frame(0x10, QByteArray(25, (char)i), 1000 * i, true);
+        }
+        if (frame.frameId() != 0x1) {
+            expected.append(frame);
+        }
+        server.add_frame(frame);
+        if (i % 10 == 9) {
+            QTest::qWait(20);
+        }
+    }
+    QTRY_COMPARE(received.size(), expected.size());
+    QCOMPARE(describe(received), describe(expected));
+    QVERIFY(errors.isEmpty());
+    QCOMPARE(client.gaps(), 0ull);
+
+    client.disconnect_from();
+    QTRY_COMPARE(server.client_count(), 0);
+}
+
+//The client runs in its own thread, which is blocked while the server keeps sending.
+//Once the socket buffers are full the server drops whole batches, the client has to see the gap
+//and decode every batch it does get, which only works if the delta state of both ends matches.
+void tst_StreamProtocol::loopback_stalled_client()
+{
+    StreamServer server;
+    server.set_interval(1);
+    //Any unsent byte counts as stalled
+    server.set_queue_limit(0);
+    QVERIFY(server.listen(0, QHostAddress::LocalHost));
+
+    QThread thread;
+    StreamClient *client = new StreamClient();
+    client->moveToThread(&thread);
+    QMutex mutex;
+    QVector<QCanBusFrame> received;
+    QAtomicInt errors(0);
+    QObject::connect(client, &StreamClient::new_frame, client, [&](QCanBusFrame frame) {
+        QMutexLocker locker(&mutex);
+        received.append(frame);
+    });
+    QObject::connect(client, &StreamClient::error, client, [&] {
+        errors.ref();
+    });
+    thread.start();
+    quint16 port = server.port();
+    QMetaObject::invokeMethod(client, [=] { client->connect_to("127.0.0.1", port); });
+    QTRY_COMPARE(server.client_count(), 1);
+
+    //Payloads carry their sequence number and do not compress, so the buffers fill quickly
+    QHash<quint32, QByteArray> sent;
+    QRandomGenerator random(0x5741);
+    quint32 sequence = 0;
+    auto send = [&](int count) {
+        for (int i = 0; i < count; i++, sequence++) {
+            QByteArray payload(64, 0);
+            qToLittleEndian<quint32>(sequence, payload.data());
+            for (int byte = 4; byte < payload.size(); byte++) {
+                payload[byte] = (char)random.bounded(256);
+            }
+            sent.insert(sequence, payload);
+            server.add_frame(make_frame(0x100 + (sequence % 8), payload, sequence, true));
+        }
+    };
+
+    QSemaphore stall;
+    QMetaObject::invokeMethod(client, [&] { stall.acquire(); });
+    QElapsedTimer timer;
+    timer.start();
+    while ((server.dropped_batches() == 0) && (timer.elapsed() < 20000)) {
+        send(500);
+        QTest::qWait(2);
+    }
+    QVERIFY(server.dropped_batches() > 0);
+    send(500);
+    QTest::qWait(5);
+
+    //Release the client, no more drops from here on
+    server.set_queue_limit(1LL << 40);
+    stall.release();
+    send(1);
+    quint32 last = sequence - 1;
+    auto complete = [&] {
+        QMutexLocker locker(&mutex);
+        return !received.isEmpty() && (qFromLittleEndian<quint32>(received.last().payload().constData()) == last);
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(complete(), 20000);
+
+    QMetaObject::invokeMethod(client, [=] { client->disconnect_from(); }, Qt::BlockingQueuedConnection);
+    thread.quit();
+    thread.wait();
+    QCOMPARE(errors.loadAcquire(), 0);
+    QVERIFY(client->gaps() > 0);
+    delete client;
+
+    QVERIFY(received.size() < sent.size());
+    qint64 previous = -1;
+    for (const QCanBusFrame &frame : qAsConst(received)) {
+        quint32 number = qFromLittleEndian<quint32>(frame.payload().constData());
+        QVERIFY(number > previous);
+        QCOMPARE(frame.frameId(), 0x100 + (number % 8));
+        QCOMPARE(frame.payload(), sent.value(number));
+        previous = number;
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_StreamProtocol)
+
+#include "tst_streamprotocol.moc"
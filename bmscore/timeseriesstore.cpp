@@ -0,0 +1,310 @@
+#include "timeseriesstore.h"
+
+TimeSeriesStore::TimeSeriesStore(qint64 memoryBudget, int rawRetention, int aggregateRetention)
+{
+    this->memoryBudget = memoryBudget;
+    this->rawRetention = rawRetention;
+    this->aggregateRetention = aggregateRetention;
+    epoch = -1;
+    allocated = false;
+}
+
+int TimeSeriesStore::add_signal(QString name, float scale, float rate)
+{
+    if (allocated) {
+        return -1;
+    }
+    signal_t signal;
+    signal.name = name;
+    signal.scale = scale;
+    signal.rate = rate;
+    series.append(signal);
+    return series.size() - 1;
+}
+
+void TimeSeriesStore::allocate()
+{
+    //Memory required to fulfill the requested retention times
+    qint64 rawRequired = 0;
+    qint64 aggregateRequired = 0;
+    for (const signal_t &signal : qAsConst(series)) {
+        rawRequired += qCeil(signal.rate * rawRetention) * rawSampleSize;
+        aggregateRequired += (qint64)aggregateRetention * aggregateSampleSize;
+    }
+
+    //If the budget is too small, the aggregate tier is shortened first, it is the larger one by far.
+    //The raw tier only gets shorter if it does not fit into the budget on its own.
+    double rawFactor = 1.0;
+    double aggregateFactor = 1.0;
+    if (rawRequired > memoryBudget) {
+        rawFactor = (double)memoryBudget / rawRequired;
+        aggregateFactor = 0.0;
+    } else if (rawRequired + aggregateRequired > memoryBudget) {
+        aggregateFactor = (double)(memoryBudget - rawRequired) / aggregateRequired;
+    }
+
+    for (signal_t &signal : series) {
+        int rawCapacity = qMax(1, (int)(qCeil(signal.rate * rawRetention) * rawFactor));
+        int aggregateCapacity = qMax(1, (int)(aggregateRetention * aggregateFactor));
+
+        signal.raw.time.fill(0, rawCapacity);
+        signal.raw.value.fill(0, rawCapacity);
+        signal.aggregates.time.fill(0, aggregateCapacity);
+        signal.aggregates.min.fill(0, aggregateCapacity);
+        signal.aggregates.max.fill(0, aggregateCapacity);
+        signal.aggregates.mean.fill(0, aggregateCapacity);
+        signal.aggregates.samples.fill(0, aggregateCapacity);
+    }
+    allocated = true;
+}
+
+void TimeSeriesStore::append(int signal, qint64 timestamp, float value)
+{
+    if (!allocated || (signal < 0) || (signal >= series.size())) {
+        return;
+    }
+    if (epoch < 0) {
+        epoch = timestamp;
+    }
+
+    signal_t &s = series[signal];
+    quint32 time = to_relative(timestamp);
+
+    raw_tier_t &raw = s.raw;
+    raw.time[raw.head] = time;
+    raw.value[raw.head] = encode(s, value);
+    raw.head = (raw.head + 1) % raw.time.size();
+    if (raw.count < raw.time.size()) {
+        raw.count++;
+    }
+
+    quint32 second = time / 1000;
+    pending_t &pending = s.pending;
+    if ((pending.count > 0) && (pending.second != second)) {
+        flush_pending(s);
+    }
+    if (pending.count == 0) {
+        pending.second = second;
+        pending.min = value;
+        pending.max = value;
+        pending.sum = 0.0;
+    } else {
+        pending.min = qMin(pending.min, value);
+        pending.max = qMax(pending.max, value);
+    }
+    pending.sum += value;
+    pending.count++;
+}
+
+void TimeSeriesStore::clear()
+{
+    for (signal_t &signal : series) {
+        signal.raw.head = 0;
+        signal.raw.count = 0;
+        signal.aggregates.head = 0;
+        signal.aggregates.count = 0;
+        signal.pending.count = 0;
+    }
+    epoch = -1;
+}
+
+int TimeSeriesStore::signal_count() const
+{
+    return series.size();
+}
+
+QString TimeSeriesStore::signal_name(int signal) const
+{
+    return series.at(signal).name;
+}
+
+int TimeSeriesStore::find_signal(QString name) const
+{
+    for (int i = 0; i < series.size(); i++) {
+        if (series.at(i).name == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+qint64 TimeSeriesStore::memory_usage() const
+{
+    qint64 usage = 0;
+    for (const signal_t &signal : series) {
+        usage += (qint64)signal.raw.time.size() * rawSampleSize;
+        usage += (qint64)signal.aggregates.time.size() * aggregateSampleSize;
+    }
+    return usage;
+}
+
+QVector<TimeSeriesStore::sample_t> TimeSeriesStore::query_range(int signal, qint64 from, qint64 to) const
+{
+    QVector<sample_t> result;
+    if ((signal < 0) || (signal >= series.size()) || (epoch < 0) || (to < epoch)) {
+        return result;
+    }
+
+    const signal_t &s = series.at(signal);
+    const raw_tier_t &raw = s.raw;
+    quint32 end = to_relative(to);
+    for (int i = raw_lower_bound(raw, to_relative(from)); i < raw.count; i++) {
+        int index = raw_index(raw, i);
+        if (raw.time.at(index) > end) {
+            break;
+        }
+        result.append({epoch + raw.time.at(index), decode(s, raw.value.at(index))});
+    }
+    return result;
+}
+
+QVector<TimeSeriesStore::aggregate_t> TimeSeriesStore::query_aggregates(int signal, qint64 from, qint64 to) const
+{
+    QVector<aggregate_t> result;
+    if ((signal < 0) || (signal >= series.size()) || (epoch < 0) || (to < epoch)) {
+        return result;
+    }
+
+    const signal_t &s = series.at(signal);
+    const aggregate_tier_t &agg = s.aggregates;
+    quint32 end = to_relative(to) / 1000;
+    for (int i = aggregate_lower_bound(agg, to_relative(from) / 1000); i < agg.count; i++) {
+        int index = aggregate_index(agg, i);
+        if (agg.time.at(index) > end) {
+            break;
+        }
+        result.append({epoch + (qint64)agg.time.at(index) * 1000,
+                       decode(s, agg.min.at(index)),
+                       decode(s, agg.max.at(index)),
+                       decode(s, agg.mean.at(index)),
+                       agg.samples.at(index)});
+    }
+
+    //The current second is not yet part of the aggregate tier
+    const pending_t &pending = s.pending;
+    if ((pending.count > 0) && (pending.second <= end) && ((qint64)pending.second * 1000 + 999 >= to_relative(from))) {
+        result.append({epoch + (qint64)pending.second * 1000, pending.min, pending.max, (float)(pending.sum / pending.count), pending.count});
+    }
+    return result;
+}
+
+TimeSeriesStore::aggregate_t TimeSeriesStore::aggregate(int signal, qint64 from, qint64 to) const
+{
+    aggregate_t result = {from, 0.0f, 0.0f, 0.0f, 0};
+    if ((signal < 0) || (signal >= series.size()) || (epoch < 0)) {
+        return result;
+    }
+
+    double sum = 0.0;
+    auto merge = [&](float min, float max, double total, quint32 count) {
+        if (count == 0) {
+            return;
+        }
+        if (result.count == 0) {
+            result.min = min;
+            result.max = max;
+        } else {
+            result.min = qMin(result.min, min);
+            result.max = qMax(result.max, max);
+        }
+        sum += total;
+        result.count += count;
+    };
+
+    //Data older than the raw tier is taken from the aggregate tier
+    const raw_tier_t &raw = series.at(signal).raw;
+    qint64 rawStart = raw.count ? epoch + raw.time.at(raw_index(raw, 0)) : to + 1;
+    if (from < rawStart) {
+        //Only whole seconds which end before the raw tier starts
+        qint64 aggregateEnd = qMin(to, rawStart - 1000);
+        for (const aggregate_t &bucket : query_aggregates(signal, from, aggregateEnd)) {
+            if (bucket.timestamp + 1000 <= rawStart) {
+                merge(bucket.min, bucket.max, (double)bucket.mean * bucket.count, bucket.count);
+            }
+        }
+    }
+
+    for (const sample_t &sample : query_range(signal, qMax(from, rawStart), to)) {
+        merge(sample.value, sample.value, sample.value, 1);
+    }
+
+    if (result.count > 0) {
+        result.mean = (float)(sum / result.count);
+    }
+    return result;
+}
+
+qint16 TimeSeriesStore::encode(const signal_t &signal, float value) const
+{
+    float scaled = qBound(-32768.0f, value / signal.scale, 32767.0f);
+    return (qint16)qRound(scaled);
+}
+
+float TimeSeriesStore::decode(const signal_t &signal, qint16 value) const
+{
+    return value * signal.scale;
+}
+
+void TimeSeriesStore::flush_pending(signal_t &signal)
+{
+    pending_t &pending = signal.pending;
+    aggregate_tier_t &agg = signal.aggregates;
+    agg.time[agg.head] = pending.second;
+    agg.min[agg.head] = encode(signal, pending.min);
+    agg.max[agg.head] = encode(signal, pending.max);
+    agg.mean[agg.head] = encode(signal, (float)(pending.sum / pending.count));
+    agg.samples[agg.head] = (quint16)qMin(pending.count, (quint32)0xFFFF);
+    agg.head = (agg.head + 1) % agg.time.size();
+    if (agg.count < agg.time.size()) {
+        agg.count++;
+    }
+    pending.count = 0;
+}
+
+int TimeSeriesStore::raw_index(const raw_tier_t &tier, int i) const
+{
+    return (tier.head - tier.count + i + tier.time.size()) % tier.time.size();
+}
+
+int TimeSeriesStore::aggregate_index(const aggregate_tier_t &tier, int i) const
+{
+    return (tier.head - tier.count + i + tier.time.size()) % tier.time.size();
+}
+
+int TimeSeriesStore::raw_lower_bound(const raw_tier_t &tier, quint32 time) const
+{
+    int first = 0;
+    int last = tier.count;
+    while (first < last) {
+        int mid = first + (last - first) / 2;
+        if (tier.time.at(raw_index(tier, mid)) < time) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+int TimeSeriesStore::aggregate_lower_bound(const aggregate_tier_t &tier, quint32 time) const
+{
+    int first = 0;
+    int last = tier.count;
+    while (first < last) {
+        int mid = first + (last - first) / 2;
+        if (tier.time.at(aggregate_index(tier, mid)) < time) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+quint32 TimeSeriesStore::to_relative(qint64 timestamp) const
+{
+    if (timestamp <= epoch) {
+        return 0;
+    }
+    return (quint32)qMin(timestamp - epoch, (qint64)0xFFFFFFFF);
+}
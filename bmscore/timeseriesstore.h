@@ -0,0 +1,108 @@
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QtMath>
+
+//In-memory history of decoded signals.
+//Every signal owns two columnar rings: a raw tier with every sample and an aggregate
+//tier with one min/max/mean bucket per second. Values are stored as 16 bit fixed point
+//numbers with a per signal scale. The capacity of all rings is derived from a memory
+//budget, so the store never grows after allocate() has been called. A budget which is
+//too small shortens the aggregate tier first, the raw retention is kept if it fits.
+class TimeSeriesStore
+{
+public:
+    struct sample_t {
+        qint64 timestamp; //ms since epoch
+        float value;
+    };
+
+    struct aggregate_t {
+        qint64 timestamp; //ms since epoch, start of the bucket
+        float min;
+        float max;
+        float mean;
+        quint32 count;
+    };
+
+    explicit TimeSeriesStore(qint64 memoryBudget = 128 * 1024 * 1024, int rawRetention = 600, int aggregateRetention = 86400);
+
+    //Registers a signal. scale is the value of one LSB, rate the expected sample rate in Hz.
+    int add_signal(QString name, float scale, float rate);
+    //Allocates the rings of all registered signals within the memory budget.
+    //E.g. 327 signals at 10 Hz in 128 MiB keep 10 min raw and about 8 h of aggregates.
+    void allocate();
+
+    void append(int signal, qint64 timestamp, float value);
+    void clear();
+
+    int signal_count() const;
+    QString signal_name(int signal) const;
+    int find_signal(QString name) const;
+    qint64 memory_usage() const;
+
+    //Raw samples within [from, to]
+    QVector<sample_t> query_range(int signal, qint64 from, qint64 to) const;
+    //1 s aggregates within [from, to]
+    QVector<aggregate_t> query_aggregates(int signal, qint64 from, qint64 to) const;
+    //Aggregate over [from, to]. Uses the raw tier where available and the aggregate tier for older data.
+    aggregate_t aggregate(int signal, qint64 from, qint64 to) const;
+
+private:
+    struct raw_tier_t {
+        QVector<quint32> time; //ms relative to epoch
+        QVector<qint16> value;
+        int head = 0;
+        int count = 0;
+    };
+
+    struct aggregate_tier_t {
+        QVector<quint32> time; //s relative to epoch
+        QVector<qint16> min;
+        QVector<qint16> max;
+        QVector<qint16> mean;
+        QVector<quint16> samples;
+        int head = 0;
+        int count = 0;
+    };
+
+    struct pending_t {
+        quint32 second = 0;
+        float min = 0.0f;
+        float max = 0.0f;
+        double sum = 0.0;
+        quint32 count = 0;
+    };
+
+    struct signal_t {
+        QString name;
+        float scale;
+        float rate;
+        raw_tier_t raw;
+        aggregate_tier_t aggregates;
+        pending_t pending;
+    };
+
+    static const int rawSampleSize = sizeof(quint32) + sizeof(qint16);
+    static const int aggregateSampleSize = sizeof(quint32) + 3 * sizeof(qint16) + sizeof(quint16);
+
+    QVector<signal_t> series;
+    qint64 memoryBudget;
+    int rawRetention;
+    int aggregateRetention;
+    qint64 epoch;
+    bool allocated;
+
+    qint16 encode(const signal_t &signal, float value) const;
+    float decode(const signal_t &signal, qint16 value) const;
+    void flush_pending(signal_t &signal);
+    int raw_index(const raw_tier_t &tier, int i) const;
+    int aggregate_index(const aggregate_tier_t &tier, int i) const;
+    int raw_lower_bound(const raw_tier_t &tier, quint32 time) const;
+    int aggregate_lower_bound(const aggregate_tier_t &tier, quint32 time) const;
+    quint32 to_relative(qint64 timestamp) const;
+};
+
+#endif // TIMESERIESSTORE_H
@@ -0,0 +1,3 @@
+# Pack on the bus, shared by the core library and every program linking it (see packtopology.h).
+# Without these defines the SPR21e pack is used.
+#DEFINES += BMS_STACKS=12 BMS_CELLS_PER_STACK=12 BMS_SENSORS_PER_STACK=14
@@ -0,0 +1,299 @@
+#include "canlink.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/can/netlink.h>
+
+namespace {
+
+struct link_request_t {
+    struct nlmsghdr header;
+    struct ifinfomsg info;
+    char attributes[256];
+};
+
+void add_attribute(struct nlmsghdr *header, unsigned short type, const void *data, unsigned short length)
+{
+    struct rtattr *attribute = (struct rtattr *)((char *)header + NLMSG_ALIGN(header->nlmsg_len));
+    attribute->rta_type = type;
+    attribute->rta_len = RTA_LENGTH(length);
+    if (length) {
+        memcpy(RTA_DATA(attribute), data, length);
+    }
+    header->nlmsg_len = NLMSG_ALIGN(header->nlmsg_len) + RTA_ALIGN(attribute->rta_len);
+}
+
+struct rtattr *nest_start(struct nlmsghdr *header, unsigned short type)
+{
+    struct rtattr *nest = (struct rtattr *)((char *)header + NLMSG_ALIGN(header->nlmsg_len));
+    add_attribute(header, type, NULL, 0);
+    return nest;
+}
+
+void nest_end(struct nlmsghdr *header, struct rtattr *nest)
+{
+    nest->rta_len = (char *)header + NLMSG_ALIGN(header->nlmsg_len) - (char *)nest;
+}
+
+void init_request(link_request_t *request, int type, int index)
+{
+    memset(request, 0, sizeof(*request));
+    request->header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request->header.nlmsg_type = type;
+    request->header.nlmsg_flags = NLM_F_REQUEST;
+    request->header.nlmsg_seq = 1;
+    request->info.ifi_family = AF_UNSPEC;
+    request->info.ifi_index = index;
+}
+
+//Sends a request and waits for the acknowledge of the kernel
+int transact(link_request_t *request)
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        return -errno;
+    }
+    request->header.nlmsg_flags |= NLM_F_ACK;
+    if (send(fd, request, request->header.nlmsg_len, 0) < 0) {
+        int error = -errno;
+        close(fd);
+        return error;
+    }
+
+    char buffer[1024];
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    int error = received < 0 ? -errno : -EPROTO;
+    close(fd);
+
+    int length = (int)received;
+    for (struct nlmsghdr *header = (struct nlmsghdr *)buffer; (received > 0) && NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+        if (header->nlmsg_type == NLMSG_ERROR) {
+            //An error code of 0 is the acknowledge
+            return ((struct nlmsgerr *)NLMSG_DATA(header))->error;
+        }
+    }
+    return error;
+}
+
+void parse_can_data(struct rtattr *data, int length, can_link_info_t *info)
+{
+    for (struct rtattr *attribute = data; RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        switch (attribute->rta_type) {
+        case IFLA_CAN_BITTIMING: {
+            struct can_bittiming bittiming;
+            memcpy(&bittiming, RTA_DATA(attribute), sizeof(bittiming));
+            info->bitrate = bittiming.bitrate;
+            info->samplePoint = bittiming.sample_point;
+            break;
+        }
+        case IFLA_CAN_DATA_BITTIMING: {
+            struct can_bittiming bittiming;
+            memcpy(&bittiming, RTA_DATA(attribute), sizeof(bittiming));
+            info->dataBitrate = bittiming.bitrate;
+            info->dataSamplePoint = bittiming.sample_point;
+            break;
+        }
+        case IFLA_CAN_CTRLMODE: {
+            struct can_ctrlmode ctrlmode;
+            memcpy(&ctrlmode, RTA_DATA(attribute), sizeof(ctrlmode));
+            info->fd = ctrlmode.flags & CAN_CTRLMODE_FD;
+            break;
+        }
+        case IFLA_CAN_STATE:
+            memcpy(&info->state, RTA_DATA(attribute), sizeof(info->state));
+            break;
+        case IFLA_CAN_RESTART_MS:
+            memcpy(&info->restartMs, RTA_DATA(attribute), sizeof(info->restartMs));
+            break;
+        case IFLA_CAN_BERR_COUNTER: {
+            struct can_berr_counter counter;
+            memcpy(&counter, RTA_DATA(attribute), sizeof(counter));
+            info->txErrors = counter.txerr;
+            info->rxErrors = counter.rxerr;
+            break;
+        }
+        }
+    }
+}
+
+void parse_link_info(struct rtattr *linkInfo, int length, can_link_info_t *info)
+{
+    for (struct rtattr *attribute = linkInfo; RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        if (attribute->rta_type == IFLA_INFO_KIND) {
+            info->isVirtual = strncmp((const char *)RTA_DATA(attribute), "vcan", RTA_PAYLOAD(attribute)) == 0;
+        } else if (attribute->rta_type == IFLA_INFO_DATA) {
+            parse_can_data((struct rtattr *)RTA_DATA(attribute), RTA_PAYLOAD(attribute), info);
+        }
+    }
+}
+
+}
+
+bool canlink_query(const char *ifname, can_link_info_t *info)
+{
+    memset(info, 0, sizeof(*info));
+
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        return false;
+    }
+
+    link_request_t request;
+    init_request(&request, RTM_GETLINK, 0);
+    add_attribute(&request.header, IFLA_IFNAME, ifname, strnlen(ifname, IFNAMSIZ - 1) + 1);
+
+    if (send(fd, &request, request.header.nlmsg_len, 0) < 0) {
+        close(fd);
+        return false;
+    }
+
+    char buffer[8192];
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    close(fd);
+    if (received < 0) {
+        return false;
+    }
+
+    int length = (int)received;
+    for (struct nlmsghdr *header = (struct nlmsghdr *)buffer; NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+        if (header->nlmsg_type == NLMSG_ERROR) {
+            //Interface does not exist
+            return true;
+        }
+        if (header->nlmsg_type != RTM_NEWLINK) {
+            continue;
+        }
+        struct ifinfomsg *ifinfo = (struct ifinfomsg *)NLMSG_DATA(header);
+        info->exists = true;
+        info->up = ifinfo->ifi_flags & IFF_UP;
+
+        int attributeLength = IFLA_PAYLOAD(header);
+        for (struct rtattr *attribute = IFLA_RTA(ifinfo); RTA_OK(attribute, attributeLength); attribute = RTA_NEXT(attribute, attributeLength)) {
+            if (attribute->rta_type == IFLA_LINKINFO) {
+                parse_link_info((struct rtattr *)RTA_DATA(attribute), RTA_PAYLOAD(attribute), info);
+            }
+        }
+        return true;
+    }
+    return true;
+}
+
+bool canlink_matches(const can_link_info_t *info, const can_link_config_t *config)
+{
+    if (info->isVirtual) {
+        return true;
+    }
+    if ((info->bitrate != config->bitrate) || (config->samplePoint && (info->samplePoint != config->samplePoint))) {
+        return false;
+    }
+    if (info->fd != (config->dataBitrate != 0)) {
+        return false;
+    }
+    return !info->fd || ((info->dataBitrate == config->dataBitrate) &&
+                         (!config->dataSamplePoint || (info->dataSamplePoint == config->dataSamplePoint)));
+}
+
+int canlink_set_up(const char *ifname, bool up)
+{
+    int index = if_nametoindex(ifname);
+    if (index == 0) {
+        return -ENODEV;
+    }
+    link_request_t request;
+    init_request(&request, RTM_NEWLINK, index);
+    request.info.ifi_change = IFF_UP;
+    request.info.ifi_flags = up ? IFF_UP : 0;
+    return transact(&request);
+}
+
+int canlink_configure(const char *ifname, const can_link_config_t *config)
+{
+    int index = if_nametoindex(ifname);
+    if (index == 0) {
+        return -ENODEV;
+    }
+    link_request_t request;
+    init_request(&request, RTM_NEWLINK, index);
+
+    //Only bitrate and sample point are given, the kernel calculates the bit timing
+    struct can_bittiming bittiming;
+    memset(&bittiming, 0, sizeof(bittiming));
+    bittiming.bitrate = config->bitrate;
+    bittiming.sample_point = config->samplePoint;
+    uint32_t restartMs = config->restartMs;
+
+    struct can_ctrlmode ctrlmode;
+    ctrlmode.mask = CAN_CTRLMODE_FD;
+    ctrlmode.flags = config->dataBitrate ? CAN_CTRLMODE_FD : 0;
+
+    struct rtattr *linkInfo = nest_start(&request.header, IFLA_LINKINFO);
+    add_attribute(&request.header, IFLA_INFO_KIND, "can", 3);
+    struct rtattr *data = nest_start(&request.header, IFLA_INFO_DATA);
+    add_attribute(&request.header, IFLA_CAN_BITTIMING, &bittiming, sizeof(bittiming));
+    add_attribute(&request.header, IFLA_CAN_RESTART_MS, &restartMs, sizeof(restartMs));
+    add_attribute(&request.header, IFLA_CAN_CTRLMODE, &ctrlmode, sizeof(ctrlmode));
+    if (config->dataBitrate) {
+        struct can_bittiming dataBittiming;
+        memset(&dataBittiming, 0, sizeof(dataBittiming));
+        dataBittiming.bitrate = config->dataBitrate;
+        dataBittiming.sample_point = config->dataSamplePoint;
+        add_attribute(&request.header, IFLA_CAN_DATA_BITTIMING, &dataBittiming, sizeof(dataBittiming));
+    }
+    nest_end(&request.header, data);
+    nest_end(&request.header, linkInfo);
+    return transact(&request);
+}
+
+int canlink_restart(const char *ifname)
+{
+    int index = if_nametoindex(ifname);
+    if (index == 0) {
+        return -ENODEV;
+    }
+    link_request_t request;
+    init_request(&request, RTM_NEWLINK, index);
+
+    uint32_t restart = 1;
+    struct rtattr *linkInfo = nest_start(&request.header, IFLA_LINKINFO);
+    add_attribute(&request.header, IFLA_INFO_KIND, "can", 3);
+    struct rtattr *data = nest_start(&request.header, IFLA_INFO_DATA);
+    add_attribute(&request.header, IFLA_CAN_RESTART, &restart, sizeof(restart));
+    nest_end(&request.header, data);
+    nest_end(&request.header, linkInfo);
+    return transact(&request);
+}
+
+int canlink_bring_up(const char *ifname, const can_link_config_t *config)
+{
+    can_link_info_t info;
+    if (!canlink_query(ifname, &info)) {
+        return -EIO;
+    }
+    if (!info.exists) {
+        return -ENODEV;
+    }
+
+    if (info.isVirtual) {
+        return info.up ? 0 : canlink_set_up(ifname, true);
+    }
+    bool configured = canlink_matches(&info, config);
+    if (info.up && configured) {
+        return 0;
+    }
+    if (info.up) {
+        int error = canlink_set_up(ifname, false);
+        if (error) {
+            return error;
+        }
+    }
+    int error = canlink_configure(ifname, config);
+    if (error) {
+        return error;
+    }
+    return canlink_set_up(ifname, true);
+}
@@ -0,0 +1,45 @@
+#ifndef CANLINK_H
+#define CANLINK_H
+
+#include <stdint.h>
+
+//Queries and configures SocketCAN network interfaces directly over rtnetlink.
+//Reading the link state does not require root privileges, changing it does.
+
+struct can_link_info_t {
+    bool exists;
+    bool up;
+    bool isVirtual;        //vcan, has no bit timing
+    bool fd;               //CAN FD enabled
+    uint32_t bitrate;      //bit/s, 0 if not configured
+    uint32_t samplePoint;  //tenth of a percent
+    uint32_t dataBitrate;  //bit/s of the CAN FD data phase
+    uint32_t dataSamplePoint;
+    uint32_t state;        //enum can_state from linux/can/netlink.h
+    uint32_t restartMs;    //automatic restart after bus off, 0 if disabled
+    uint16_t txErrors;
+    uint16_t rxErrors;
+};
+
+struct can_link_config_t {
+    uint32_t bitrate;      //bit/s
+    uint32_t samplePoint;  //tenth of a percent, 0 lets the kernel choose
+    uint32_t restartMs;    //automatic restart after bus off, 0 disables it
+    uint32_t dataBitrate;  //bit/s of the CAN FD data phase, 0 for classic CAN
+    uint32_t dataSamplePoint;
+};
+
+bool canlink_query(const char *ifname, can_link_info_t *info);
+bool canlink_matches(const can_link_info_t *info, const can_link_config_t *config);
+
+//Both return 0 on success or a negative errno
+int canlink_set_up(const char *ifname, bool up);
+int canlink_configure(const char *ifname, const can_link_config_t *config); //Interface has to be down
+//Manual restart, only valid while bus off and with restart_ms 0, the kernel rejects it with -EINVAL otherwise.
+//With restart_ms > 0 the kernel owns the restart, wait until the interface has left bus off instead.
+int canlink_restart(const char *ifname);
+
+//Brings the interface up with the given configuration, reconfigures it only if needed
+int canlink_bring_up(const char *ifname, const can_link_config_t *config);
+
+#endif // CANLINK_H
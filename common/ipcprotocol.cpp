@@ -0,0 +1,109 @@
+#include "ipcprotocol.h"
+#include <QtEndian>
+#include <cstring>
+
+QByteArray ipc_encode(quint16 id, quint8 type, quint8 status, const QByteArray &payload)
+{
+    QByteArray message(8, 0);
+    qToLittleEndian<quint32>(payload.size(), message.data());
+    qToLittleEndian<quint16>(id, message.data() + 4);
+    message[6] = (char)type;
+    message[7] = (char)status;
+    message.append(payload);
+    return message;
+}
+
+QByteArray ipc_encode_link_config(const QString &name, const can_link_config_t &config)
+{
+    QByteArray payload(16, 0);
+    qToLittleEndian<quint32>(config.bitrate, payload.data());
+    qToLittleEndian<quint16>(config.samplePoint, payload.data() + 4);
+    qToLittleEndian<quint16>(config.restartMs, payload.data() + 6);
+    qToLittleEndian<quint32>(config.dataBitrate, payload.data() + 8);
+    qToLittleEndian<quint16>(config.dataSamplePoint, payload.data() + 12);
+    payload.append(name.toLocal8Bit());
+    return payload;
+}
+
+bool ipc_decode_link_config(const QByteArray &payload, QString &name, can_link_config_t &config)
+{
+    if (payload.size() <= 16) {
+        return false;
+    }
+    config.bitrate = qFromLittleEndian<quint32>(payload.constData());
+    config.samplePoint = qFromLittleEndian<quint16>(payload.constData() + 4);
+    config.restartMs = qFromLittleEndian<quint16>(payload.constData() + 6);
+    config.dataBitrate = qFromLittleEndian<quint32>(payload.constData() + 8);
+    config.dataSamplePoint = qFromLittleEndian<quint16>(payload.constData() + 12);
+    name = QString::fromLocal8Bit(payload.mid(16));
+    return true;
+}
+
+QByteArray ipc_encode_link_info(const can_link_info_t &info)
+{
+    QByteArray payload(18, 0);
+    payload[0] = (char)((info.up ? 0x01 : 0x00) | (info.isVirtual ? 0x02 : 0x00) | (info.fd ? 0x04 : 0x00));
+    payload[1] = (char)info.state;
+    qToLittleEndian<quint16>(info.txErrors, payload.data() + 2);
+    qToLittleEndian<quint16>(info.rxErrors, payload.data() + 4);
+    qToLittleEndian<quint32>(info.bitrate, payload.data() + 6);
+    qToLittleEndian<quint16>(info.samplePoint, payload.data() + 10);
+    qToLittleEndian<quint32>(info.dataBitrate, payload.data() + 12);
+    qToLittleEndian<quint16>(info.dataSamplePoint, payload.data() + 16);
+    return payload;
+}
+
+bool ipc_decode_link_info(const QByteArray &payload, can_link_info_t &info)
+{
+    if (payload.size() < 18) {
+        return false;
+    }
+    ::memset(&info, 0, sizeof(info));
+    info.exists = true;
+    info.up = payload.at(0) & 0x01;
+    info.isVirtual = payload.at(0) & 0x02;
+    info.fd = payload.at(0) & 0x04;
+    info.state = (quint8)payload.at(1);
+    info.txErrors = qFromLittleEndian<quint16>(payload.constData() + 2);
+    info.rxErrors = qFromLittleEndian<quint16>(payload.constData() + 4);
+    info.bitrate = qFromLittleEndian<quint32>(payload.constData() + 6);
+    info.samplePoint = qFromLittleEndian<quint16>(payload.constData() + 10);
+    info.dataBitrate = qFromLittleEndian<quint32>(payload.constData() + 12);
+    info.dataSamplePoint = qFromLittleEndian<quint16>(payload.constData() + 16);
+    return true;
+}
+
+void IpcDecoder::append(const QByteArray &data)
+{
+    buffer.append(data);
+}
+
+bool IpcDecoder::next(ipc_message_t &message)
+{
+    if (invalid || (buffer.size() < headerSize)) {
+        return false;
+    }
+    quint32 length = qFromLittleEndian<quint32>(buffer.constData());
+    if (length > maxPayload) {
+        //Out of sync, the stream can not be recovered
+        invalid = true;
+        buffer.clear();
+        return false;
+    }
+    if ((quint32)buffer.size() < headerSize + length) {
+        return false;
+    }
+
+    message.id = qFromLittleEndian<quint16>(buffer.constData() + 4);
+    message.type = (quint8)buffer.at(6);
+    message.status = (quint8)buffer.at(7);
+    message.payload = buffer.mid(headerSize, length);
+    buffer.remove(0, headerSize + length);
+    return true;
+}
+
+void IpcDecoder::clear()
+{
+    buffer.clear();
+    invalid = false;
+}
@@ -0,0 +1,68 @@
+#ifndef IPCPROTOCOL_H
+#define IPCPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include "canlink.h"
+
+//Message protocol between the viewer and bms-viewer-helper.
+//Every message is an 8 byte little endian header followed by the payload:
+//  quint32 payload length, quint16 request id, quint8 type, quint8 status
+//Responses carry the id and type of their request, so requests can be pipelined.
+
+enum ipc_type_t : quint8 {
+    IPC_HELLO = 1,       //Helper -> viewer after connecting
+    IPC_LOAD_DRIVER,
+    IPC_LINK_UP,         //Payload: link configuration, response: link state
+    IPC_LINK_DOWN,       //Payload: interface name
+    IPC_SHUTDOWN,        //Payload: interface name, brought down before the helper exits
+    IPC_HEARTBEAT,
+    IPC_LINK_STATE,      //Payload: interface name, response: link state
+    IPC_LINK_RESTART     //Payload: link configuration, response: link state
+};
+
+enum ipc_status_t : quint8 {
+    IPC_REQUEST = 0,
+    IPC_SUCCESS,
+    IPC_FAILED           //Payload: error message
+};
+
+struct ipc_message_t {
+    quint16 id;
+    quint8 type;
+    quint8 status;
+    QByteArray payload;
+};
+
+static const char ipcServerName[] = "spr_bms_viewer_helper";
+static const char ipcHeartbeatServerName[] = "spr_bms_viewer_helper_hb";
+
+QByteArray ipc_encode(quint16 id, quint8 type, quint8 status, const QByteArray &payload = QByteArray());
+
+//Link configuration: quint32 bitrate, quint16 sample point, quint16 restart ms,
+//quint32 data bitrate, quint16 data sample point, quint16 reserved, interface name
+QByteArray ipc_encode_link_config(const QString &name, const can_link_config_t &config);
+bool ipc_decode_link_config(const QByteArray &payload, QString &name, can_link_config_t &config);
+
+//Link state: quint8 flags (up, virtual, fd), quint8 state, quint16 tx errors, quint16 rx errors,
+//quint32 bitrate, quint16 sample point, quint32 data bitrate, quint16 data sample point
+QByteArray ipc_encode_link_info(const can_link_info_t &info);
+bool ipc_decode_link_info(const QByteArray &payload, can_link_info_t &info);
+
+//Reassembles messages from a byte stream, independent of how the reads are split
+class IpcDecoder
+{
+public:
+    void append(const QByteArray &data);
+    bool next(ipc_message_t &message);
+    bool error() const { return invalid; }
+    void clear();
+
+private:
+    static const int headerSize = 8;
+    static const quint32 maxPayload = 4096;
+    QByteArray buffer;
+    bool invalid = false;
+};
+
+#endif // IPCPROTOCOL_H
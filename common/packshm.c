@@ -0,0 +1,122 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "packshm.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//Readers give up after this many torn reads, the writer only holds the lock for one copy
+#define READ_RETRIES 1000
+
+_Static_assert(sizeof(packshm_info_t) == 60, "packshm_info_t must not contain padding");
+#ifndef BMS_STACKS
+_Static_assert(sizeof(packshm_snapshot_t) == 1432, "packshm_snapshot_t must not contain padding");
+#endif
+
+packshm_segment_t *packshm_create(const char *name)
+{
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(packshm_segment_t)) < 0) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(packshm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    packshm_segment_t *segment = (packshm_segment_t *)map;
+    //Readers of a previous publisher see an odd sequence until the layout is complete.
+    //The sequence keeps counting up, a reader must never see the same value for different data.
+    uint32_t sequence = __atomic_load_n(&segment->sequence, __ATOMIC_RELAXED) | 1;
+    __atomic_store_n(&segment->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memset(&segment->snapshot, 0, sizeof(segment->snapshot));
+    segment->version = PACKSHM_VERSION;
+    segment->reserved = 0;
+    segment->size = sizeof(packshm_segment_t);
+    segment->publisher = getpid();
+    segment->reserved2 = 0;
+    __atomic_store_n(&segment->magic, PACKSHM_MAGIC, __ATOMIC_RELAXED);
+    __atomic_store_n(&segment->sequence, sequence + 1, __ATOMIC_RELEASE);
+    return segment;
+}
+
+void packshm_publish(packshm_segment_t *segment, const packshm_snapshot_t *snapshot)
+{
+    uint32_t sequence = __atomic_load_n(&segment->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&segment->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&segment->snapshot, snapshot, sizeof(packshm_snapshot_t));
+    __atomic_store_n(&segment->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+void packshm_destroy(packshm_segment_t *segment, const char *name)
+{
+    if (!segment) {
+        return;
+    }
+    //Mapped readers notice that the publisher is gone, new readers do not find the segment
+    __atomic_store_n(&segment->publisher, 0, __ATOMIC_RELEASE);
+    munmap(segment, sizeof(packshm_segment_t));
+    shm_unlink(name);
+}
+
+const packshm_segment_t *packshm_open(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat status;
+    if ((fstat(fd, &status) < 0) || (status.st_size < (off_t)sizeof(packshm_segment_t))) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(packshm_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const packshm_segment_t *segment = (const packshm_segment_t *)map;
+    if ((__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != PACKSHM_MAGIC)
+            || (segment->version != PACKSHM_VERSION) || (segment->size != sizeof(packshm_segment_t))) {
+        munmap(map, sizeof(packshm_segment_t));
+        return NULL;
+    }
+    return segment;
+}
+
+int packshm_read(const packshm_segment_t *segment, packshm_snapshot_t *snapshot)
+{
+    for (int i = 0; i < READ_RETRIES; i++) {
+        if (__atomic_load_n(&segment->publisher, __ATOMIC_ACQUIRE) == 0) {
+            return PACKSHM_CLOSED;
+        }
+        uint32_t begin = __atomic_load_n(&segment->sequence, __ATOMIC_ACQUIRE);
+        if (begin & 1) {
+            continue;
+        }
+        memcpy(snapshot, &segment->snapshot, sizeof(packshm_snapshot_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&segment->sequence, __ATOMIC_RELAXED) == begin) {
+            return PACKSHM_OK;
+        }
+    }
+    return PACKSHM_BUSY;
+}
+
+void packshm_close(const packshm_segment_t *segment)
+{
+    if (segment) {
+        munmap((void *)segment, sizeof(packshm_segment_t));
+    }
+}
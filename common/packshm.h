@@ -0,0 +1,119 @@
+#ifndef PACKSHM_H
+#define PACKSHM_H
+
+#include <stdint.h>
+
+//Live pack state in a POSIX shared memory segment.
+//A single publisher writes complete snapshots under a sequence lock, any number of local readers
+//map the segment read only and copy consistent snapshots without a system call.
+//Plain C, so scripts and tools outside of this project can use the reader with any compiler.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PACKSHM_NAME    "/spr_bms_pack"
+#define PACKSHM_MAGIC   0x534D4250u //"PBMS"
+#define PACKSHM_VERSION 1
+
+//Dimensions of the SPR21e pack, builds for another topology (bmscore/topology.pri) override them.
+//The segment size then differs, so readers built for another topology do not open it.
+#ifdef BMS_STACKS
+#define PACKSHM_STACKS            BMS_STACKS
+#define PACKSHM_CELLS_PER_STACK   BMS_CELLS_PER_STACK
+#define PACKSHM_SENSORS_PER_STACK BMS_SENSORS_PER_STACK
+#else
+#define PACKSHM_STACKS            12
+#define PACKSHM_CELLS_PER_STACK   12
+#define PACKSHM_SENSORS_PER_STACK 14
+#endif
+
+//Bits of packshm_info_t.valid
+enum {
+    PACKSHM_VALID_MIN_CELL_VOLT    = 1 << 0,
+    PACKSHM_VALID_MAX_CELL_VOLT    = 1 << 1,
+    PACKSHM_VALID_AVG_CELL_VOLT    = 1 << 2,
+    PACKSHM_VALID_MIN_SOC          = 1 << 3,
+    PACKSHM_VALID_MAX_SOC          = 1 << 4,
+    PACKSHM_VALID_BATTERY_VOLTAGE  = 1 << 5,
+    PACKSHM_VALID_DC_LINK_VOLTAGE  = 1 << 6,
+    PACKSHM_VALID_CURRENT          = 1 << 7,
+    PACKSHM_VALID_ISO_RES          = 1 << 8,
+    PACKSHM_VALID_MIN_TEMP         = 1 << 9,
+    PACKSHM_VALID_MAX_TEMP         = 1 << 10,
+    PACKSHM_VALID_AVG_TEMP         = 1 << 11
+};
+
+//Return values of packshm_read()
+enum {
+    PACKSHM_OK     = 0,
+    PACKSHM_BUSY   = -1, //No consistent snapshot within the retry limit
+    PACKSHM_CLOSED = -2  //The publisher has gone, the segment has to be opened again
+};
+
+//Fields of bms_info_t, the layout only uses fixed size types without padding
+typedef struct {
+    float minCellVolt;     //V
+    float maxCellVolt;
+    float avgCellVolt;
+    float minSoc;          //%
+    float maxSoc;
+    float batteryVoltage;  //V
+    float dcLinkVoltage;
+    float current;         //A
+    float isoRes;          //kOhm
+    float minTemp;         //degC
+    float maxTemp;
+    float avgTemp;
+    uint32_t valid;        //PACKSHM_VALID_*
+    uint8_t imdStatus;
+    uint8_t imdScStatus;
+    uint8_t amsStatus;
+    uint8_t amsScStatus;
+    uint8_t shutdownStatus;
+    uint8_t tsState;
+    uint8_t error;
+    uint8_t reserved;
+} packshm_info_t;
+
+//One snapshot per update period of the publisher (150 ms), taken at its end.
+//Cell voltages and temperatures which were not received within the period read 0,
+//the validity and the uid keep the last received value.
+typedef struct {
+    uint64_t timestamp;    //ms since epoch of the last update
+    uint64_t updates;      //Number of published snapshots
+    packshm_info_t info;
+    uint32_t uid[PACKSHM_STACKS];
+    float temperature[PACKSHM_STACKS][PACKSHM_SENSORS_PER_STACK];            //degC
+    uint16_t cellVoltage[PACKSHM_STACKS][PACKSHM_CELLS_PER_STACK];           //mV
+    uint16_t balancing[PACKSHM_STACKS];                                      //Bit n: cell n is balanced
+    uint8_t cellVoltageValidity[PACKSHM_STACKS][PACKSHM_CELLS_PER_STACK + 1]; //[0]: stack, LTC error codes
+    uint8_t temperatureValidity[PACKSHM_STACKS][PACKSHM_SENSORS_PER_STACK];
+} packshm_snapshot_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t size;         //sizeof(packshm_segment_t)
+    int32_t publisher;     //pid of the publisher, 0 once it has closed the segment
+    uint32_t sequence;     //Odd while the snapshot is being written
+    uint32_t reserved2;
+    packshm_snapshot_t snapshot;
+} packshm_segment_t;
+
+//Publisher
+packshm_segment_t *packshm_create(const char *name);
+void packshm_publish(packshm_segment_t *segment, const packshm_snapshot_t *snapshot);
+void packshm_destroy(packshm_segment_t *segment, const char *name);
+
+//Reader, returns NULL if there is no segment or its layout does not match this header
+const packshm_segment_t *packshm_open(const char *name);
+int packshm_read(const packshm_segment_t *segment, packshm_snapshot_t *snapshot);
+void packshm_close(const packshm_segment_t *segment);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PACKSHM_H
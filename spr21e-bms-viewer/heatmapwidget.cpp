@@ -0,0 +1,236 @@
+#include "heatmapwidget.h"
+
+HeatmapWidget::HeatmapWidget(QWidget *parent) : QWidget(parent)
+{
+    ::memset(voltage, 0, sizeof(voltage));
+    ::memset(voltageValidity, 0, sizeof(voltageValidity));
+    ::memset(balancing, 0, sizeof(balancing));
+    ::memset(temperature, 0, sizeof(temperature));
+    ::memset(temperatureValidity, 0, sizeof(temperatureValidity));
+
+    margin = 8;
+    gridGap = 24;
+    tileWidth = 0;
+    tileHeight = 0;
+    labelWidth = 0;
+    headerHeight = 0;
+
+    //The whole widget is covered by the cached image
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(400, 200);
+    build_luts();
+}
+
+void HeatmapWidget::set_cell_voltages(const quint16 voltages[numberOfStacks][cellsPerStack], const quint8 validity[numberOfStacks][cellsPerStack + 1])
+{
+    QPainter painter;
+    for (int stack = 0; stack < numberOfStacks; stack++) {
+        for (int cell = 0; cell < cellsPerStack; cell++) {
+            //Validity index 0 is the lower wire of the first cell
+            quint8 valid = validity[stack][cell + 1];
+            if ((voltage[stack][cell] == voltages[stack][cell]) && (voltageValidity[stack][cell] == valid)) {
+                continue;
+            }
+            voltage[stack][cell] = voltages[stack][cell];
+            voltageValidity[stack][cell] = valid;
+            if (image.isNull()) {
+                continue;
+            }
+            if (!painter.isActive()) {
+                painter.begin(&image);
+            }
+            draw_voltage_tile(painter, stack, cell);
+            update(voltage_tile_rect(stack, cell));
+        }
+    }
+}
+
+void HeatmapWidget::set_temperatures(const float temperatures[numberOfStacks][sensorsPerStack], const quint8 validity[numberOfStacks][sensorsPerStack])
+{
+    QPainter painter;
+    for (int stack = 0; stack < numberOfStacks; stack++) {
+        for (int sensor = 0; sensor < sensorsPerStack; sensor++) {
+            quint16 value = static_cast<quint16>(qMax(0.0f, temperatures[stack][sensor]) * 10.0f + 0.5f);
+            if ((temperature[stack][sensor] == value) && (temperatureValidity[stack][sensor] == validity[stack][sensor])) {
+                continue;
+            }
+            temperature[stack][sensor] = value;
+            temperatureValidity[stack][sensor] = validity[stack][sensor];
+            if (image.isNull()) {
+                continue;
+            }
+            if (!painter.isActive()) {
+                painter.begin(&image);
+            }
+            draw_temperature_tile(painter, stack, sensor);
+            update(temperature_tile_rect(stack, sensor));
+        }
+    }
+}
+
+void HeatmapWidget::set_balancing(const bool balancing[numberOfStacks][cellsPerStack])
+{
+    QPainter painter;
+    for (int stack = 0; stack < numberOfStacks; stack++) {
+        for (int cell = 0; cell < cellsPerStack; cell++) {
+            if (this->balancing[stack][cell] == balancing[stack][cell]) {
+                continue;
+            }
+            this->balancing[stack][cell] = balancing[stack][cell];
+            if (image.isNull()) {
+                continue;
+            }
+            if (!painter.isActive()) {
+                painter.begin(&image);
+            }
+            draw_voltage_tile(painter, stack, cell);
+            update(voltage_tile_rect(stack, cell));
+        }
+    }
+}
+
+void HeatmapWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.drawImage(event->rect(), image, event->rect());
+}
+
+void HeatmapWidget::resizeEvent(QResizeEvent *event)
+{
+    Q_UNUSED(event)
+    update_geometry();
+    rebuild_image();
+}
+
+void HeatmapWidget::build_luts()
+{
+    //Low cell voltages are red, high cell voltages green.
+    //Cold sensors are blue, hot sensors red.
+    for (int i = 0; i < 256; i++) {
+        voltageLut[i] = QColor::fromHsv(i * 120 / 255, 200, 230).rgb();
+        temperatureLut[i] = QColor::fromHsv(240 - i * 240 / 255, 200, 230).rgb();
+    }
+    invalidColor = QColor(Qt::gray).rgb();
+}
+
+void HeatmapWidget::update_geometry()
+{
+    QFontMetrics fm = fontMetrics();
+    labelWidth = fm.horizontalAdvance(QString("Stack %1").arg(numberOfStacks)) + 8;
+    headerHeight = 2 * fm.height() + 4;
+
+    int columns = cellsPerStack + sensorsPerStack;
+    tileWidth = qMax(1, (width() - 2 * margin - 2 * labelWidth - gridGap) / columns);
+    tileHeight = qMax(1, (height() - 2 * margin - headerHeight) / numberOfStacks);
+}
+
+void HeatmapWidget::rebuild_image()
+{
+    image = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(palette().color(QPalette::Window));
+
+    QPainter painter(&image);
+    draw_labels(painter);
+    for (int stack = 0; stack < numberOfStacks; stack++) {
+        for (int cell = 0; cell < cellsPerStack; cell++) {
+            draw_voltage_tile(painter, stack, cell);
+        }
+        for (int sensor = 0; sensor < sensorsPerStack; sensor++) {
+            draw_temperature_tile(painter, stack, sensor);
+        }
+    }
+    update();
+}
+
+QRect HeatmapWidget::voltage_tile_rect(int stack, int cell) const
+{
+    return QRect(margin + labelWidth + cell * tileWidth, margin + headerHeight + stack * tileHeight, tileWidth, tileHeight);
+}
+
+QRect HeatmapWidget::temperature_tile_rect(int stack, int sensor) const
+{
+    int left = margin + 2 * labelWidth + cellsPerStack * tileWidth + gridGap;
+    return QRect(left + sensor * tileWidth, margin + headerHeight + stack * tileHeight, tileWidth, tileHeight);
+}
+
+void HeatmapWidget::draw_labels(QPainter &painter)
+{
+    QFontMetrics fm = fontMetrics();
+    painter.setPen(palette().color(QPalette::WindowText));
+
+    QRect voltTitle(voltage_tile_rect(0, 0).left(), margin, cellsPerStack * tileWidth, fm.height());
+    painter.drawText(voltTitle, Qt::AlignLeft | Qt::AlignVCenter,
+                     QString("Cell voltages (%1 V - %2 V)").arg(minCellVoltage * 0.001f, 0, 'f', 1).arg(maxCellVoltage * 0.001f, 0, 'f', 1));
+    QRect tempTitle(temperature_tile_rect(0, 0).left(), margin, sensorsPerStack * tileWidth, fm.height());
+    painter.drawText(tempTitle, Qt::AlignLeft | Qt::AlignVCenter,
+                     QString("Temperatures (%1 °C - %2 °C)").arg(minTemperature / 10).arg(maxTemperature / 10));
+
+    for (int cell = 0; cell < cellsPerStack; cell++) {
+        QRect rect = voltage_tile_rect(0, cell);
+        painter.drawText(QRect(rect.left(), margin + fm.height(), tileWidth, fm.height()), Qt::AlignCenter, QString::number(cell + 1));
+    }
+    for (int sensor = 0; sensor < sensorsPerStack; sensor++) {
+        QRect rect = temperature_tile_rect(0, sensor);
+        painter.drawText(QRect(rect.left(), margin + fm.height(), tileWidth, fm.height()), Qt::AlignCenter, QString::number(sensor + 1));
+    }
+    for (int stack = 0; stack < numberOfStacks; stack++) {
+        QRect voltRow = voltage_tile_rect(stack, 0);
+        painter.drawText(QRect(margin, voltRow.top(), labelWidth - 4, tileHeight), Qt::AlignRight | Qt::AlignVCenter, QString("Stack %1").arg(stack + 1));
+        QRect tempRow = temperature_tile_rect(stack, 0);
+        painter.drawText(QRect(tempRow.left() - labelWidth, tempRow.top(), labelWidth - 4, tileHeight), Qt::AlignRight | Qt::AlignVCenter, QString("Stack %1").arg(stack + 1));
+    }
+}
+
+void HeatmapWidget::draw_voltage_tile(QPainter &painter, int stack, int cell)
+{
+    QRect rect = voltage_tile_rect(stack, cell);
+    QRgb color = invalidColor;
+    QString text = "--";
+    //0 was not received in this period, the decoder clears the values but keeps the last validity
+    if ((voltageValidity[stack][cell] == 0) && (voltage[stack][cell] != 0)) {
+        color = lookup(voltageLut, voltage[stack][cell], minCellVoltage, maxCellVoltage);
+        text = QString::number(voltage[stack][cell] * 0.001f, 'f', 3);
+    }
+    draw_tile(painter, rect, color, text);
+
+    if (balancing[stack][cell]) {
+        painter.setPen(QPen(Qt::darkBlue, 3));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(rect.adjusted(2, 2, -2, -2));
+    }
+}
+
+void HeatmapWidget::draw_temperature_tile(QPainter &painter, int stack, int sensor)
+{
+    QRect rect = temperature_tile_rect(stack, sensor);
+    QRgb color = invalidColor;
+    QString text = "--";
+    if ((temperatureValidity[stack][sensor] == 0) && (temperature[stack][sensor] != 0)) {
+        color = lookup(temperatureLut, temperature[stack][sensor], minTemperature, maxTemperature);
+        text = QString::number(temperature[stack][sensor] * 0.1f, 'f', 1);
+    }
+    draw_tile(painter, rect, color, text);
+}
+
+void HeatmapWidget::draw_tile(QPainter &painter, const QRect &rect, QRgb color, const QString &text)
+{
+    painter.fillRect(rect, palette().color(QPalette::Window));
+    painter.fillRect(rect.adjusted(1, 1, -1, -1), QColor(color));
+
+    //Only print the value if it fits into the tile
+    if (painter.fontMetrics().horizontalAdvance(text) + 4 <= rect.width()) {
+        painter.setPen(qGray(color) > 127 ? Qt::black : Qt::white);
+        painter.drawText(rect, Qt::AlignCenter, text);
+    }
+}
+
+QRgb HeatmapWidget::lookup(const QRgb *lut, quint16 value, quint16 min, quint16 max) const
+{
+    if (value <= min) {
+        return lut[0];
+    }
+    if (value >= max) {
+        return lut[255];
+    }
+    return lut[(value - min) * 255 / (max - min)];
+}
@@ -0,0 +1,66 @@
+#ifndef HEATMAPWIDGET_H
+#define HEATMAPWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include "packtopology.h"
+
+class HeatmapWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit HeatmapWidget(QWidget *parent = nullptr);
+
+    static const int numberOfStacks = bms_topology_t::stacks;
+    static const int cellsPerStack = bms_topology_t::cellsPerStack;
+    static const int sensorsPerStack = bms_topology_t::sensorsPerStack;
+
+    void set_cell_voltages(const quint16 voltages[numberOfStacks][cellsPerStack], const quint8 validity[numberOfStacks][cellsPerStack + 1]);
+    void set_temperatures(const float temperatures[numberOfStacks][sensorsPerStack], const quint8 validity[numberOfStacks][sensorsPerStack]);
+    void set_balancing(const bool balancing[numberOfStacks][cellsPerStack]);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    //Color ranges of the lookup tables
+    static const quint16 minCellVoltage = 3000; //mV
+    static const quint16 maxCellVoltage = 4200; //mV
+    static const quint16 minTemperature = 0;    //0.1 °C
+    static const quint16 maxTemperature = 600;  //0.1 °C
+
+    QRgb voltageLut[256];
+    QRgb temperatureLut[256];
+    QRgb invalidColor;
+
+    quint16 voltage[numberOfStacks][cellsPerStack];
+    quint8 voltageValidity[numberOfStacks][cellsPerStack];
+    bool balancing[numberOfStacks][cellsPerStack];
+    quint16 temperature[numberOfStacks][sensorsPerStack]; //0.1 °C
+    quint8 temperatureValidity[numberOfStacks][sensorsPerStack];
+
+    QImage image;
+    int margin;
+    int labelWidth;
+    int headerHeight;
+    int tileWidth;
+    int tileHeight;
+    int gridGap;
+
+    void build_luts();
+    void update_geometry();
+    void rebuild_image();
+    QRect voltage_tile_rect(int stack, int cell) const;
+    QRect temperature_tile_rect(int stack, int sensor) const;
+    void draw_labels(QPainter &painter);
+    void draw_voltage_tile(QPainter &painter, int stack, int cell);
+    void draw_temperature_tile(QPainter &painter, int stack, int sensor);
+    void draw_tile(QPainter &painter, const QRect &rect, QRgb color, const QString &text);
+    QRgb lookup(const QRgb *lut, quint16 value, quint16 min, quint16 max) const;
+};
+
+#endif // HEATMAPWIDGET_H
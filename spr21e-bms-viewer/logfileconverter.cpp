@@ -12,7 +12,17 @@ LogfileConverter::LogfileConverter(QWidget *parent) :
     ui->outputPath->setDisabled(true);
     ui->btnOutputFile->setDisabled(true);
     ui->btnConvert->setDisabled(true);
+    ui->btnSummary->setDisabled(true);
+    ui->cmbTopology->addItems(log_topologies_t::names());
 
+    follower = new LogFollower(this);
+    QObject::connect(follower, &LogFollower::new_records, this, &LogfileConverter::append_records);
+    QObject::connect(follower, &LogFollower::error, this, [=](QString message) {
+        ui->status->setText(message);
+        if (!follower->is_running()) {
+            stop_follow();
+        }
+    });
 }
 
 LogfileConverter::~LogfileConverter()
@@ -20,18 +30,20 @@ LogfileConverter::~LogfileConverter()
     delete ui;
 }
 
-LogfileConverter::logging_data_t LogfileConverter::decode_line(QByteArray &inputLine)
+template <class Topology>
+logging_record_t<Topology> LogfileConverter::decode_line(QByteArray &inputLine)
 {
     QByteArray raw = QByteArray::fromBase64(inputLine, QByteArray::Base64Encoding);
-    logging_data_t data;
+    logging_record_t<Topology> data;
     char *dataPtr = (char*) &data;
-    for (int i = 0; i < raw.length(); i++) {
+    for (int i = 0; i < qMin(raw.length(), (int)sizeof(data)); i++) {
         *dataPtr++ = raw.at(i);
     }
     return data;
 }
 
-QString LogfileConverter::raw_to_csv(logging_data_t &raw)
+template <class Topology>
+QString LogfileConverter::raw_to_csv(logging_record_t<Topology> &raw)
 {
     QString ret;
     ret.append(QString("%1-%2-%3 %4:%5:%6;").arg(raw.timestamp.year, 4, 10, QLatin1Char('0'))
@@ -41,14 +53,14 @@ QString LogfileConverter::raw_to_csv(logging_data_t &raw)
                                            .arg(raw.timestamp.minute, 2, 10, QLatin1Char('0'))
                                            .arg(raw.timestamp.second, 2, 10, QLatin1Char('0')));
 
-    for (size_t stack = 0; stack < 12; stack++) {
-        for (size_t cell = 0; cell < 12; cell++) {
+    for (size_t stack = 0; stack < Topology::stacks; stack++) {
+        for (size_t cell = 0; cell < Topology::cellsPerStack; cell++) {
             ret.append(QString("%1;").arg((float)raw.cellVoltage[stack][cell] * 0.001f, 5, 'f', 3, QLatin1Char('0')));
         }
     }
 
-    for (size_t stack = 0; stack < 12; stack++) {
-        for (size_t tempsen = 0; tempsen < 14; tempsen++) {
+    for (size_t stack = 0; stack < Topology::stacks; stack++) {
+        for (size_t tempsen = 0; tempsen < Topology::sensorsPerStack; tempsen++) {
             ret.append(QString("%1;").arg((float)raw.temperature[stack][tempsen] * 0.1f, 4, 'f', 1, QLatin1Char('0')));
         }
     }
@@ -68,15 +80,16 @@ QString LogfileConverter::raw_to_csv(logging_data_t &raw)
     return ret;
 }
 
+template <class Topology>
 QString LogfileConverter::get_header()
 {
     QString header;
     header.append("Logfile created by Battery Management Unit of SPR22e - Scuderia Mensa\r\n");
     header.append("Timestamp;");
-    for (size_t i = 0; i < 144; i++) {
+    for (size_t i = 0; i < Topology::cells; i++) {
         header.append(QString("Cell %1;").arg(i+1));
     }
-    for (size_t i = 0; i < 168; i++) {
+    for (size_t i = 0; i < Topology::sensors; i++) {
         header.append(QString("Temperature %1;").arg(i+1));
     }
     header.append("Current;");
@@ -97,11 +110,12 @@ QString LogfileConverter::get_header()
 
 void LogfileConverter::on_btnInputFile_clicked()
 {
-    QString fileName = QFileDialog::getOpenFileName(this, "Open logfile", QDir::homePath(), "Logfiles (*.log)");
+    QString fileName = QFileDialog::getOpenFileName(this, "Open logfile", QDir::homePath(), "Logfiles (*.log *.bin)");
     ui->inputPath->setText(fileName);
     if (!fileName.isEmpty()) {
         ui->outputPath->setDisabled(false);
         ui->btnOutputFile->setDisabled(false);
+        ui->btnSummary->setDisabled(false);
     }
 }
 
@@ -113,7 +127,8 @@ void LogfileConverter::on_btnOutputFile_clicked()
     QString path = QDir(fileInfo.absolutePath()).filePath(fileInfo.baseName());
     path.append(".csv");
 
-    QString fileName = QFileDialog::getSaveFileName(this, "Save CSV file", path, "CSV files (*.csv)");
+    QString fileName = QFileDialog::getSaveFileName(this, "Save CSV file", path,
+                                                    "CSV files (*.csv);;SQLite databases (*.db *.sqlite)");
 
     ui->outputPath->setText(fileName);
     if (!fileName.isEmpty()) {
@@ -123,13 +138,30 @@ void LogfileConverter::on_btnOutputFile_clicked()
 
 
 void LogfileConverter::on_btnConvert_clicked()
+{
+    if (follower->is_running()) {
+        stop_follow();
+        return;
+    }
+    if (ui->chkFollow->isChecked()) {
+        start_follow();
+        return;
+    }
+    log_topologies_t::dispatch(ui->cmbTopology->currentIndex(), [=](auto topology) {
+        convert<decltype(topology)>();
+    });
+}
+
+template <class Topology>
+void LogfileConverter::convert()
 {
     ui->status->clear();
     ui->progress->setDisabled(false);
 
-    //Open input file
+    //Open input file, binary host recordings contain the records back to back
     QFile inputFile(ui->inputPath->text());
-    if (!inputFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    bool binary = ui->inputPath->text().endsWith(".bin", Qt::CaseInsensitive);
+    if (!inputFile.open(binary ? QIODevice::ReadOnly : (QIODevice::ReadOnly | QIODevice::Text))) {
         QMessageBox mb;
         mb.setText("Cannot open input file!");
         mb.exec();
@@ -137,8 +169,17 @@ void LogfileConverter::on_btnConvert_clicked()
     }
 
     //Open output file
-    QFile outputFile(ui->outputPath->text());
-    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    QString outputName = ui->outputPath->text();
+    bool sqlite = outputName.endsWith(".db", Qt::CaseInsensitive) || outputName.endsWith(".sqlite", Qt::CaseInsensitive);
+    SqliteExporter exporter;
+    if (sqlite && !exporter.open(outputName, Topology::cells, Topology::sensors)) {
+        QMessageBox mb;
+        mb.setText("Cannot create database: " + exporter.error());
+        mb.exec();
+        return;
+    }
+    QFile outputFile(outputName);
+    if (!sqlite && !outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QMessageBox mb;
         mb.setText("Cannot open output file!");
         mb.exec();
@@ -146,20 +187,152 @@ void LogfileConverter::on_btnConvert_clicked()
     }
 
     qint64 size = inputFile.size();
-    qint64 numberOfLines = size / 885; //885 characters per line
+    qint64 numberOfLines = size / (binary ? (qint64)sizeof(logging_record_t<Topology>) : logging_line_length<Topology>());
     quint64 currentLine = 0;
     ui->progress->setMaximum(numberOfLines);
     QTextStream stream(&outputFile);
-    stream << get_header() << Qt::endl;
+    if (!sqlite) {
+        stream << get_header<Topology>() << Qt::endl;
+    }
     while (!inputFile.atEnd()) {
-        QByteArray line = inputFile.readLine();
-        logging_data_t data = decode_line(line);
-        QString csv = raw_to_csv(data);
-        stream << csv << Qt::endl;
+        logging_record_t<Topology> data;
+        if (binary) {
+            if (inputFile.read((char *)&data, sizeof(data)) != sizeof(data)) {
+                break;
+            }
+        } else {
+            QByteArray line = inputFile.readLine();
+            data = decode_line<Topology>(line);
+        }
+        if (sqlite) {
+            if (!exporter.append(data)) {
+                ui->status->setText("Error: " + exporter.error());
+                return;
+            }
+        } else {
+            QString csv = raw_to_csv<Topology>(data);
+            stream << csv << Qt::endl;
+        }
         ui->progress->setValue(++currentLine);
     }
     inputFile.close();
-    outputFile.close();
+    if (sqlite) {
+        ui->status->setText("Building indexes...");
+        if (!exporter.finish()) {
+            ui->status->setText("Error: " + exporter.error());
+            return;
+        }
+    } else {
+        outputFile.close();
+    }
+    ui->status->setText("Done.");
+}
+
+
+
+void LogfileConverter::on_btnSummary_clicked()
+{
+    log_topologies_t::dispatch(ui->cmbTopology->currentIndex(), [=](auto topology) {
+        summarize<decltype(topology)>();
+    });
+}
+
+template <class Topology>
+void LogfileConverter::summarize()
+{
+    ui->status->clear();
+    ui->progress->setDisabled(false);
+    ui->progress->setMaximum(1000);
+
+    LogSummary<Topology> summary;
+    bool ok = summary.add_file(ui->inputPath->text(), [=](qint64 done, qint64 total) {
+        ui->progress->setValue(total ? done * 1000 / total : 0);
+    });
+    if (!ok) {
+        QMessageBox mb;
+        mb.setText("Cannot open input file!");
+        mb.exec();
+        return;
+    }
     ui->status->setText("Done.");
+
+    //Overview in the message, per channel values in the details
+    QString report = summary.report();
+    QMessageBox mb;
+    mb.setWindowTitle("Summary of " + QFileInfo(ui->inputPath->text()).fileName());
+    mb.setText(report.section("\n\n", 0, 0));
+    mb.setDetailedText(report);
+    mb.exec();
+}
+
+
+void LogfileConverter::start_follow()
+{
+    QString outputName = ui->outputPath->text();
+    if (!outputName.endsWith(".csv", Qt::CaseInsensitive)) {
+        QMessageBox mb;
+        mb.setText("Follow mode writes CSV files only!");
+        mb.exec();
+        return;
+    }
+    //The follower hands over records of the SPR21e pack
+    if (ui->cmbTopology->currentText() != spr21e_topology_t::name()) {
+        QMessageBox mb;
+        mb.setText("Follow mode reads logs of the SPR21e pack only!");
+        mb.exec();
+        return;
+    }
+
+    //An existing output is continued from the checkpoint next to it
+    QString checkpointName = outputName + ".checkpoint";
+    if (!follower->start(ui->inputPath->text(), checkpointName, QFile::exists(outputName))) {
+        QMessageBox mb;
+        mb.setText("Cannot open input file!");
+        mb.exec();
+        return;
+    }
+
+    followOutput.setFileName(outputName);
+    QIODevice::OpenMode mode = follower->resumed() ? QIODevice::Append : QIODevice::WriteOnly;
+    if (!followOutput.open(mode | QIODevice::Text)) {
+        follower->stop();
+        QMessageBox mb;
+        mb.setText("Cannot open output file!");
+        mb.exec();
+        return;
+    }
+    if (!follower->resumed()) {
+        QTextStream stream(&followOutput);
+        stream << get_header<spr21e_topology_t>() << Qt::endl;
+    }
+
+    followRecords = 0;
+    ui->progress->setDisabled(true);
+    ui->chkFollow->setDisabled(true);
+    ui->btnSummary->setDisabled(true);
+    ui->btnConvert->setText("Stop");
+    ui->status->setText(follower->resumed() ? QString("Following, resumed at byte %1").arg(follower->offset())
+                                            : QString("Following"));
+}
+
+void LogfileConverter::stop_follow()
+{
+    follower->stop();
+    followOutput.close();
+    ui->chkFollow->setDisabled(false);
+    ui->btnSummary->setDisabled(false);
+    ui->btnConvert->setText("Convert");
 }
 
+//Written and flushed before the follower saves its checkpoint
+void LogfileConverter::append_records(const QVector<logging_data_t> &records)
+{
+    QTextStream stream(&followOutput);
+    for (logging_data_t record : records) {
+        stream << raw_to_csv<spr21e_topology_t>(record) << Qt::endl;
+    }
+    stream.flush();
+    followOutput.flush();
+    followRecords += records.size();
+    ui->status->setText(QString("Following, %1 records appended").arg(followRecords));
+}
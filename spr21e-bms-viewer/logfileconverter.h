@@ -9,6 +9,10 @@
 #include <QFileInfo>
 #include <QByteArray>
 #include <QMessageBox>
+#include "loggingdata.h"
+#include "sqliteexporter.h"
+#include "logsummary.h"
+#include "logfollower.h"
 
 namespace Ui {
 class LogfileConverter;
@@ -23,15 +27,6 @@ public:
     ~LogfileConverter();
 
 private:
-    typedef struct {
-        uint8_t day;
-        uint8_t month;
-        uint16_t year;
-        uint8_t hour;
-        uint8_t minute;
-        uint8_t second;
-    } rtc_date_time_t;
-
     typedef enum {
         STATE_STANDBY,
         STATE_PRE_CHARGE,
@@ -48,28 +43,17 @@ private:
     } contactor_error_t;
 
 
-    struct __attribute__((packed)) logging_data_t {
-        rtc_date_time_t timestamp;
-        uint16_t cellVoltage[12][12];
-        uint16_t temperature[12][14];
-        float current;
-        float batteryVoltage;
-        float dcLinkVoltage;
-        uint16_t minCellVolt;
-        uint16_t maxCellVolt;
-        uint16_t avgCellVolt;
-        uint16_t minTemperature;
-        uint16_t maxTemperature;
-        uint16_t avgTemperature;
-        uint8_t stateMachineError;
-        uint8_t stateMachineState;
-        uint16_t minSoc;
-        uint16_t maxSoc;
-    };
-
-    logging_data_t decode_line(QByteArray &inputLine);
-    QString raw_to_csv(logging_data_t &raw);
+    //Instantiated for every entry of log_topologies_t, selected by cmbTopology
+    template <class Topology>
+    logging_record_t<Topology> decode_line(QByteArray &inputLine);
+    template <class Topology>
+    QString raw_to_csv(logging_record_t<Topology> &raw);
+    template <class Topology>
     QString get_header();
+    template <class Topology>
+    void convert();
+    template <class Topology>
+    void summarize();
 
 
 
@@ -81,8 +65,17 @@ private slots:
 
     void on_btnConvert_clicked();
 
+    void on_btnSummary_clicked();
+
 private:
     Ui::LogfileConverter *ui;
+
+    LogFollower *follower = nullptr;
+    QFile followOutput;
+    quint64 followRecords = 0;
+    void start_follow();
+    void stop_follow();
+    void append_records(const QVector<logging_data_t> &records);
 };
 
 #endif // LOGFILECONVERTER_H
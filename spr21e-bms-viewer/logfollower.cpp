@@ -0,0 +1,152 @@
+#include "logfollower.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <cstring>
+
+LogFollower::LogFollower(QObject *parent) : QObject(parent)
+{
+    watcher = new QFileSystemWatcher(this);
+    QObject::connect(watcher, &QFileSystemWatcher::fileChanged, this, &LogFollower::read_new_data);
+
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(1000);
+    QObject::connect(pollTimer, &QTimer::timeout, this, &LogFollower::read_new_data);
+}
+
+bool LogFollower::start(QString inputName, QString checkpointName, bool resume)
+{
+    stop();
+    this->inputName = inputName;
+    this->checkpointName = checkpointName;
+    binary = inputName.endsWith(".bin", Qt::CaseInsensitive);
+    position = 0;
+    partial.clear();
+    resumedFromCheckpoint = resume && load_checkpoint();
+    if (!QFile::exists(inputName)) {
+        return false;
+    }
+
+    watcher->addPath(inputName);
+    pollTimer->start();
+    running = true;
+    //The receiver gets the chance to prepare its output before the first records
+    QTimer::singleShot(0, this, &LogFollower::read_new_data);
+    return true;
+}
+
+void LogFollower::stop()
+{
+    if (!running) {
+        return;
+    }
+    running = false;
+    pollTimer->stop();
+    watcher->removePaths(watcher->files());
+}
+
+void LogFollower::read_new_data()
+{
+    if (!running) {
+        return;
+    }
+    //Replaced files drop out of the watcher
+    if (watcher->files().isEmpty() && QFile::exists(inputName)) {
+        watcher->addPath(inputName);
+    }
+
+    //Binary mode on every platform, the offsets have to be byte offsets
+    QFile file(inputName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    if (file.size() < position) {
+        //Stopped first, the receiver of error() checks is_running() to leave follow mode
+        stop();
+        emit error("Input file was truncated, following stopped");
+        return;
+    }
+    if (file.size() == position) {
+        return;
+    }
+    file.seek(position);
+    QByteArray data = partial + file.read(readLimit);
+    position += data.size() - partial.size();
+    bool more = position < file.size();
+
+    QVector<logging_data_t> records;
+    logging_data_t record;
+    int consumed = 0;
+    if (binary) {
+        for (; consumed + (int)sizeof(logging_data_t) <= data.size(); consumed += sizeof(logging_data_t)) {
+            ::memcpy(&record, data.constData() + consumed, sizeof(logging_data_t));
+            records.append(record);
+        }
+    } else {
+        //Only complete lines, the last one may still be written
+        int end;
+        while ((end = data.indexOf('\n', consumed)) >= 0) {
+            QByteArray raw = QByteArray::fromBase64(data.mid(consumed, end - consumed).trimmed());
+            if (raw.size() == sizeof(logging_data_t)) {
+                ::memcpy(&record, raw.constData(), sizeof(logging_data_t));
+                records.append(record);
+            }
+            consumed = end + 1;
+        }
+    }
+    partial = data.mid(consumed);
+    if (partial.size() > readLimit) {
+        //No line feed in a whole read, this is not a log
+        partial.clear();
+    }
+
+    if (!records.isEmpty()) {
+        emit new_records(records);
+    }
+    save_checkpoint();
+
+    //Large backlogs are read in steps, the event loop keeps running in between
+    if (more) {
+        QTimer::singleShot(0, this, &LogFollower::read_new_data);
+    }
+}
+
+bool LogFollower::load_checkpoint()
+{
+    QFile file(checkpointName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonObject checkpoint = QJsonDocument::fromJson(file.readAll()).object();
+    if (checkpoint.value("input").toString() != QFileInfo(inputName).absoluteFilePath()) {
+        return false;
+    }
+    qint64 offset = checkpoint.value("offset").toVariant().toLongLong();
+    if ((offset < 0) || (offset > QFileInfo(inputName).size())) {
+        return false;
+    }
+    position = offset;
+    partial = QByteArray::fromBase64(checkpoint.value("partial").toString().toLatin1());
+    return true;
+}
+
+void LogFollower::save_checkpoint()
+{
+    QJsonObject checkpoint;
+    checkpoint.insert("input", QFileInfo(inputName).absoluteFilePath());
+    checkpoint.insert("offset", QString::number(position));
+    checkpoint.insert("partial", QString::fromLatin1(partial.toBase64()));
+
+    //Replaced atomically, a crash leaves the previous checkpoint
+    QSaveFile file(checkpointName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        emit error("Cannot write " + checkpointName);
+        return;
+    }
+    file.write(QJsonDocument(checkpoint).toJson());
+    if (!file.commit()) {
+        emit error("Cannot write " + checkpointName);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef LOGFOLLOWER_H
+#define LOGFOLLOWER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QVector>
+#include "loggingdata.h"
+
+//Follows a log which is still being written and decodes only the data appended since the last read.
+//After every batch of records a checkpoint with the byte offset and the incomplete last line is saved,
+//so a restart continues where the previous run stopped.
+class LogFollower : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LogFollower(QObject *parent = nullptr);
+
+    //Continues from the checkpoint if resume is set and the checkpoint belongs to the input
+    bool start(QString inputName, QString checkpointName, bool resume);
+    void stop();
+    bool is_running() const { return running; }
+    bool resumed() const { return resumedFromCheckpoint; }
+    qint64 offset() const { return position; }
+
+signals:
+    //Delivered before the checkpoint is saved, the receiver has to write them synchronously
+    void new_records(const QVector<logging_data_t> &records);
+    //Following has already stopped if is_running() is false when this is emitted
+    void error(QString message);
+
+private:
+    static const qint64 readLimit = 16 * 1024 * 1024;
+
+    QFileSystemWatcher *watcher;
+    QTimer *pollTimer; //Some file systems do not report changes
+    QString inputName;
+    QString checkpointName;
+    bool binary = false;
+    bool running = false;
+    bool resumedFromCheckpoint = false;
+    qint64 position = 0;
+    QByteArray partial; //Incomplete line or record at position
+
+    void read_new_data();
+    bool load_checkpoint();
+    void save_checkpoint();
+};
+
+#endif // LOGFOLLOWER_H
@@ -5,7 +5,9 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    a.setOrganizationName("Scuderia Mensa");
+    a.setApplicationName("spr21e-bms-viewer");
     MainWindow w;
-    w.hide();
+    w.show();
     return a.exec();
 }
@@ -7,14 +7,6 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
 
-    if (geteuid()) {
-        QMessageBox mb;
-        mb.setText("Some parts of this software require root privileges! Click OK and enter your password or run as root.");
-        mb.exec();
-    }
-
-
-    ::memset(&bmsInfo, 0, sizeof(bms_info_t));
     ::memset(&balanceStatus, 0, sizeof(balanceStatus));
 
     updateTimer = new QTimer();
@@ -24,6 +16,57 @@ MainWindow::MainWindow(QWidget *parent)
 
     interfaceUp = false;
     can = new Can(this);
+    const quint32 bitrates[] = {125000, 250000, 500000, 1000000};
+    for (quint32 bitrate : bitrates) {
+        ui->cbBitrate->addItem(QString("%1 kbit/s").arg(bitrate / 1000), bitrate);
+    }
+    ui->cbBitrate->setCurrentIndex(qMax(0, ui->cbBitrate->findData(can->link_config().bitrate)));
+    ui->sbSamplePoint->setValue(can->link_config().samplePoint / 10.0);
+    ui->cbDataBitrate->addItem("Classic CAN", 0);
+    const quint32 dataBitrates[] = {2000000, 4000000, 5000000, 8000000};
+    for (quint32 bitrate : dataBitrates) {
+        ui->cbDataBitrate->addItem(QString("FD %1 Mbit/s").arg(bitrate / 1000000), bitrate);
+    }
+    ui->cbDataBitrate->setCurrentIndex(qMax(0, ui->cbDataBitrate->findData(can->link_config().dataBitrate)));
+    decoder = new BmsDecoder(this);
+    //Full rate for 10 minutes, 1 s aggregates for 24 hours, 128 MiB at most
+    history = new BmsHistory(decoder, 128 * 1024 * 1024, 600, 86400);
+    sessionLogger = new SessionLogger(decoder, this);
+    QObject::connect(sessionLogger, &SessionLogger::failed, this, [=](QString message) {
+        //A file which cannot be opened ends the recording
+        if (!sessionLogger->is_recording()) {
+            QSignalBlocker blocker(ui->actionRecord_session);
+            ui->actionRecord_session->setChecked(false);
+        }
+        ui->statusbar->showMessage(message);
+    });
+    QObject::connect(decoder, &BmsDecoder::decoded, this, [=](quint32 frameId, quint8 stack) {
+        append_plot_samples(frameId);
+        history->record(frameId, stack);
+        sessionLogger->update(frameId, stack);
+    });
+    QObject::connect(decoder, &BmsDecoder::transition, this, [=](EventLog::source_t source, quint16 code) {
+        eventLog->log(source, code);
+        recorder->event(source, code);
+    });
+    balancing = new Balancing(this);
+    diag = new DiagEngine(BmsDecoder::ID_DIAG_REQUEST, this);
+    QObject::connect(diag, &DiagEngine::send_frame, can, &Can::send_frame);
+    QObject::connect(diag, &DiagEngine::failed, this, [=](quint8 command, quint8 stack) {
+        //Failed balancing polls are reported by Balancing once per stack, not per request
+        if (!balancing->request_failed(command, stack)) {
+            eventLog->log(EventLog::SOURCE_DIAG, command, stack);
+        }
+    });
+    QObject::connect(balancing, &Balancing::diag_request, diag, &DiagEngine::submit);
+    QObject::connect(balancing, &Balancing::stack_answering, this, [=](quint8 stack, bool answering) {
+        eventLog->log(EventLog::SOURCE_DIAG_STACK, answering, stack);
+    });
+    QObject::connect(balancing, &Balancing::changed, this, &MainWindow::update_ui_balancing);
+    //Pack state for other local tools, the viewer works without it
+    publisher = new PackPublisher(decoder, this);
+    publisher->set_balancing(balancing);
+    publisher->open();
     QObject::connect(can, &Can::error, this, [=](QString err) {
         QMessageBox mb;
         mb.setText(err);
@@ -35,7 +78,11 @@ MainWindow::MainWindow(QWidget *parent)
         ui->parameters->setEnabled(true);
         ui->btnConnectPcan->setText("Disconnect");
         ui->cbSelectPCAN->setEnabled(false);
+        ui->cbBitrate->setEnabled(false);
+        ui->cbDataBitrate->setEnabled(false);
+        ui->sbSamplePoint->setEnabled(false);
         updateTimer->start();
+        balancing->start_polling();
     });
     QObject::connect(can, &Can::device_down, this, [=] {
         interfaceUp = false;
@@ -43,22 +90,43 @@ MainWindow::MainWindow(QWidget *parent)
         ui->parameters->setEnabled(false);
         ui->btnConnectPcan->setText("Connect");
         ui->cbSelectPCAN->setEnabled(true);
+        ui->cbBitrate->setEnabled(true);
+        ui->cbDataBitrate->setEnabled(true);
+        ui->sbSamplePoint->setEnabled(true);
         updateTimer->stop();
+        balancing->stop_polling();
+        diag->clear();
     });
     QObject::connect(can, &Can::new_frame, this, &MainWindow::new_frame);
     QObject::connect(can, &Can::available_devices, this, [=] (QStringList names) {
+        QString current = ui->cbSelectPCAN->currentText();
+        ui->cbSelectPCAN->clear();
         ui->cbSelectPCAN->addItems(names);
-        this->show();});
-    can->init();
-
-    sendTimer = new QTimer(this);
-    sendTimer->setInterval(100);
-    QObject::connect(sendTimer, &QTimer::timeout, this, &MainWindow::send_ts_req);
+        if (names.contains(current)) {
+            ui->cbSelectPCAN->setCurrentText(current);
+        }
+    });
+    QObject::connect(can, &Can::progress, this, [=] (QString message) {
+        ui->statusbar->showMessage(message);
+    });
+    //Bring the link up after the window is shown
+    QTimer::singleShot(0, can, &Can::init);
 
     ui->infoFrame->setEnabled(false);
     ui->parameters->setEnabled(false);
+    setup_tree();
+    setup_plots();
+    setup_event_log();
+    setup_link_monitor();
+    setup_statistics();
+    setup_streaming();
+    setup_flight_recorder();
+
+    renderScheduler = new RenderScheduler(this, this);
+    renderScheduler->add_view(ui->parameters, [=] { update_tree(); });
+    renderScheduler->add_view(ui->heatmap, [=] { update_heatmap(); });
+    renderScheduler->add_view(ui->infoFrame, [=] { update_info(); });
 
-    linkAvailable = false;
     QPixmap scuderiaLogo(":/img/logo.png");
 
     ui->scuderiaLogo->setScaledContents(true);
@@ -74,165 +142,71 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    statisticsThread->quit();
+    statisticsThread->wait();
+    delete history;
     delete ui;
 }
 
 void MainWindow::new_frame(QCanBusFrame frame)
 {
-    static uint16_t fullUpdate = 0;
+    recorder->record(frame);
+    decoder->decode(frame);
 
     switch (frame.frameId()) {
-    case ID_BMS_INFO_1:
-        decompose_bms_1(frame.payload());
-        fullUpdate |= (1 << 0);
-        break;
-    case ID_BMS_INFO_2:
-        decompose_bms_2(frame.payload());
-        fullUpdate |= (1 << 1);
-        break;
-    case ID_BMS_INFO_3:
-        decompose_bms_3(frame.payload());
-        fullUpdate |= (1 << 2);
-        break;
-    case ID_CELL_VOLT_1:
-        decomposeCellVoltage((quint8)frame.payload().at(0) >> 4, 0, frame.payload());
-        fullUpdate |= (1 << 3);
-        break;
-    case ID_CELL_VOLT_2:
-        decomposeCellVoltage((quint8)frame.payload().at(0) >> 4, 3, frame.payload());
-        fullUpdate |= (1 << 4);
-        break;
-    case ID_CELL_VOLT_3:
-        decomposeCellVoltage((quint8)frame.payload().at(0) >> 4, 6, frame.payload());
-        fullUpdate |= (1 << 5);
-        break;
-    case ID_CELL_VOLT_4:
-        decomposeCellVoltage((quint8)frame.payload().at(0) >> 4, 9, frame.payload());
-        fullUpdate |= (1 << 6);
-        break;
-    case ID_CELL_TEMP_1:
-        decomposeCellTemperatures((quint8)frame.payload().at(0) >> 4, 0, frame.payload());
-        fullUpdate |= (1 << 7);
-        break;
-    case ID_CELL_TEMP_2:
-        decomposeCellTemperatures((quint8)frame.payload().at(0) >> 4, 5, frame.payload());
-        fullUpdate |= (1 << 8);
-        break;
-    case ID_CELL_TEMP_3:
-        decomposeCellTemperatures((quint8)frame.payload().at(0) >> 4, 10, frame.payload());
-        fullUpdate |= (1 << 9);
-        break;
-    case ID_UID:
-        decomposeUid((quint8)frame.payload().at(0) >> 4, frame.payload());
-        fullUpdate |= (1 << 10);
-        break;
-    case ID_DIAG_RESPONSE:
+    case BmsDecoder::ID_DIAG_RESPONSE:
         handle_diag_response(frame);
         break;
-    case 0x00E:
-        //Balancing activity
-        decompose_balance(frame);
+    case BmsDecoder::ID_BALANCING:
+        balancing->merge_activity(frame.payload());
         break;
     }
-
-    if (fullUpdate == 0x7FF) {
-        linkAvailable = true;
-        fullUpdate = 0;
-    }
-
 }
 
-void MainWindow::send_ts_req()
-{
-    QCanBusFrame frame;
-    QByteArray payload;
-    frame.setFrameId(0);
-    payload.append(0xFF);
-    frame.setPayload(payload);
-    can->send_frame(frame);
-}
-
-QString MainWindow::error_to_string(error_code_t error)
+void MainWindow::handle_diag_response(QCanBusFrame &frame)
 {
-    switch (error) {
-    case ERROR_NO_ERROR:
-        return "Error cleared.";
-    case ERROR_SYSTEM_NOT_HEALTHY:
-        return "System not healthy!";
-    case ERROR_CONTACTOR_IMPLAUSIBLE:
-        return "Contactor state implausible!";
-    case ERROR_PRE_CHARGE_TOO_SHORT:
-        return "Pre-charge too short!";
-    case ERROR_PRE_CHARGE_TIMEOUT:
-        return "Pre-charge timed out!";
+    if (frame.payload().isEmpty()) {
+        return;
     }
-    return "Undefined error.";
-}
+    //Late answers to timed out requests still carry valid data and are decoded as well
+    diag->handle_response(frame);
 
-void MainWindow::poll_balance_status()
-{
-    ::memset(balanceStatus, 0, sizeof(balanceStatus));
-    QCanBusFrame frame;
-    frame.setFrameId(ID_DIAG_REQUEST);
-    QByteArray payload;
-    payload.append(0x3);
-    payload.append((quint8)0);
-    payload.append((quint8)0);
-    frame.setPayload(payload);
-    can->send_frame(frame);
-}
-
-void MainWindow::handle_diag_response(QCanBusFrame &frame)
-{
     switch (frame.payload().at(0)) {
     case 0x3: //Get balancing
-        for (size_t i = 0; i < 8; i++) {
-            balanceStatus[0][i] |= (frame.payload().at(3) >> (7 - i)) & 0x01;
-        }
-        for (size_t i = 0; i < 4; i++) {
-            balanceStatus[0][i + 8] |= (frame.payload().at(4) >> (7 - i)) & 0x01;
-        }
-        update_ui_balancing();
+        balancing->merge_diag_response(frame.payload());
         break;
     }
 }
 
-void MainWindow::update_ui_balancing()
+void MainWindow::update_ui_balancing(QVector<quint16> cells)
 {
+    //Only restyle the cells whose status changed
     QTreeWidgetItem *volts = ui->parameters->topLevelItem(1); // Voltages
-    for (quint16 stack = 0; stack < 12; stack++) {
-        for (quint16 cell = 0; cell < 12; cell++) {
-            if (balanceStatus[stack][cell]) {
-                volts->child(stack)->setBackground(cell+2, Qt::darkBlue);
-                volts->child(stack)->setForeground(cell+2, Qt::white);
+    for (quint16 index : cells) {
+        quint16 stack = index / bms_topology_t::cellsPerStack;
+        quint16 cell = index % bms_topology_t::cellsPerStack;
+        balanceStatus[stack][cell] = balancing->is_balancing(stack, cell);
+        if (balanceStatus[stack][cell]) {
+            volts->child(stack)->setBackground(cell+2, Qt::darkBlue);
+            volts->child(stack)->setForeground(cell+2, Qt::white);
 
-            } else {
-                volts->child(stack)->setBackground(cell+2, Qt::transparent);
+        } else {
+            volts->child(stack)->setBackground(cell+2, Qt::transparent);
 
-                if (darkMode) {
-                    volts->child(stack)->setForeground(cell+2, Qt::white);
-                } else {
-                    volts->child(stack)->setForeground(cell+2, Qt::black);
-                }
+            if (darkMode) {
+                volts->child(stack)->setForeground(cell+2, Qt::white);
+            } else {
+                volts->child(stack)->setForeground(cell+2, Qt::black);
             }
         }
     }
+    ui->heatmap->set_balancing(balanceStatus);
 }
 
 void MainWindow::global_balancing_enable(bool enable)
 {
-    QCanBusFrame frame;
-    QByteArray payload;
-    frame.setFrameId(ID_DIAG_REQUEST);
-    payload.append(0x04);
-    payload.append((quint8) 0x00);
-    if (enable) {
-        payload.append(0x01);
-    } else {
-        payload.append((quint8) 0x00);
-    }
-    frame.setPayload(payload);
-    can->send_frame(frame);
+    //The BMU does not answer this command, a transaction would only time out and retransmit
+    diag->send(0x04, 0x00, QByteArray(1, enable ? 0x01 : 0x00));
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -240,171 +214,285 @@ void MainWindow::closeEvent(QCloseEvent *event)
     if (can) {
         can->disconnect_device();
     }
+    streamClient->disconnect_from();
+    streamServer->close();
+    recorder->stop();
+    sessionLogger->stop();
 }
 
-void MainWindow::decomposeCellVoltage(quint8 stack, quint8 cellOffset, QByteArray payload)
+void MainWindow::setup_streaming()
 {
-    QVector<quint16> voltages(3);
-    voltages[0] = ((quint8)payload.at(1) << 5) | ((quint8)payload.at(2) >> 3);
-    voltages[1] = ((quint8)payload.at(3) << 5) | ((quint8)payload.at(4) >> 3);
-    voltages[2] = ((quint8)payload.at(5) << 5) | ((quint8)payload.at(6) >> 3);
+    streamServer = new StreamServer(this);
+    QObject::connect(can, &Can::new_frame, streamServer, &StreamServer::add_frame);
+    QObject::connect(streamServer, &StreamServer::clients_changed, this, [=](int count) {
+        ui->statusbar->showMessage(QString("%1 telemetry clients connected").arg(count));
+    });
 
-    cellVoltages[stack][cellOffset] = voltages.at(0);
-    cellVoltages[stack][cellOffset+1] = voltages.at(1);
-    cellVoltages[stack][cellOffset+2] = voltages.at(2);
+    //Remote frames take the same path as local ones, only the decoded ids are requested
+    streamClient = new StreamClient(this);
+    QVector<quint32> ids;
+    for (quint32 id = BmsDecoder::ID_BMS_INFO_1; id <= BmsDecoder::ID_UID; id++) {
+        ids.append(id);
+    }
+    ids << BmsDecoder::ID_DIAG_RESPONSE << BmsDecoder::ID_BALANCING
+        << BmsDecoder::ID_FD_CELL_VOLT << BmsDecoder::ID_FD_CELL_TEMP;
+    streamClient->subscribe(ids);
+    QObject::connect(streamClient, &StreamClient::new_frame, this, &MainWindow::new_frame);
+    QObject::connect(streamClient, &StreamClient::connected, this, [=] {
+        set_remote_ui(true);
+        ui->statusbar->showMessage("Connected to remote telemetry");
+    });
+    QObject::connect(streamClient, &StreamClient::disconnected, this, [=] {
+        set_remote_ui(false);
+        ui->actionConnect_to_remote->setChecked(false);
+        ui->statusbar->showMessage("Remote telemetry disconnected");
+    });
+    QObject::connect(streamClient, &StreamClient::error, this, [=](QString message) {
+        ui->statusbar->showMessage(message);
+        ui->actionConnect_to_remote->setChecked(false);
+    });
+}
 
-    if (cellOffset == 0) {
-        cellVoltageValidity[stack][0] = ((quint8)payload.at(0) & 0x3);
-    }
-    cellVoltageValidity[stack][cellOffset + 1] = ((quint8)payload.at(2) & 0x3);
-    cellVoltageValidity[stack][cellOffset + 2] = ((quint8)payload.at(4) & 0x3);
-    cellVoltageValidity[stack][cellOffset + 3] = ((quint8)payload.at(6) & 0x3);
+void MainWindow::setup_flight_recorder()
+{
+    //Frames around every BMS fault, 10 s before and 5 s after the trigger
+    recorder = new FlightRecorder(1 << 16, this);
+    recorder->set_directory(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/flight-recorder");
+    recorder->set_windows(10000, 5000);
+    QObject::connect(recorder, &FlightRecorder::written, this, [=](QString fileName, int count) {
+        ui->statusbar->showMessage(QString("Flight recorder: %1 frames written to %2").arg(count).arg(fileName));
+    });
+    QObject::connect(recorder, &FlightRecorder::failed, this, [=](QString fileName) {
+        ui->statusbar->showMessage("Flight recorder: cannot write " + fileName);
+    });
+}
 
+void MainWindow::set_remote_ui(bool remote)
+{
+    //Remote data is read only, requests can only be sent on the local bus
+    ui->btnConnectPcan->setEnabled(!remote);
+    ui->reqTsActive->setEnabled(!remote);
+    ui->diagButton->setEnabled(!remote);
+    ui->actionServe_telemetry->setEnabled(!remote);
+    ui->infoFrame->setEnabled(remote || interfaceUp);
+    ui->parameters->setEnabled(remote || interfaceUp);
+    if (remote) {
+        decoder->clear_measurements();
+        updateTimer->start();
+    } else if (!interfaceUp) {
+        updateTimer->stop();
+    }
 }
 
-void MainWindow::decomposeCellTemperatures(quint8 stack, quint8 offset, QByteArray payload)
+void MainWindow::setup_plots()
 {
-    temperatures[stack][offset + 0] = ((((quint16)payload.at(0) & 0xF) << 6) | (quint8)payload.at(1) >> 2) * 0.1f;
-    temperatures[stack][offset + 1] = (((quint8)payload.at(2) << 2) | ((quint8)payload.at(3) >> 6)) * 0.1f;
-    temperatures[stack][offset + 2] = ((((quint16)payload.at(3) & 0xF) << 6) | ((quint8)payload.at(4) >> 2)) * 0.1f;
-    temperatures[stack][offset + 3] = (((quint8)payload.at(5) << 2) | ((quint8)payload.at(6) >> 6)) * 0.1f;
+    ui->plotCurrent->set_title("Current");
+    ui->plotCurrent->set_unit("A");
+    ui->plotCurrent->add_series("Current", QColor(31, 119, 180));
+
+    ui->plotVoltage->set_title("Voltage");
+    ui->plotVoltage->set_unit("V");
+    ui->plotVoltage->add_series("Battery", QColor(31, 119, 180));
+    ui->plotVoltage->add_series("DC-Link", QColor(255, 127, 14));
+
+    ui->plotCellVoltage->set_title("Cell voltage");
+    ui->plotCellVoltage->set_unit("V");
+    ui->plotCellVoltage->add_series("Min", QColor(214, 39, 40));
+    ui->plotCellVoltage->add_series("Max", QColor(44, 160, 44));
+
+    ui->plotTemperature->set_title("Temperature");
+    ui->plotTemperature->set_unit("°C");
+    ui->plotTemperature->add_series("Min", QColor(31, 119, 180));
+    ui->plotTemperature->add_series("Max", QColor(214, 39, 40));
+
+    ui->plotSoc->set_title("SOC");
+    ui->plotSoc->set_unit("%");
+    ui->plotSoc->add_series("Min", QColor(214, 39, 40));
+    ui->plotSoc->add_series("Max", QColor(44, 160, 44));
+
+    //Time window in seconds
+    ui->plotWindow->addItem("10 s", 10);
+    ui->plotWindow->addItem("30 s", 30);
+    ui->plotWindow->addItem("1 min", 60);
+    ui->plotWindow->addItem("5 min", 300);
+    ui->plotWindow->addItem("10 min", 600);
+    ui->plotWindow->addItem("30 min", 1800);
+    ui->plotWindow->addItem("1 h", 3600);
+    ui->plotWindow->setCurrentIndex(2);
+}
 
-    temperatureValidity[stack][offset + 0] = ((quint8)payload.at(1) & 0x3);
-    temperatureValidity[stack][offset + 1] = (((quint8)payload.at(3) >> 4) & 0x3);
-    temperatureValidity[stack][offset + 2] = ((quint8)payload.at(4) & 0x3);
-    temperatureValidity[stack][offset + 3] = (((quint8)payload.at(6) >> 4) & 0x3);
+void MainWindow::append_plot_samples(quint32 frameId)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const BmsDecoder::bms_info_t &bmsInfo = decoder->info();
 
-    if (offset == 10) {
-        return;
+    switch (frameId) {
+    case BmsDecoder::ID_BMS_INFO_1:
+        if (bmsInfo.minCellVoltValid) {
+            ui->plotCellVoltage->append(0, now, bmsInfo.minCellVolt);
+        }
+        if (bmsInfo.maxCellVoltValid) {
+            ui->plotCellVoltage->append(1, now, bmsInfo.maxCellVolt);
+        }
+        if (bmsInfo.minSocValid) {
+            ui->plotSoc->append(0, now, bmsInfo.minSoc);
+        }
+        if (bmsInfo.maxSocValid) {
+            ui->plotSoc->append(1, now, bmsInfo.maxSoc);
+        }
+        break;
+    case BmsDecoder::ID_BMS_INFO_2:
+        if (bmsInfo.batteryVoltageValid) {
+            ui->plotVoltage->append(0, now, bmsInfo.batteryVoltage);
+        }
+        if (bmsInfo.dcLinkVoltageValid) {
+            ui->plotVoltage->append(1, now, bmsInfo.dcLinkVoltage);
+        }
+        if (bmsInfo.currentValid) {
+            ui->plotCurrent->append(0, now, bmsInfo.current);
+        }
+        break;
+    case BmsDecoder::ID_BMS_INFO_3:
+        if (bmsInfo.minTempValid) {
+            ui->plotTemperature->append(0, now, bmsInfo.minTemp);
+        }
+        if (bmsInfo.maxTempValid) {
+            ui->plotTemperature->append(1, now, bmsInfo.maxTemp);
+        }
+        break;
     }
-    temperatures[stack][offset + 4] = ((((quint8)payload.at(6) & 0xF) << 6) | ((quint8)payload.at(7) >> 2)) * 0.1f;
-
-    temperatureValidity[stack][offset + 4] = ((quint8)payload.at(7) & 0x3);
 }
 
-void MainWindow::decomposeUid(quint8 stack, QByteArray payload)
+void MainWindow::setup_event_log()
 {
-    uid[stack] = (quint8)payload.at(1) << 24 | (quint8)payload.at(2) << 16 | (quint8)payload.at(3) << 8 | (quint8)payload.at(4);
+    eventLog = new EventLog(1 << 20, this);
+    eventLog->set_formatter(&BmsDecoder::describe_event);
+
+    ui->errorLog->setModel(eventLog);
+    ui->errorLog->verticalHeader()->hide();
+    ui->errorLog->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->errorLog->verticalHeader()->setDefaultSectionSize(ui->errorLog->fontMetrics().height() + 4);
+    //Fixed column widths, resizing to contents would have to measure rows on every insert
+    ui->errorLog->setColumnWidth(EventLog::COLUMN_TIME, ui->errorLog->fontMetrics().horizontalAdvance("00.00.0000 00:00:00.000") + 12);
+    ui->errorLog->setColumnWidth(EventLog::COLUMN_SOURCE, ui->errorLog->fontMetrics().horizontalAdvance("Shutdown circuit") + 12);
+    ui->errorLog->horizontalHeader()->setStretchLastSection(true);
+
+    //Follow new events as long as the view is scrolled to the bottom
+    QObject::connect(eventLog, &QAbstractItemModel::rowsAboutToBeInserted, this, [=] {
+        QScrollBar *scrollBar = ui->errorLog->verticalScrollBar();
+        ui->errorLog->setProperty("followTail", scrollBar->value() == scrollBar->maximum());
+    });
+    QObject::connect(eventLog, &EventLog::rows_appended, this, [=] {
+        if (ui->errorLog->property("followTail").toBool()) {
+            ui->errorLog->scrollToBottom();
+        }
+    });
+
+    ui->errorLogFilter->addItem("All events", 0xFFFFFFFF);
+    ui->errorLogFilter->addItem("BMS errors", 1 << EventLog::SOURCE_BMS_ERROR);
+    ui->errorLogFilter->addItem("TS state", 1 << EventLog::SOURCE_TS_STATE);
+    ui->errorLogFilter->addItem("Shutdown circuit", 1 << EventLog::SOURCE_SHUTDOWN);
+    ui->errorLogFilter->addItem("IMD", (1 << EventLog::SOURCE_IMD) | (1 << EventLog::SOURCE_IMD_SC));
+    ui->errorLogFilter->addItem("AMS", (1 << EventLog::SOURCE_AMS) | (1 << EventLog::SOURCE_AMS_SC));
+    ui->errorLogFilter->addItem("Link", 1 << EventLog::SOURCE_LINK);
+    ui->errorLogFilter->addItem("CAN bus", (1 << EventLog::SOURCE_CAN_BUS) | (1 << EventLog::SOURCE_CAN_RECOVERY));
+    ui->errorLogFilter->addItem("Diagnostic", (1 << EventLog::SOURCE_DIAG) | (1 << EventLog::SOURCE_DIAG_STACK));
 }
 
-void MainWindow::decompose_bms_1(QByteArray payload)
+void MainWindow::setup_link_monitor()
 {
-    bmsInfo.minCellVolt = (float)(((quint16)(payload[0] & 0xFF) << 5) | (quint16)(payload[1] & 0xFF) >> 3) * 0.001f;
-    bmsInfo.minCellVoltValid = (payload[1] >> 2) & 0x01;
-    bmsInfo.maxCellVolt =(float)((quint16)((payload[1] & 0x03) << 11) | ((quint16)(payload[2] & 0xFF) << 3) | (quint8)payload[3] >> 5) * 0.001f;
-    bmsInfo.maxCellVoltValid = (payload[3] >> 4) & 0x01;
-    bmsInfo.avgCellVolt = (float)((quint16)((payload[3] & 0x0F) << 9) | (quint16)((payload[4] & 0xFF) << 1) | (quint16)((payload[5] >> 7) & 0x01)) * 0.001f;
-    bmsInfo.avgCellVoltValid = (payload[5] >> 6) & 0x01;
-    bmsInfo.minSoc = (float)(((quint16)(payload[5] & 0x3F) << 4) | (quint16)((payload[6] >> 4) & 0x0F)) * 0.1f;
-    bmsInfo.minSocValid = (payload[6] >> 3) & 0x01;
-    bmsInfo.maxSoc = (float)(((quint16)(payload[6] & 0x07) << 7) | (quint16)((payload[7] >> 1) & 0x7F)) * 0.1f;
-    bmsInfo.maxSocValid = (payload[7] & 0x01);
+    LinkMonitor *monitor = can->link_monitor();
+    linkHealthLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(linkHealthLabel);
 
+    QObject::connect(monitor, &LinkMonitor::health_changed, this, [=](int health, qint64 duration) {
+        eventLog->log(EventLog::SOURCE_CAN_BUS, health, duration);
+        linkHealthLabel->setText("CAN: " + LinkMonitor::health_to_string(health));
+    });
+    QObject::connect(monitor, &LinkMonitor::error_counters, this, [=](quint16 tx, quint16 rx) {
+        linkHealthLabel->setToolTip(QString("TX errors: %1, RX errors: %2").arg(tx).arg(rx));
+    });
+    QObject::connect(monitor, &LinkMonitor::restart_link, this, [=](int attempt) {
+        eventLog->log(EventLog::SOURCE_CAN_RECOVERY, LinkMonitor::RECOVERY_ATTEMPT, attempt);
+    });
+    QObject::connect(monitor, &LinkMonitor::recovered, this, [=](qint64 outage) {
+        eventLog->log(EventLog::SOURCE_CAN_RECOVERY, LinkMonitor::RECOVERY_DONE, outage);
+    });
+    QObject::connect(can, &Can::device_up, this, [=] {
+        linkHealthLabel->setText("CAN: " + LinkMonitor::health_to_string(monitor->health()));
+    });
+    QObject::connect(can, &Can::device_down, this, [=] {
+        linkHealthLabel->clear();
+    });
 }
 
-void MainWindow::decompose_bms_2(QByteArray payload)
-{
-    bmsInfo.batteryVoltage = (float)(((quint16)(payload[0] & 0xFF) << 5) | (quint16)((payload[1] >> 3) & 0x1F)) * 0.1f;
-    bmsInfo.batteryVoltageValid = (payload[1] >> 2) & 0x01;
-    bmsInfo.dcLinkVoltage = (float)(((quint16)(payload[2] & 0xFF) << 5) | (quint16)((payload[3] >> 3) & 0x1F)) * 0.1f;
-    bmsInfo.dcLinkVoltageValid = (payload[3] >> 2) & 0x01;
-    bmsInfo.current = (float)(((qint16)(payload[4]) << 8) | (quint8)(payload[5])) * 0.00625f;
-    bmsInfo.currentValid = (payload[6] >> 7) & 0x01;
+void MainWindow::setup_statistics()
+{
+    statisticsThread = new QThread(this);
+    statistics = new CellStatistics();
+    statistics->moveToThread(statisticsThread);
+    QObject::connect(statisticsThread, &QThread::finished, statistics, &QObject::deleteLater);
+    QObject::connect(this, &MainWindow::cell_snapshot, statistics, &CellStatistics::process);
+    QObject::connect(statistics, &CellStatistics::result, this, &MainWindow::show_statistics);
+    statisticsThread->start(QThread::LowPriority);
+
+    statisticsLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(statisticsLabel);
+    diagLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(diagLabel);
 }
 
-void MainWindow::decompose_bms_3(QByteArray payload)
+void MainWindow::publish_snapshot()
 {
-    bmsInfo.isoRes = (float)(((quint16)(payload[0] & 0xFF) << 7) | (quint16)((payload[1] >> 1) & 0x7F)) * 0.1f;
-    bmsInfo.isoResValid = payload[1] & 0x01;
-    bmsInfo.shutdownStatus = (payload[2] >> 7) & 0x01;
-    bmsInfo.tsState = static_cast<ts_state_t>((payload[2] >> 5) & 0x03);
-    bmsInfo.amsScStatus = (payload[2] >> 4) & 0x01;
-    bmsInfo.amsStatus = (payload[2] >> 3) & 0x01;
-    bmsInfo.imdScStatus = (payload[2] >> 2) & 0x01;
-    bmsInfo.imdStatus = (payload[2] >> 1) & 0x01;
-    bmsInfo.error = static_cast<error_code_t>(payload[3] >> 1);
-    bmsInfo.minTemp = (float)(((quint16)(payload[3] & 0x01) << 9) | (quint16)((payload[4] & 0xFF) << 1) | (quint16)((payload[5] >> 7) & 0x01)) * 0.1f;
-    bmsInfo.minTempValid = (payload[5] >> 6) & 0x01;
-    bmsInfo.maxTemp = (float)(((quint16)(payload[5] & 0x3F) << 4) | (quint16)((payload[6] >> 4) & 0x0F)) * 0.1f;
-    bmsInfo.maxTempValid = (payload[6] >> 3) & 0x01;
-    bmsInfo.avgTemp = (float)(((quint16)(payload[6] & 0x07) << 7) | (quint16)((payload[7] >> 1) & 0x7F)) * 0.1f;
-    bmsInfo.avgTempValid = payload[7] & 0x01;
+    const BmsDecoder::pack_t &pack = decoder->pack();
+    cell_snapshot_t snapshot;
+    snapshot.timestamp = QDateTime::currentMSecsSinceEpoch();
+    //Channels which were not received in this period are cleared to 0 but keep their last validity
+    for (int stack = 0; stack < bms_topology_t::stacks; stack++) {
+        for (int cell = 0; cell < bms_topology_t::cellsPerStack; cell++) {
+            int i = stack * bms_topology_t::cellsPerStack + cell;
+            bool valid = (pack.cellVoltageValidity[stack][cell + 1] == BmsDecoder::NOERROR) && (pack.cellVoltages[stack][cell] != 0);
+            snapshot.voltage[i] = pack.cellVoltages[stack][cell] * 0.001f;
+            snapshot.voltageValid[i] = valid ? 1.0f : 0.0f;
+        }
+        for (int sensor = 0; sensor < bms_topology_t::sensorsPerStack; sensor++) {
+            int i = stack * bms_topology_t::sensorsPerStack + sensor;
+            bool valid = (pack.temperatureValidity[stack][sensor] == BmsDecoder::NOERROR) && (pack.temperatures[stack][sensor] != 0.0f);
+            snapshot.temperature[i] = pack.temperatures[stack][sensor];
+            snapshot.temperatureValid[i] = valid ? 1.0f : 0.0f;
+        }
+    }
+    emit cell_snapshot(snapshot);
 }
 
-void MainWindow::decompose_balance(QCanBusFrame &frame)
+void MainWindow::show_statistics(cell_statistics_t result)
 {
-    quint8 index = (quint8)frame.payload().at(0);
-
-    balanceStatus[index][4]  = (frame.payload().at(1) >> 0) & 0x01;
-    balanceStatus[index][5]  = (frame.payload().at(1) >> 1) & 0x01;
-    balanceStatus[index][6]  = (frame.payload().at(1) >> 2) & 0x01;
-    balanceStatus[index][7]  = (frame.payload().at(1) >> 3) & 0x01;
-    balanceStatus[index][8]  = (frame.payload().at(1) >> 4) & 0x01;
-    balanceStatus[index][9]  = (frame.payload().at(1) >> 5) & 0x01;
-    balanceStatus[index][10]  = (frame.payload().at(1) >> 6) & 0x01;
-    balanceStatus[index][11]  = (frame.payload().at(1) >> 7) & 0x01;
-    balanceStatus[index][0]  = (frame.payload().at(2) >> 4) & 0x01;
-    balanceStatus[index][1]  = (frame.payload().at(2) >> 5) & 0x01;
-    balanceStatus[index][2] = (frame.payload().at(2) >> 6) & 0x01;
-    balanceStatus[index][3] = (frame.payload().at(2) >> 7) & 0x01;
-    update_ui_balancing();
-
-//    quint64 gates = 0ULL;
-//    gates |= ((quint64)(frame.payload().at(1) & 0xFF) << 40) | ((quint64)(frame.payload().at(2) & 0xFF) << 32) | ((quint64)(frame.payload().at(3) & 0xFF) << 24)
-//            | ((quint64)(frame.payload().at(4) & 0xFF) << 16) | ((quint64)(frame.payload().at(5) & 0xFF) << 8) | ((quint64)(frame.payload().at(6) & 0xFF));
-
-//    for (size_t i = 0; i < 12; i++) {
+    const channel_statistics_t &volts = result.voltage;
+    if (volts.count == 0) {
+        statisticsLabel->clear();
+        return;
+    }
 
-//        balanceStatus[3 * frame.payload().at(0)][]
-//    }
+    auto cell_name = [](quint16 channel) {
+        return QString("S%1C%2").arg(channel / bms_topology_t::cellsPerStack + 1).arg(channel % bms_topology_t::cellsPerStack + 1);
+    };
 
-//    switch (frame.payload().at(0)) {
-//    case 0:
-//        for (size_t i = 0; i < 6; i++) { //Message/byte
-//            for (size_t j = 0; j < 8; j++) { //bit
-//                balanceStatus[0][]
-//            }
-//        }
+    QString text = QString("Median: %1 V | Std. dev.: %2 mV").arg(volts.median, 5, 'f', 3).arg(volts.stddev * 1000.0f, 0, 'f', 1);
 
-//        break;
-//    case 1:
-//        ::mempcpy(&balanceStatus[4][0], &gates, 6);
-//        break;
-//    case 2:
-//        ::mempcpy(&balanceStatus[8][0], &gates, 6);
-//        break;
-//    }
-//    qDebug() << balanceStatus[0][2];
-}
+    QStringList weakCells;
+    for (quint16 channel : volts.outliers) {
+        weakCells.append(QString("%1 (%2σ)").arg(cell_name(channel)).arg(volts.zscore.at(channel), 0, 'f', 1));
+    }
+    if (!weakCells.isEmpty()) {
+        text.append(" | Outliers: " + weakCells.join(", "));
+    }
+    text.append(QString(" | Max. drift: %1 (%2 mV)").arg(cell_name(volts.maxDriftChannel))
+                .arg(volts.drift.at(volts.maxDriftChannel) * 1000.0f, 0, 'f', 1));
 
-QString MainWindow::ts_state_to_string(ts_state_t state)
-{
-    switch (state) {
-    case TS_STATE_STANDBY:
-        return "Standby";
-    case TS_STATE_PRE_CHARGING:
-        return "Pre-charging";
-    case TS_STATE_OPERATE:
-        return "Operate";
-    case TS_STATE_ERROR:
-        return "Error";
-    }
-}
-
-QString MainWindow::returnValidity(quint8 val)
-{
-    switch (val) {
-    case NOERROR:
-        return "OK";
-    case PECERROR:
-        return "PEC error";
-    case VALUEOUTOFRANGE:
-        return "Value out of range";
-    case OPENCELLWIRE:
-        return "Open wire";
-    default:
-        return "Unknown error";
+    if (result.temperature.count > 0) {
+        text.append(QString(" | Median temp.: %1 °C").arg(result.temperature.median, 0, 'f', 1));
     }
+    statisticsLabel->setText(text);
 }
 
 
@@ -418,28 +506,107 @@ void MainWindow::setUID(QVector<quint32> uid)
 
 
 void MainWindow::updateCellVoltagePeriodic()
+{
+    //Restyling is expensive, only do it on changes
+    static bool lastLinkAvailable = false;
+    bool linkAvailable = decoder->take_link_available();
+    if (linkAvailable != lastLinkAvailable) {
+        eventLog->log(EventLog::SOURCE_LINK, linkAvailable);
+        if (linkAvailable) {
+            ui->linkDisplay->setStyleSheet("background-color: rgb(0, 255, 0);");
+        } else {
+            ui->linkDisplay->setStyleSheet("background-color: rgb(255, 0, 0);");
+        }
+    }
+    lastLinkAvailable = linkAvailable;
+
+    balancing->publish();
+    publisher->publish();
+    publish_snapshot();
+    renderScheduler->render();
+
+    decoder->clear_measurements();
+
+}
+
+//The form holds the rows and columns of the SPR21e pack, they are fitted to the topology of the build
+void MainWindow::setup_tree()
+{
+    //Cells start after the stack validity in column 2, sensors in column 1
+    int columns = qMax(bms_topology_t::cellsPerStack + 2, bms_topology_t::sensorsPerStack + 1);
+    QStringList labels("Parameter");
+    for (int column = 1; column < columns; column++) {
+        labels.append(QString("Value %1").arg(column - 1));
+    }
+    ui->parameters->setColumnCount(columns);
+    ui->parameters->setHeaderLabels(labels);
+
+    for (int top = 0; top < ui->parameters->topLevelItemCount(); top++) {
+        QTreeWidgetItem *item = ui->parameters->topLevelItem(top);
+        while (item->childCount() > bms_topology_t::stacks) {
+            delete item->takeChild(item->childCount() - 1);
+        }
+        while (item->childCount() < bms_topology_t::stacks) {
+            item->addChild(new QTreeWidgetItem(QStringList(QString("Stack %1").arg(item->childCount() + 1))));
+        }
+    }
+}
+
+void MainWindow::update_tree()
 {
     QTreeWidgetItem *volts = ui->parameters->topLevelItem(1); // Voltages
     QTreeWidgetItem *temps = ui->parameters->topLevelItem(3); //Temperatures
     QTreeWidgetItem *uids = ui->parameters->topLevelItem(0); //UIDs
     QTreeWidgetItem *cellVoltValid = ui->parameters->topLevelItem(2); //Open Wires
+    const BmsDecoder::pack_t &pack = decoder->pack();
 
-    for (quint16 stack = 0; stack < 12; stack++) {
-        for (quint16 cell = 0; cell < 12; cell++) {
-            volts->child(stack)->setText(cell+2, QString::number(cellVoltages[stack][cell]*0.001f, 'f', 3));
-            cellVoltValid->child(stack)->setText(cell+2, returnValidity(cellVoltageValidity[stack][cell+1]));
+    for (quint16 stack = 0; stack < bms_topology_t::stacks; stack++) {
+        for (quint16 cell = 0; cell < bms_topology_t::cellsPerStack; cell++) {
+            volts->child(stack)->setText(cell+2, QString::number(pack.cellVoltages[stack][cell]*0.001f, 'f', 3));
+            cellVoltValid->child(stack)->setText(cell+2, BmsDecoder::returnValidity(pack.cellVoltageValidity[stack][cell+1]));
         }
-        cellVoltValid->child(stack)->setText(1, returnValidity(cellVoltageValidity[stack][0]));
+        cellVoltValid->child(stack)->setText(1, BmsDecoder::returnValidity(pack.cellVoltageValidity[stack][0]));
 
-        for (quint16 tempsens = 0; tempsens < 14; tempsens++) {
-            if (temperatureValidity[stack][tempsens] == NOERROR){
-                temps->child(stack)->setText(tempsens+1, QString::number(temperatures[stack][tempsens], 'f', 1));
+        for (quint16 tempsens = 0; tempsens < bms_topology_t::sensorsPerStack; tempsens++) {
+            if (pack.temperatureValidity[stack][tempsens] == BmsDecoder::NOERROR){
+                temps->child(stack)->setText(tempsens+1, QString::number(pack.temperatures[stack][tempsens], 'f', 1));
             } else {
-                temps->child(stack)->setText(tempsens+1, returnValidity(temperatureValidity[stack][tempsens]));
+                temps->child(stack)->setText(tempsens+1, BmsDecoder::returnValidity(pack.temperatureValidity[stack][tempsens]));
             }
         }
 
-        uids->child(stack)->setText(1, QString::number(uid[stack], 16).toUpper());
+        uids->child(stack)->setText(1, QString::number(pack.uid[stack], 16).toUpper());
+    }
+}
+
+void MainWindow::update_heatmap()
+{
+    const BmsDecoder::pack_t &pack = decoder->pack();
+    ui->heatmap->set_cell_voltages(pack.cellVoltages, pack.cellVoltageValidity);
+    ui->heatmap->set_temperatures(pack.temperatures, pack.temperatureValidity);
+}
+
+void MainWindow::update_info()
+{
+    eventLog->flush();
+    const BmsDecoder::bms_info_t &bmsInfo = decoder->info();
+
+    DiagEngine::latency_t latency = diag->latency();
+    if (latency.count) {
+        diagLabel->setText(QString("Diag RTT: %1 ms").arg(latency.last / 1000.0, 0, 'f', 1));
+        diagLabel->setToolTip(QString("Mean %1 ms, min %2 ms, max %3 ms\n%4 responses, %5 timeouts, %6 failed")
+                              .arg(latency.mean / 1000.0, 0, 'f', 2).arg(latency.min / 1000.0, 0, 'f', 2)
+                              .arg(latency.max / 1000.0, 0, 'f', 2).arg(latency.count)
+                              .arg(latency.timeouts).arg(latency.failures));
+    }
+
+    CyclicSender::period_t period = can->cyclic_sender()->period(0);
+    if (ui->reqTsActive->isChecked() && period.count) {
+        ui->reqTsActive->setToolTip(QString("Sent by %1\nPeriod %2 ms, min %3 ms, max %4 ms, jitter %5 ms")
+                                    .arg(can->cyclic_sender()->uses_kernel() ? "the kernel" : "a thread")
+                                    .arg(period.mean / 1000.0, 0, 'f', 2).arg(period.min / 1000.0, 0, 'f', 2)
+                                    .arg(period.max / 1000.0, 0, 'f', 2)
+                                    .arg((period.max - period.min) / 1000.0, 0, 'f', 2));
     }
 
     if (bmsInfo.minCellVoltValid) {
@@ -521,7 +688,7 @@ void MainWindow::updateCellVoltagePeriodic()
         ui->isoRes->setText("Invalid");
     }
 
-    ui->tsState->setText(ts_state_to_string(bmsInfo.tsState));
+    ui->tsState->setText(BmsDecoder::ts_state_to_string(bmsInfo.tsState));
 
     if (bmsInfo.imdStatus) {
         ui->imdStatus->setText("OK");
@@ -552,41 +719,16 @@ void MainWindow::updateCellVoltagePeriodic()
     } else {
         ui->scStatus->setText("Error");
     }
-
-    static error_code_t lastError = ERROR_NO_ERROR;
-
-
-    QDateTime dateTime = QDateTime::currentDateTime();
-    if (bmsInfo.error != lastError) {
-        if (bmsInfo.error == ERROR_NO_ERROR) {
-            ui->errorLog->append("[" + dateTime.date().toString("dd.MM.yyyy") + " " + dateTime.time().toString("hh:mm:ss") + "] [INFO]: " + error_to_string(bmsInfo.error));
-        } else {
-            ui->errorLog->append("[" + dateTime.date().toString("dd.MM.yyyy") + " " + dateTime.time().toString("hh:mm:ss") + "] [ERROR]: " + error_to_string(bmsInfo.error));
-        }
-    }
-    lastError = bmsInfo.error;
-
-
-    if (linkAvailable) {
-        ui->linkDisplay->setStyleSheet("background-color: rgb(0, 255, 0);");
-    } else {
-        ui->linkDisplay->setStyleSheet("background-color: rgb(255, 0, 0);");
-    }
-    linkAvailable = false;
-
-
-    ::memset(cellVoltages, 0, 144);
-    ::memset(temperatures, 0, 12*14);
-
-    //poll_balance_status();
-
 }
 
 void MainWindow::on_btnConnectPcan_clicked()
 {
     if (!interfaceUp) {
         can->set_device_name(ui->cbSelectPCAN->currentText());
+        can->set_link_config(ui->cbBitrate->currentData().toUInt(), qRound(ui->sbSamplePoint->value() * 10.0),
+                             ui->cbDataBitrate->currentData().toUInt());
         can->connect_device();
+        recorder->set_device_name(ui->cbSelectPCAN->currentText());
 
 
     } else {
@@ -602,19 +744,21 @@ void MainWindow::on_reqTsActive_stateChanged(int arg1)
     QByteArray payload;
     frame.setFrameId(0);
     if (arg1 == 0) {
-        sendTimer->stop();
+        can->stop_cyclic(0);
         payload.append((quint8)0);
         frame.setPayload(payload);
         can->send_frame(frame);
     } else {
-        sendTimer->start();
+        payload.append(0xFF);
+        frame.setPayload(payload);
+        can->start_cyclic(frame, tsRequestPeriod);
     }
 }
 
 
 void MainWindow::on_clearErrorLog_clicked()
 {
-    ui->errorLog->clear();
+    eventLog->clear();
 }
 
 
@@ -627,6 +771,82 @@ void MainWindow::on_diagButton_clicked()
 }
 
 
+void MainWindow::on_actionServe_telemetry_toggled(bool checked)
+{
+    if (!checked) {
+        streamServer->close();
+        return;
+    }
+    bool ok;
+    int port = QInputDialog::getInt(this, "Serve telemetry", "TCP port:", streamDefaultPort, 1, 65535, 1, &ok);
+    if (!ok) {
+        ui->actionServe_telemetry->setChecked(false);
+        return;
+    }
+    if (!streamServer->listen(port)) {
+        QMessageBox mb;
+        mb.setText("Cannot serve telemetry: " + streamServer->errorString());
+        mb.exec();
+        ui->actionServe_telemetry->setChecked(false);
+        return;
+    }
+    ui->statusbar->showMessage(QString("Serving telemetry on port %1").arg(port));
+}
+
+
+void MainWindow::on_actionConnect_to_remote_toggled(bool checked)
+{
+    if (!checked) {
+        streamClient->disconnect_from();
+        return;
+    }
+    if (interfaceUp) {
+        QMessageBox mb;
+        mb.setText("Disconnect the local CAN interface first.");
+        mb.exec();
+        ui->actionConnect_to_remote->setChecked(false);
+        return;
+    }
+    bool ok;
+    QString address = QInputDialog::getText(this, "Connect to remote", "Host[:port]:", QLineEdit::Normal,
+                                            "localhost", &ok);
+    if (!ok || address.trimmed().isEmpty()) {
+        ui->actionConnect_to_remote->setChecked(false);
+        return;
+    }
+    QStringList parts = address.trimmed().split(':');
+    quint16 port = (parts.size() > 1) ? parts.at(1).toUShort() : streamDefaultPort;
+    streamClient->connect_to(parts.at(0), port ? port : streamDefaultPort);
+    ui->statusbar->showMessage("Connecting to " + parts.at(0));
+}
+
+
+void MainWindow::on_actionRecord_session_toggled(bool checked)
+{
+    if (!checked) {
+        sessionLogger->stop();
+        ui->statusbar->showMessage(QString("Session recorded, %1 records, %2 dropped")
+                                   .arg(sessionLogger->records()).arg(sessionLogger->dropped_records()));
+        return;
+    }
+    QString path = QDir(QDir::homePath()).filePath(QDateTime::currentDateTime().toString("'session-'yyyyMMdd-hhmmss'.log'"));
+    QString fileName = QFileDialog::getSaveFileName(this, "Record session", path,
+                                                    "Logfiles (*.log);;Binary logfiles (*.bin)");
+    if (fileName.isEmpty()) {
+        ui->actionRecord_session->setChecked(false);
+        return;
+    }
+    bool ok;
+    int interval = QInputDialog::getInt(this, "Record session", "Interval between records (ms):", 100, 10, 60000, 10, &ok);
+    if (!ok) {
+        ui->actionRecord_session->setChecked(false);
+        return;
+    }
+    sessionLogger->start(fileName, SessionLogger::format_for(fileName), interval);
+    ui->statusbar->showMessage("Recording session to " + fileName);
+}
+
+
 void MainWindow::on_actionLogfile_converter_triggered()
 {
     LogfileConverter *logfileConverter = new LogfileConverter();
@@ -648,3 +868,35 @@ void MainWindow::on_actionDiagnostic_triggered()
     on_diagButton_clicked();
 }
 
+
+void MainWindow::on_errorLogFilter_currentIndexChanged(int index)
+{
+    eventLog->set_filter(ui->errorLogFilter->itemData(index).toUInt());
+}
+
+
+void MainWindow::on_exportErrorLog_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Export event log", QDir::homePath(), "CSV files (*.csv)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    eventLog->flush();
+    if (!eventLog->export_csv(fileName)) {
+        QMessageBox mb;
+        mb.setText("Cannot open output file!");
+        mb.exec();
+    }
+}
+
+
+void MainWindow::on_plotWindow_currentIndexChanged(int index)
+{
+    qint64 window = ui->plotWindow->itemData(index).toLongLong() * 1000;
+    ui->plotCurrent->set_window(window);
+    ui->plotVoltage->set_window(window);
+    ui->plotCellVoltage->set_window(window);
+    ui->plotTemperature->set_window(window);
+    ui->plotSoc->set_window(window);
+}
+
@@ -15,6 +15,25 @@
 #include "diagdialog.h"
 #include "logfileconverter.h"
 #include "aboutdialog.h"
+#include "timeseriesstore.h"
+#include "renderscheduler.h"
+#include "eventlog.h"
+#include "balancing.h"
+#include "diagengine.h"
+#include "cellstatistics.h"
+#include "bmsdecoder.h"
+#include "bmshistory.h"
+#include "packpublisher.h"
+#include "streamserver.h"
+#include "streamclient.h"
+#include "flightrecorder.h"
+#include "sessionlogger.h"
+#include <QThread>
+#include <QLabel>
+#include <QFileDialog>
+#include <QScrollBar>
+#include <QInputDialog>
+#include <QStandardPaths>
 
 
 QT_BEGIN_NAMESPACE
@@ -44,131 +63,85 @@ private slots:
 
     void on_actionDiagnostic_triggered();
 
-private:
-    enum LTCError_t{
-        NOERROR         = 0x0, //!< NOERROR
-        PECERROR        = 0x1, //!< PECERROR
-        VALUEOUTOFRANGE = 0x2, //!< VALUEOUTOFRANGE
-        OPENCELLWIRE    = 0x3, //!< OPENCELLWIRE
-    };
-
-    enum canIds {
-        ID_BMS_INFO_1  = 0x1,
-        ID_BMS_INFO_2  = 0x2,
-        ID_BMS_INFO_3  = 0x3,
-        ID_CELL_TEMP_1 = 0x4,
-        ID_CELL_TEMP_2 = 0x5,
-        ID_CELL_TEMP_3 = 0x6,
-        ID_CELL_VOLT_1 = 0x7,
-        ID_CELL_VOLT_2 = 0x8,
-        ID_CELL_VOLT_3 = 0x9,
-        ID_CELL_VOLT_4 = 0xA,
-        ID_UID         = 0xB,
-        ID_DIAG_REQUEST = 0xC,
-        ID_DIAG_RESPONSE = 0xD
-    };
-
-    enum ts_state_t {
-        TS_STATE_STANDBY,
-        TS_STATE_PRE_CHARGING,
-        TS_STATE_OPERATE,
-        TS_STATE_ERROR
-    };
-
-    enum error_code_t {
-        ERROR_NO_ERROR,
-        ERROR_SYSTEM_NOT_HEALTHY,
-        ERROR_CONTACTOR_IMPLAUSIBLE,
-        ERROR_PRE_CHARGE_TOO_SHORT,
-        ERROR_PRE_CHARGE_TIMEOUT
-    };
-
-    struct bms_info_t {
-        float minCellVolt;
-        bool minCellVoltValid;
-        float maxCellVolt;
-        bool maxCellVoltValid;
-        float avgCellVolt;
-        bool avgCellVoltValid;
-        float minSoc;
-        bool minSocValid;
-        float maxSoc;
-        bool maxSocValid;
-        float batteryVoltage;
-        bool batteryVoltageValid;
-        float dcLinkVoltage;
-        bool dcLinkVoltageValid;
-        float current;
-        bool currentValid;
-        float isoRes;
-        bool isoResValid;
-        bool imdStatus;
-        bool imdScStatus;
-        bool amsStatus;
-        bool amsScStatus;
-        ts_state_t tsState;
-        bool shutdownStatus;
-        error_code_t error;
-        float minTemp;
-        bool minTempValid;
-        float maxTemp;
-        bool maxTempValid;
-        float avgTemp;
-        bool avgTempValid;
-    };
+    void on_plotWindow_currentIndexChanged(int index);
+
+    void on_errorLogFilter_currentIndexChanged(int index);
+
+    void on_exportErrorLog_clicked();
+
+    void on_actionServe_telemetry_toggled(bool checked);
+
+    void on_actionConnect_to_remote_toggled(bool checked);
 
+    void on_actionRecord_session_toggled(bool checked);
+
+private:
     QTimer *updateTimer = nullptr;
     Ui::MainWindow *ui;
 
-    void decomposeCellVoltage(quint8 stack, quint8 cellOffset, QByteArray payload);
-    void decomposeCellTemperatures(quint8 stack, quint8 offset, QByteArray payload);
-    void decomposeUid(quint8 stack, QByteArray payload);
-    void decompose_bms_1(QByteArray payload);
-    void decompose_bms_2(QByteArray payload);
-    void decompose_bms_3(QByteArray payload);
-    void decompose_balance(QCanBusFrame &frame);
-    QString ts_state_to_string(ts_state_t state);
-    QString returnValidity(quint8 val);
-
-    quint16 cellVoltages[12][12];
-    quint8 cellVoltageValidity[12][13];
-    float temperatures[12][14];
-    quint8 temperatureValidity[12][14];
-    quint32 uid[12];
-    bool balanceStatus[12][12];
+    BmsDecoder *decoder = nullptr;
+    PackPublisher *publisher = nullptr;
+    bool balanceStatus[bms_topology_t::stacks][bms_topology_t::cellsPerStack];
 
     void setUID(QVector<quint32> uid);
 
     void updateCellVoltagePeriodic();
-    void calculateMedian(quint16 cellVoltages[12][12], double *cellVoltageAvg);
+    void setup_tree();
+    void update_tree();
+    void update_heatmap();
+    void update_info();
+    RenderScheduler *renderScheduler = nullptr;
+
+    EventLog *eventLog = nullptr;
+    void setup_event_log();
+
+    QThread *statisticsThread = nullptr;
+    CellStatistics *statistics = nullptr;
+    QLabel *statisticsLabel = nullptr;
+    void setup_statistics();
+    void publish_snapshot();
+    void show_statistics(cell_statistics_t result);
+
+    QLabel *linkHealthLabel = nullptr;
+    void setup_link_monitor();
 
     bool interfaceUp;
 
-    void new_frame(QCanBusFrame frame);
+    StreamServer *streamServer = nullptr;
+    StreamClient *streamClient = nullptr;
+    void setup_streaming();
 
-    Can *can = nullptr;
+    FlightRecorder *recorder = nullptr;
+    void setup_flight_recorder();
 
-    bms_info_t bmsInfo;
+    SessionLogger *sessionLogger = nullptr;
+    void set_remote_ui(bool remote);
 
-    QTimer *sendTimer = nullptr;
-    void send_ts_req();
+    void new_frame(QCanBusFrame frame);
 
-    QString error_to_string(error_code_t error);
+    Can *can = nullptr;
 
-    bool linkAvailable;
+    static const int tsRequestPeriod = 100; //ms
 
-    void poll_balance_status();
+    Balancing *balancing = nullptr;
+    DiagEngine *diag = nullptr;
+    QLabel *diagLabel = nullptr;
     void handle_diag_response(QCanBusFrame &frame);
-    void update_ui_balancing();
+    void update_ui_balancing(QVector<quint16> cells);
 
     void global_balancing_enable(bool enable);
 
     void closeEvent(QCloseEvent *event);
 
+    void setup_plots();
+    void append_plot_samples(quint32 frameId);
+
+    BmsHistory *history = nullptr;
+
     bool darkMode;
 
 signals:
-
+    void cell_snapshot(cell_snapshot_t snapshot);
 
 };
 #endif // MAINWINDOW_H
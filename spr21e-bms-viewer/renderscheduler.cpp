@@ -0,0 +1,28 @@
+#include "renderscheduler.h"
+
+RenderScheduler::RenderScheduler(QWidget *window, QObject *parent) : QObject(parent)
+{
+    this->window = window;
+}
+
+void RenderScheduler::add_view(QWidget *view, std::function<void()> render)
+{
+    views.append({view, render});
+}
+
+void RenderScheduler::render()
+{
+    for (view_t &view : views) {
+        if (is_visible(view.widget)) {
+            view.render();
+        }
+    }
+}
+
+bool RenderScheduler::is_visible(const QWidget *widget) const
+{
+    if (window->isMinimized() || !widget->isVisible()) {
+        return false;
+    }
+    return !widget->visibleRegion().isEmpty();
+}
@@ -0,0 +1,35 @@
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QObject>
+#include <QWidget>
+#include <QVector>
+#include <functional>
+
+//Renders registered views only while they are visible on screen.
+//Hidden views are skipped and catch up on the first tick after they are shown again.
+//They are not rendered when they are shown, the measurements have been cleared after the last tick.
+//Nothing is rendered while the window is minimized.
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RenderScheduler(QWidget *window, QObject *parent = nullptr);
+
+    void add_view(QWidget *view, std::function<void()> render);
+    //Call once per tick, before the measurements are cleared
+    void render();
+
+private:
+    struct view_t {
+        QWidget *widget;
+        std::function<void()> render;
+    };
+
+    QWidget *window = nullptr;
+    QVector<view_t> views;
+
+    bool is_visible(const QWidget *widget) const;
+};
+
+#endif // RENDERSCHEDULER_H
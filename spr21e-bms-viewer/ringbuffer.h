@@ -0,0 +1,63 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QVector>
+
+//Fixed capacity ring buffer. Once full, the oldest element is overwritten.
+//Index 0 always refers to the oldest element.
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity = 0) : buffer(capacity), head(0), count(0) {}
+
+    void push(const T &value)
+    {
+        if (buffer.isEmpty()) {
+            return;
+        }
+        buffer[head] = value;
+        head = (head + 1) % buffer.size();
+        if (count < buffer.size()) {
+            count++;
+        }
+    }
+
+    const T &at(int index) const
+    {
+        return buffer.at((head - count + index + buffer.size()) % buffer.size());
+    }
+
+    const T &last() const
+    {
+        return at(count - 1);
+    }
+
+    int size() const
+    {
+        return count;
+    }
+
+    int capacity() const
+    {
+        return buffer.size();
+    }
+
+    bool isEmpty() const
+    {
+        return count == 0;
+    }
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+private:
+    QVector<T> buffer;
+    int head;
+    int count;
+};
+
+#endif // RINGBUFFER_H
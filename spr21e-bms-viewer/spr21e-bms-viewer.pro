@@ -1,4 +1,4 @@
-QT       += core gui serialbus network
+QT       += core gui serialbus network sql
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -15,20 +15,31 @@ DEFINES += "VERS_MAJOR=\"$$MAJOR\"" "VERS_MINOR=\"$$MINOR\"" "VERS_BUILD=\"\\\"$
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(../bmscore/bmscore.pri)
+
 SOURCES += \
     aboutdialog.cpp \
-    can.cpp \
     diagdialog.cpp \
+    heatmapwidget.cpp \
     logfileconverter.cpp \
+    logfollower.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    renderscheduler.cpp \
+    sqliteexporter.cpp \
+    stripchart.cpp
 
 HEADERS += \
     aboutdialog.h \
-    can.h \
     diagdialog.h \
+    heatmapwidget.h \
     logfileconverter.h \
-    mainwindow.h
+    logfollower.h \
+    mainwindow.h \
+    renderscheduler.h \
+    ringbuffer.h \
+    sqliteexporter.h \
+    stripchart.h
 
 FORMS += \
     aboutdialog.ui \
@@ -0,0 +1,173 @@
+#include "sqliteexporter.h"
+#include <QDateTime>
+#include <QFile>
+#include <QSqlError>
+#include <QStringList>
+
+SqliteExporter::SqliteExporter()
+{
+    connectionName = QString("sqliteexporter-%1").arg((quintptr)this);
+}
+
+SqliteExporter::~SqliteExporter()
+{
+    close();
+}
+
+bool SqliteExporter::open(QString fileName, int cells, int sensors)
+{
+    close();
+    QFile::remove(fileName);
+    QFile::remove(fileName + "-wal");
+    QFile::remove(fileName + "-shm");
+
+    database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    database.setDatabaseName(fileName);
+    if (!database.open()) {
+        lastError = database.lastError().text();
+        return false;
+    }
+
+    //Nothing is lost on a crash which the import could not simply repeat
+    if (!exec("PRAGMA journal_mode = WAL") || !exec("PRAGMA synchronous = OFF")
+            || !exec("PRAGMA temp_store = MEMORY") || !exec("PRAGMA cache_size = -65536")) {
+        return false;
+    }
+    if (!exec("CREATE TABLE pack (sample INTEGER PRIMARY KEY, time INTEGER, current REAL, battery_voltage REAL, "
+              "dc_link_voltage REAL, min_cell_voltage REAL, max_cell_voltage REAL, avg_cell_voltage REAL, "
+              "min_temperature REAL, max_temperature REAL, avg_temperature REAL, state INTEGER, error INTEGER, "
+              "min_soc REAL, max_soc REAL)")
+            || !exec("CREATE TABLE cells (sample INTEGER NOT NULL, channel INTEGER NOT NULL, voltage REAL)")
+            || !exec("CREATE TABLE temperatures (sample INTEGER NOT NULL, channel INTEGER NOT NULL, temperature REAL)")) {
+        return false;
+    }
+
+    //One statement per record and table, a long format row is 3 bound values
+    auto rows = [](int count) {
+        QStringList values;
+        for (int i = 0; i < count; i++) {
+            values.append("(?, ?, ?)");
+        }
+        return values.join(", ");
+    };
+    packQuery = QSqlQuery(database);
+    cellQuery = QSqlQuery(database);
+    temperatureQuery = QSqlQuery(database);
+    if (!packQuery.prepare("INSERT INTO pack VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)")) {
+        return fail(packQuery);
+    }
+    if (!cellQuery.prepare("INSERT INTO cells VALUES " + rows(cells))) {
+        return fail(cellQuery);
+    }
+    if (!temperatureQuery.prepare("INSERT INTO temperatures VALUES " + rows(sensors))) {
+        return fail(temperatureQuery);
+    }
+
+    sample = 0;
+    if (!database.transaction()) {
+        lastError = database.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+template <class Topology>
+bool SqliteExporter::append(const logging_record_t<Topology> &data)
+{
+    QDateTime time(QDate(data.timestamp.year, data.timestamp.month, data.timestamp.day),
+                   QTime(data.timestamp.hour, data.timestamp.minute, data.timestamp.second));
+
+    packQuery.addBindValue(sample);
+    packQuery.addBindValue(time.isValid() ? QVariant(time.toSecsSinceEpoch()) : QVariant());
+    packQuery.addBindValue(data.current);
+    packQuery.addBindValue(data.batteryVoltage);
+    packQuery.addBindValue(data.dcLinkVoltage);
+    packQuery.addBindValue(data.minCellVolt * 0.001);
+    packQuery.addBindValue(data.maxCellVolt * 0.001);
+    packQuery.addBindValue(data.avgCellVolt * 0.001);
+    packQuery.addBindValue(data.minTemperature * 0.1);
+    packQuery.addBindValue(data.maxTemperature * 0.1);
+    packQuery.addBindValue(data.avgTemperature * 0.1);
+    packQuery.addBindValue(data.stateMachineState);
+    packQuery.addBindValue(data.stateMachineError);
+    packQuery.addBindValue(data.minSoc * 0.1);
+    packQuery.addBindValue(data.maxSoc * 0.1);
+    if (!packQuery.exec()) {
+        return fail(packQuery);
+    }
+
+    for (int channel = 0; channel < Topology::cells; channel++) {
+        cellQuery.addBindValue(sample);
+        cellQuery.addBindValue(channel);
+        cellQuery.addBindValue(data.cellVoltage[channel / Topology::cellsPerStack][channel % Topology::cellsPerStack] * 0.001);
+    }
+    if (!cellQuery.exec()) {
+        return fail(cellQuery);
+    }
+
+    for (int channel = 0; channel < Topology::sensors; channel++) {
+        temperatureQuery.addBindValue(sample);
+        temperatureQuery.addBindValue(channel);
+        temperatureQuery.addBindValue(data.temperature[channel / Topology::sensorsPerStack][channel % Topology::sensorsPerStack] * 0.1);
+    }
+    if (!temperatureQuery.exec()) {
+        return fail(temperatureQuery);
+    }
+
+    if ((++sample % recordsPerTransaction) == 0) {
+        if (!database.commit() || !database.transaction()) {
+            lastError = database.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+//One instantiation per entry of log_topologies_t
+template bool SqliteExporter::append(const logging_record_t<spr21e_topology_t> &data);
+
+bool SqliteExporter::finish()
+{
+    if (!database.commit()) {
+        lastError = database.lastError().text();
+        return false;
+    }
+    //Building the indexes once is much faster than maintaining them during the import
+    bool ok = exec("CREATE INDEX pack_time ON pack (time)")
+            && exec("CREATE INDEX cells_channel ON cells (channel, sample)")
+            && exec("CREATE INDEX cells_sample ON cells (sample)")
+            && exec("CREATE INDEX temperatures_channel ON temperatures (channel, sample)")
+            && exec("CREATE INDEX temperatures_sample ON temperatures (sample)")
+            && exec("ANALYZE")
+            && exec("PRAGMA wal_checkpoint(TRUNCATE)");
+    close();
+    return ok;
+}
+
+bool SqliteExporter::exec(QString statement)
+{
+    QSqlQuery query(database);
+    if (!query.exec(statement)) {
+        return fail(query);
+    }
+    return true;
+}
+
+bool SqliteExporter::fail(const QSqlQuery &query)
+{
+    lastError = query.lastError().isValid() ? query.lastError().text() : database.lastError().text();
+    return false;
+}
+
+void SqliteExporter::close()
+{
+    if (!database.isValid()) {
+        return;
+    }
+    packQuery = QSqlQuery();
+    cellQuery = QSqlQuery();
+    temperatureQuery = QSqlQuery();
+    database.close();
+    database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
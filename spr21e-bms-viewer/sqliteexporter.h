@@ -0,0 +1,44 @@
+#ifndef SQLITEEXPORTER_H
+#define SQLITEEXPORTER_H
+
+#include <QString>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "loggingdata.h"
+
+//Loads BMU log records into an SQLite database.
+//pack holds one row per record with the pack values, cells and temperatures hold one row per
+//channel and record (channel = stack * cellsPerStack + cell, stack * sensorsPerStack + sensor), all keyed by the record number.
+//Rows are inserted by prepared statements in large transactions, the indexes are built after loading.
+class SqliteExporter
+{
+public:
+    SqliteExporter();
+    ~SqliteExporter();
+
+    //Replaces an existing database, the inserts are prepared for the channels of one topology
+    bool open(QString fileName, int cells, int sensors);
+    template <class Topology>
+    bool append(const logging_record_t<Topology> &data);
+    //Commits the rows and builds the indexes
+    bool finish();
+
+    QString error() const { return lastError; }
+
+private:
+    static const int recordsPerTransaction = 2000;
+
+    QString connectionName;
+    QSqlDatabase database;
+    QSqlQuery packQuery;
+    QSqlQuery cellQuery;
+    QSqlQuery temperatureQuery;
+    qint64 sample = 0;
+    QString lastError;
+
+    bool exec(QString statement);
+    bool fail(const QSqlQuery &query);
+    void close();
+};
+
+#endif // SQLITEEXPORTER_H
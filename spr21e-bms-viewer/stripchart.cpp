@@ -0,0 +1,297 @@
+#include "stripchart.h"
+
+DecimatingSeries::DecimatingSeries(int capacity, int numberOfLevels)
+{
+    for (int level = 0; level < numberOfLevels; level++) {
+        levels.append(RingBuffer<bucket_t>(capacity));
+    }
+    pending.resize(numberOfLevels);
+    pendingCount.fill(0, numberOfLevels);
+}
+
+void DecimatingSeries::append(qint64 timestamp, float value)
+{
+    bucket_t bucket = {timestamp, value, value};
+    levels[0].push(bucket);
+
+    //Propagate into the coarser levels
+    for (int level = 1; level < levels.size(); level++) {
+        bucket_t &acc = pending[level];
+        if (pendingCount.at(level) == 0) {
+            acc = bucket;
+        } else {
+            acc.min = qMin(acc.min, bucket.min);
+            acc.max = qMax(acc.max, bucket.max);
+        }
+        if (++pendingCount[level] < decimationFactor) {
+            break;
+        }
+        levels[level].push(acc);
+        bucket = acc;
+        pendingCount[level] = 0;
+    }
+}
+
+void DecimatingSeries::clear()
+{
+    for (int level = 0; level < levels.size(); level++) {
+        levels[level].clear();
+        pendingCount[level] = 0;
+    }
+}
+
+bool DecimatingSeries::isEmpty() const
+{
+    return levels.isEmpty() || levels.at(0).isEmpty();
+}
+
+float DecimatingSeries::last_value() const
+{
+    return levels.at(0).last().max;
+}
+
+QVector<DecimatingSeries::bucket_t> DecimatingSeries::query(qint64 from, qint64 to, int columns) const
+{
+    QVector<bucket_t> result;
+    if ((columns <= 0) || (to <= from) || isEmpty()) {
+        return result;
+    }
+
+    const qint64 span = to - from;
+    result.resize(columns);
+    for (int column = 0; column < columns; column++) {
+        result[column] = {from + column * span / columns, 1.0f, -1.0f};
+    }
+
+    auto fold = [&](const bucket_t &bucket) {
+        if ((bucket.start < from) || (bucket.start > to)) {
+            return;
+        }
+        int column = qMin(columns - 1, static_cast<int>((bucket.start - from) * columns / span));
+        bucket_t &target = result[column];
+        if (target.min > target.max) {
+            target.min = bucket.min;
+            target.max = bucket.max;
+        } else {
+            target.min = qMin(target.min, bucket.min);
+            target.max = qMax(target.max, bucket.max);
+        }
+    };
+
+    int level = select_level(from, to, columns);
+    const RingBuffer<bucket_t> &data = levels.at(level);
+    for (int i = lower_bound(data, from); i < data.size(); i++) {
+        fold(data.at(i));
+    }
+    //The newest samples are not yet aggregated into the selected level
+    for (int l = level; l > 0; l--) {
+        if (pendingCount.at(l) > 0) {
+            fold(pending.at(l));
+        }
+    }
+    return result;
+}
+
+int DecimatingSeries::lower_bound(const RingBuffer<bucket_t> &level, qint64 timestamp) const
+{
+    int first = 0;
+    int last = level.size();
+    while (first < last) {
+        int mid = first + (last - first) / 2;
+        if (level.at(mid).start < timestamp) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+int DecimatingSeries::select_level(qint64 from, qint64 to, int columns) const
+{
+    Q_UNUSED(to)
+    //Use the finest level which has at most two buckets per column
+    //and reaches back far enough to cover the requested window
+    int selected = 0;
+    for (int level = 0; level < levels.size(); level++) {
+        const RingBuffer<bucket_t> &current = levels.at(level);
+        if (current.isEmpty()) {
+            break;
+        }
+        selected = level;
+        bool tooDense = (current.size() - lower_bound(current, from)) > 2 * columns;
+        bool coarserReachesFurther = (level + 1 < levels.size())
+                && !levels.at(level + 1).isEmpty()
+                && (current.at(0).start > from)
+                && (levels.at(level + 1).at(0).start < current.at(0).start);
+        if (!tooDense && !coarserReachesFurther) {
+            break;
+        }
+    }
+    return selected;
+}
+
+StripChart::StripChart(QWidget *parent) : QWidget(parent)
+{
+    timeWindow = 60000;
+    setMinimumHeight(100);
+
+    repaintTimer = new QTimer(this);
+    repaintTimer->setInterval(33);
+    QObject::connect(repaintTimer, &QTimer::timeout, this, [=] {
+        if (!window()->isMinimized()) {
+            update();
+        }
+    });
+}
+
+int StripChart::add_series(QString name, QColor color)
+{
+    series.append({name, color, DecimatingSeries()});
+    return series.size() - 1;
+}
+
+void StripChart::append(int series, qint64 timestamp, float value)
+{
+    this->series[series].data.append(timestamp, value);
+}
+
+void StripChart::set_title(QString title)
+{
+    this->title = title;
+}
+
+void StripChart::set_unit(QString unit)
+{
+    this->unit = unit;
+}
+
+void StripChart::set_window(qint64 milliseconds)
+{
+    timeWindow = milliseconds;
+    update();
+}
+
+void StripChart::clear()
+{
+    for (series_t &s : series) {
+        s.data.clear();
+    }
+    update();
+}
+
+void StripChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter painter(this);
+    QFontMetrics fm = painter.fontMetrics();
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    QRect plot = rect().adjusted(fm.horizontalAdvance("-0000.00") + 8, fm.height() + 6, -8, -fm.height() - 6);
+    if ((plot.width() <= 0) || (plot.height() <= 0)) {
+        return;
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 from = now - timeWindow;
+
+    //Decimate every series to one min/max pair per pixel column
+    QVector<QVector<DecimatingSeries::bucket_t>> columns(series.size());
+    float yMin = 0.0f;
+    float yMax = 0.0f;
+    bool hasData = false;
+    for (int i = 0; i < series.size(); i++) {
+        columns[i] = series.at(i).data.query(from, now, plot.width());
+        for (const DecimatingSeries::bucket_t &bucket : qAsConst(columns.at(i))) {
+            if (bucket.min > bucket.max) {
+                continue;
+            }
+            if (!hasData) {
+                yMin = bucket.min;
+                yMax = bucket.max;
+                hasData = true;
+            } else {
+                yMin = qMin(yMin, bucket.min);
+                yMax = qMax(yMax, bucket.max);
+            }
+        }
+    }
+
+    float range = yMax - yMin;
+    if (range < 0.001f) {
+        range = qMax(qAbs(yMax) * 0.1f, 1.0f);
+        yMin -= range / 2;
+        yMax += range / 2;
+    } else {
+        yMin -= range * 0.05f;
+        yMax += range * 0.05f;
+    }
+    auto toY = [&](float value) {
+        return plot.bottom() - (value - yMin) / (yMax - yMin) * plot.height();
+    };
+
+    //Grid and axis labels
+    QColor gridColor = palette().color(QPalette::Mid);
+    painter.setPen(gridColor);
+    painter.drawRect(plot);
+    for (int i = 0; i <= 4; i++) {
+        float value = yMin + (yMax - yMin) * i / 4;
+        int y = static_cast<int>(toY(value));
+        painter.setPen(gridColor);
+        painter.drawLine(plot.left(), y, plot.right(), y);
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(QRect(0, y - fm.height() / 2, plot.left() - 4, fm.height()), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(value, 'f', 2));
+    }
+    QString windowText = timeWindow >= 60000 ? QString("-%1 min").arg(timeWindow / 60000) : QString("-%1 s").arg(timeWindow / 1000);
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()), Qt::AlignLeft, windowText);
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()), Qt::AlignRight, "now");
+
+    //Title with the latest value of every series
+    int x = plot.left();
+    painter.drawText(QPoint(x, fm.ascent() + 2), title);
+    x += fm.horizontalAdvance(title) + 16;
+    for (const series_t &s : qAsConst(series)) {
+        QString text = s.name;
+        if (!s.data.isEmpty()) {
+            text.append(QString(": %1 %2").arg(s.data.last_value(), 0, 'f', 2).arg(unit));
+        }
+        painter.setPen(s.color);
+        painter.drawText(QPoint(x, fm.ascent() + 2), text);
+        x += fm.horizontalAdvance(text) + 16;
+    }
+
+    if (!hasData) {
+        return;
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing, false);
+    painter.setClipRect(plot);
+    for (int i = 0; i < series.size(); i++) {
+        QPolygonF polyline;
+        polyline.reserve(2 * plot.width());
+        const QVector<DecimatingSeries::bucket_t> &data = columns.at(i);
+        for (int column = 0; column < data.size(); column++) {
+            if (data.at(column).min > data.at(column).max) {
+                continue;
+            }
+            qreal px = plot.left() + column;
+            polyline.append(QPointF(px, toY(data.at(column).max)));
+            polyline.append(QPointF(px, toY(data.at(column).min)));
+        }
+        painter.setPen(series.at(i).color);
+        painter.drawPolyline(polyline);
+    }
+}
+
+void StripChart::showEvent(QShowEvent *event)
+{
+    Q_UNUSED(event)
+    repaintTimer->start();
+}
+
+void StripChart::hideEvent(QHideEvent *event)
+{
+    Q_UNUSED(event)
+    repaintTimer->stop();
+}
@@ -0,0 +1,76 @@
+#ifndef STRIPCHART_H
+#define STRIPCHART_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QTimer>
+#include <QDateTime>
+#include <QVector>
+#include "ringbuffer.h"
+
+//Stores a signal at full rate and at several coarser min/max levels.
+//Each level aggregates decimationFactor buckets of the level below.
+class DecimatingSeries
+{
+public:
+    struct bucket_t {
+        qint64 start; //ms
+        float min;
+        float max;
+    };
+
+    explicit DecimatingSeries(int capacity = 16384, int numberOfLevels = 4);
+
+    void append(qint64 timestamp, float value);
+    void clear();
+    bool isEmpty() const;
+    float last_value() const;
+
+    //Folds the data between from and to into the given number of columns.
+    //Columns without data have min > max.
+    QVector<bucket_t> query(qint64 from, qint64 to, int columns) const;
+
+private:
+    static const int decimationFactor = 8;
+
+    QVector<RingBuffer<bucket_t>> levels;
+    QVector<bucket_t> pending;
+    QVector<int> pendingCount;
+
+    int lower_bound(const RingBuffer<bucket_t> &level, qint64 timestamp) const;
+    int select_level(qint64 from, qint64 to, int columns) const;
+};
+
+class StripChart : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit StripChart(QWidget *parent = nullptr);
+
+    int add_series(QString name, QColor color);
+    void append(int series, qint64 timestamp, float value);
+    void set_title(QString title);
+    void set_unit(QString unit);
+    void set_window(qint64 milliseconds);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    struct series_t {
+        QString name;
+        QColor color;
+        DecimatingSeries data;
+    };
+
+    QVector<series_t> series;
+    QString title;
+    QString unit;
+    qint64 timeWindow;
+    QTimer *repaintTimer = nullptr;
+};
+
+#endif // STRIPCHART_H
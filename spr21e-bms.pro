@@ -0,0 +1,31 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    bmscore \
+    bms-daemon \
+    bms-logmerge \
+    bms-viewer-helper \
+    spr21e-bms-viewer \
+    tst_bmsdecoder \
+    tst_packshm \
+    tst_streamprotocol \
+    tst_logfileconverter \
+    bench_bmsdecoder \
+    bench_sqliteexporter
+
+bms-daemon.depends = bmscore
+bms-logmerge.depends = bmscore
+spr21e-bms-viewer.depends = bmscore
+
+# Tests of the core library, run with make check
+tst_bmsdecoder.subdir = bmscore/tests/tst_bmsdecoder
+tst_bmsdecoder.depends = bmscore
+tst_packshm.subdir = bmscore/tests/tst_packshm
+tst_streamprotocol.subdir = bmscore/tests/tst_streamprotocol
+tst_streamprotocol.depends = bmscore
+tst_logfileconverter.subdir = bmscore/tests/tst_logfileconverter
+tst_logfileconverter.depends = bmscore
+bench_bmsdecoder.subdir = bmscore/tests/bench_bmsdecoder
+bench_bmsdecoder.depends = bmscore
+bench_sqliteexporter.subdir = bmscore/tests/bench_sqliteexporter
+bench_sqliteexporter.depends = bmscore